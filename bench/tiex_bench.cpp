@@ -0,0 +1,337 @@
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "tiex.h"
+#include "tiex_generate.h"
+#include "tiex_parser.h"
+#include "tiex_rule_index.h"
+
+namespace {
+
+//2018-02-08 14:06:56 UTC
+const std::time_t ReferencedTime = 1518098816;
+
+#define EXAMPLE_EXPRESSION \
+    "[0,*]{Future}" \
+    "[-1~min,0]{Just now}" \
+    "[-1~h,0]{%~min minute(s) ago}" \
+    "[-1.d,0]{%H:%M}" \
+    "[-2.d,0]{Yesterday %H:%M}" \
+    "[-1.y,0]{%m-%d %H:%M}" \
+    "[*,0]{%Y-%m-%d}"
+
+const char* const ExampleExpression = EXAMPLE_EXPRESSION;
+
+constexpr auto StaticExampleExpression = TIEX_EXPR(EXAMPLE_EXPRESSION);
+
+
+/**
+ Make an expression with the specified count of rules, of which only the
+ last one matches times earlier than the referenced time by more than an
+ hour.
+ */
+std::string MakeExpression(int rule_count) {
+
+    std::string expression;
+    for (int index = 1; index < rule_count; ++index) {
+        expression += "[-" + std::to_string(index) + "~min,-" + std::to_string(index - 1) + "~min]{" + std::to_string(index) + "}";
+    }
+    expression += "[*,*]{%~h hours ago}";
+    return expression;
+}
+
+
+tiex::Result ParseResult(const std::string& string) {
+
+    tiex::internal::Scanner<char> scanner(string.c_str(), string.length());
+    tiex::internal::Parser<char> parser(scanner);
+
+    tiex::Result result;
+    parser.ParseResult(result);
+    return result;
+}
+
+
+tiex::Locale MakeLocale() {
+
+    tiex::Locale locale;
+    locale.get_month = [](int month, const tiex::Locale::MonthOptions&) {
+        return "month " + std::to_string(month);
+    };
+    locale.get_weekday = [](int weekday, const tiex::Locale::WeekdayOptions&) {
+        return "weekday " + std::to_string(weekday);
+    };
+    locale.get_hour = [](int hour, const tiex::Locale::HourOptions&) {
+        return "hour " + std::to_string(hour);
+    };
+    locale.get_minute = [](int minute) {
+        return "minute " + std::to_string(minute);
+    };
+    return locale;
+}
+
+}
+
+
+static void BM_Create(benchmark::State& state) {
+
+    std::string expression = ExampleExpression;
+    for (auto _ : state) {
+        auto formatter = tiex::Formatter::Create(expression);
+        benchmark::DoNotOptimize(formatter);
+    }
+}
+BENCHMARK(BM_Create);
+
+
+static void BM_Format(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create(MakeExpression(static_cast<int>(state.range(0))));
+    auto formatted_time = ReferencedTime - 5 * 3600;
+
+    for (auto _ : state) {
+        auto text = formatter.Format(ReferencedTime, formatted_time);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK(BM_Format)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+
+/**
+ Format the example expression with the formatter of each kind, the
+ formatted time matches the third rule.
+ */
+template<typename Formatter>
+static void BM_FormatExample(benchmark::State& state, Formatter formatter) {
+
+    auto formatted_time = ReferencedTime - 50 * 60;
+
+    for (auto _ : state) {
+        auto text = formatter.Format(ReferencedTime, formatted_time);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK_CAPTURE(BM_FormatExample, Formatter, tiex::Formatter::Create(ExampleExpression));
+BENCHMARK_CAPTURE(BM_FormatExample, StaticFormatter, tiex::StaticFormatter(StaticExampleExpression));
+BENCHMARK_CAPTURE(BM_FormatExample, SpecializedFormatter, tiex::SpecializedFormatter<StaticExampleExpression>());
+
+
+static void BM_FormatShared(benchmark::State& state, bool has_result_cache) {
+
+    auto formatter = tiex::Formatter::Create("[-1~min,0]{Just now}[-1~h,0]{%~min minute(s) ago}");
+    if (has_result_cache) {
+        formatter = formatter.WithResultCache();
+    }
+
+    auto formatted_time = ReferencedTime - 50 * 60;
+
+    for (auto _ : state) {
+        auto text = formatter.FormatShared(ReferencedTime, formatted_time);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK_CAPTURE(BM_FormatShared, Uncached, false);
+BENCHMARK_CAPTURE(BM_FormatShared, Cached, true);
+
+
+static void BM_FormatView(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create(ExampleExpression);
+    auto formatted_time = ReferencedTime - 5;
+
+    std::string buffer;
+    for (auto _ : state) {
+        auto text = formatter.FormatView(ReferencedTime, formatted_time, buffer);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK(BM_FormatView);
+
+
+static void BM_BoundFormat(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create(MakeExpression(static_cast<int>(state.range(0))));
+    auto bound_formatter = formatter.Bind(ReferencedTime);
+    auto formatted_time = ReferencedTime - 5 * 3600;
+
+    for (auto _ : state) {
+        auto text = bound_formatter.Format(formatted_time);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK(BM_BoundFormat)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+
+static void BM_BuildRuleIndex(benchmark::State& state) {
+
+    std::vector<tiex::internal::ResolvedCondition> conditions;
+    for (int index = 1; index <= state.range(0); ++index) {
+        tiex::internal::ResolvedCondition condition;
+        condition.backward_time = ReferencedTime - index * 60;
+        condition.forward_time = ReferencedTime - (index - 1) * 60;
+        condition.is_valid = true;
+        conditions.push_back(condition);
+    }
+
+    for (auto _ : state) {
+        tiex::internal::RuleIndex rule_index(conditions);
+        benchmark::DoNotOptimize(rule_index);
+    }
+}
+BENCHMARK(BM_BuildRuleIndex)->Arg(4)->Arg(16)->Arg(64);
+
+
+static void BM_FormatBatch(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create(ExampleExpression);
+
+    std::vector<std::time_t> formatted_times;
+    for (std::int64_t index = 0; index < state.range(0); ++index) {
+        formatted_times.push_back(ReferencedTime - index * 97);
+    }
+
+    tiex::BatchResult batch_result;
+    for (auto _ : state) {
+        formatter.FormatBatch(ReferencedTime, formatted_times.data(), formatted_times.size(), batch_result);
+        benchmark::DoNotOptimize(batch_result.texts.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FormatBatch)->Arg(10000)->Arg(100000);
+
+
+static void BM_NextChangeTime(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create(ExampleExpression);
+    auto formatted_time = ReferencedTime - state.range(0);
+
+    for (auto _ : state) {
+        auto next_change_time = formatter.NextChangeTime(ReferencedTime, formatted_time);
+        benchmark::DoNotOptimize(next_change_time);
+    }
+}
+BENCHMARK(BM_NextChangeTime)->Arg(30)->Arg(3600)->Arg(3 * 86400)->Arg(400 * 86400);
+
+
+static void BM_RefreshScheduler(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create(ExampleExpression);
+
+    for (auto _ : state) {
+
+        tiex::RefreshScheduler scheduler(formatter, ReferencedTime);
+        for (std::int64_t index = 0; index < state.range(0); ++index) {
+            scheduler.Add(index, ReferencedTime - index * 97);
+        }
+
+        //Advance a whole day minute by minute.
+        std::vector<tiex::RefreshScheduler::Change> changes;
+        for (std::time_t current_time = ReferencedTime; current_time <= ReferencedTime + 86400; current_time += 60) {
+            scheduler.Advance(current_time, changes);
+        }
+        benchmark::DoNotOptimize(changes.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RefreshScheduler)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_GenerateResultText(benchmark::State& state, const char* result_string) {
+
+    auto result = ParseResult(result_string);
+    tiex::internal::Time referenced_time(ReferencedTime);
+    tiex::internal::Time formatted_time(ReferencedTime - 5 * 3600);
+
+    std::string text;
+    for (auto _ : state) {
+        tiex::internal::GenerateResultText(result, referenced_time, formatted_time, tiex::Locale(), text);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK_CAPTURE(BM_GenerateResultText, Literal, "{Yesterday}");
+BENCHMARK_CAPTURE(BM_GenerateResultText, Difference, "{%~h hours ago}");
+BENCHMARK_CAPTURE(BM_GenerateResultText, StandardSpecifiers, "{%Y-%m-%d %H:%M:%S}");
+BENCHMARK_CAPTURE(BM_GenerateResultText, Mixed, "{%~h hours ago, at %H:%M}");
+
+
+static void BM_Difference(benchmark::State& state) {
+
+    auto unit = static_cast<tiex::Unit>(state.range(0));
+    auto time = ReferencedTime - 400 * 24 * 3600;
+
+    for (auto _ : state) {
+        auto difference = tiex::Difference(ReferencedTime, time, unit);
+        benchmark::DoNotOptimize(difference);
+    }
+}
+BENCHMARK(BM_Difference)->DenseRange(
+    static_cast<int>(tiex::Unit::Second),
+    static_cast<int>(tiex::Unit::Year));
+
+
+static void BM_DifferenceBatch(benchmark::State& state) {
+
+    auto unit = static_cast<tiex::Unit>(state.range(0));
+
+    std::vector<std::time_t> times1(1000, ReferencedTime);
+    std::vector<std::time_t> times2;
+    for (std::size_t index = 0; index < times1.size(); ++index) {
+        times2.push_back(ReferencedTime - static_cast<std::time_t>(index) * 40000);
+    }
+    std::vector<int> differences(times1.size());
+
+    for (auto _ : state) {
+        tiex::DifferenceBatch(times1.data(), times2.data(), times1.size(), unit, differences.data());
+        benchmark::DoNotOptimize(differences.data());
+    }
+    state.SetItemsProcessed(state.iterations() * times1.size());
+}
+BENCHMARK(BM_DifferenceBatch)->DenseRange(
+    static_cast<int>(tiex::Unit::Second),
+    static_cast<int>(tiex::Unit::Year));
+
+
+static void BM_FormatLocale(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create("[*,*]{%B %a %H %M}");
+    auto locale = (state.range(0) != 0) ? MakeLocale() : tiex::Locale();
+    auto formatted_time = ReferencedTime - 5 * 3600;
+
+    for (auto _ : state) {
+        tiex::FormatError error;
+        auto text = formatter.Format(ReferencedTime, formatted_time, locale, error);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK(BM_FormatLocale)->ArgName("callbacks")->Arg(0)->Arg(1);
+
+
+
+static void BM_FormatBatchLocale(benchmark::State& state) {
+
+    auto formatter = tiex::Formatter::Create("[*,*]{%B %a %H %M}");
+    auto locale = MakeLocale();
+
+    std::vector<std::time_t> formatted_times;
+    for (std::int64_t index = 0; index < state.range(0); ++index) {
+        formatted_times.push_back(ReferencedTime - index * 97);
+    }
+
+    tiex::BatchResult batch_result;
+    for (auto _ : state) {
+        formatter.FormatBatch(
+            ReferencedTime,
+            formatted_times.data(),
+            formatted_times.size(),
+            tiex::TimeZone(),
+            locale,
+            batch_result);
+        benchmark::DoNotOptimize(batch_result.texts.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FormatBatchLocale)->Arg(10000);
+
+BENCHMARK_MAIN();
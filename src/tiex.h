@@ -2,3 +2,7 @@
 
 #include "tiex_difference.h"
 #include "tiex_formatter.h"
+#include "tiex_refresh_scheduler.h"
+#include "tiex_serialization.h"
+#include "tiex_specialized_formatter.h"
+#include "tiex_static_formatter.h"
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "tiex_error.h"
+
+namespace tiex {
+
+/**
+ A batch result stores results of formatting a batch of times.
+
+ Texts of all results are stored contiguously in one string, and each
+ entry refers to its text by offset and length, so formatting a batch
+ doesn't allocate memory for each result. A batch result can be reused
+ for multiple batches to reuse its memory.
+ */
+template<typename C>
+class BasicBatchResult {
+public:
+	using Char = C;
+	using String = std::basic_string<Char>;
+
+	/**
+	 An entry refers to the result of a formatted time.
+	 */
+	class Entry {
+	public:
+		/**
+		 Offset of the result text in texts.
+		 */
+		std::size_t offset = 0;
+
+		/**
+		 Length of the result text, which is 0 if fail to format.
+		 */
+		std::size_t length = 0;
+
+		/**
+		 Status of the format error.
+		 */
+		FormatError::Status status = FormatError::Status::None;
+	};
+
+public:
+	/**
+	 Get the count of results.
+	 */
+	std::size_t GetCount() const {
+		return entries.size();
+	}
+
+	/**
+	 Get the text of a result.
+	 */
+	String GetText(std::size_t index) const {
+		const auto& entry = entries[index];
+		return texts.substr(entry.offset, entry.length);
+	}
+
+	/**
+	 Clear all results, memory is kept for reusing.
+	 */
+	void Clear() {
+		texts.clear();
+		entries.clear();
+	}
+
+public:
+	/**
+	 Texts of all results.
+	 */
+	String texts;
+
+	/**
+	 Entries of results, in the same order of the formatted times.
+	 */
+	std::vector<Entry> entries;
+};
+
+using BatchResult = BasicBatchResult<char>;
+using WideBatchResult = BasicBatchResult<wchar_t>;
+
+}
@@ -0,0 +1,529 @@
+#pragma once
+
+#include <cassert>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tiex_batch.h"
+#include "tiex_compiled_expression.h"
+#include "tiex_error.h"
+#include "tiex_locale.h"
+#include "tiex_locale_table.h"
+#include "tiex_result_cache.h"
+#include "tiex_rule_index.h"
+#include "tiex_thread_pool.h"
+#include "tiex_time.h"
+#include "tiex_time_zone.h"
+#include "tiex_writer.h"
+
+namespace tiex {
+namespace internal {
+
+template<typename C>
+std::vector<ResolvedCondition> ResolveConditions(const CompiledExpression<C>& expression, const Time& referenced_time);
+
+template<typename C>
+std::time_t NextChangeTime(
+	const CompiledExpression<C>& expression,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone);
+
+/**
+ Format with the rule index, and either a locale or a locale table.
+ */
+template<typename C, typename L>
+bool Format(
+	const CompiledExpression<C>& expression,
+	const RuleIndex& rule_index,
+	const Time& referenced_time,
+	std::time_t formatted_time,
+	const L& locale,
+	ResultCache<C>* result_cache,
+	Writer<C>& writer,
+	std::shared_ptr<const std::basic_string<C>>* cached_text,
+	FormatError& format_error);
+
+}
+
+/**
+ A bound formatter is a formatter whose referenced time has been fixed.
+
+ All boundaries of conditions in the expression are converted to absolute
+ times once when binding, and compiled into an index of time segments, so
+ matching a formatted time against the rules is reduced to a search over
+ integers. Use it when lots of times are formatted against the same
+ referenced time.
+
+ A bound formatter shares the expression of the formatter it is bound
+ from, and is immutable as well, so it can be used by multiple threads
+ simultaneously.
+
+ To create a bound formatter, call BasicFormatter::Bind.
+ */
+template<typename C>
+class BasicBoundFormatter {
+public:
+	using Char = C;
+	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
+	using Locale = BasicLocale<Char>;
+	using CompiledExpression = internal::CompiledExpression<Char>;
+	using BatchResult = BasicBatchResult<Char>;
+
+public:
+	/**
+	 Construct a bound formatter with an expression and a referenced time,
+	 in the local time zone.
+	 */
+	BasicBoundFormatter(std::shared_ptr<const CompiledExpression> expression, std::time_t referenced_time) :
+		BasicBoundFormatter(std::move(expression), referenced_time, TimeZone()) {
+
+	}
+
+	/**
+	 Construct a bound formatter with an expression, a referenced time and a
+	 time zone, and optionally the result cache of the formatter.
+	 */
+	BasicBoundFormatter(
+		std::shared_ptr<const CompiledExpression> expression,
+		std::time_t referenced_time,
+		const TimeZone& time_zone,
+		std::shared_ptr<internal::ResultCache<Char>> result_cache = nullptr) :
+
+		expression_(std::move(expression)),
+		result_cache_(std::move(result_cache)),
+		referenced_time_(referenced_time),
+		time_zone_(time_zone) {
+
+		internal::Time referenced(referenced_time_, time_zone_);
+		rule_index_ = internal::RuleIndex(internal::ResolveConditions(*expression_, referenced));
+
+		auto referenced_tm = referenced.GetTm();
+		if (referenced_tm != nullptr) {
+			referenced_tm_ = *referenced_tm;
+			has_referenced_tm_ = true;
+		}
+	}
+
+	/**
+	 Get the referenced time that the formatter is bound to.
+	 */
+	std::time_t GetReferencedTime() const {
+		return referenced_time_;
+	}
+
+	/**
+	 Get the time zone that the formatter is bound to.
+	 */
+	const TimeZone& GetTimeZone() const {
+		return time_zone_;
+	}
+
+	/**
+	 Format time with locale information and catch format error.
+
+	 @param formatted_time
+	   The target time to be formatted to string.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param format_error
+	   An output parameter that stores information about format error.
+
+	 @return
+	   A format result string. An empty string is returned if fail to format.
+	 */
+	String Format(std::time_t formatted_time, const Locale& locale, FormatError& format_error) const {
+		String text;
+		internal::StringWriter<Char> writer(text);
+		if (! Write(formatted_time, locale, writer, format_error)) {
+			return {};
+		}
+		return text;
+	}
+
+	/**
+	 Format time and catch format error.
+	 */
+	String Format(std::time_t formatted_time, FormatError& format_error) const {
+		return Format(formatted_time, Locale(), format_error);
+	}
+
+	/**
+	 Format time with locale information.
+	 */
+	String Format(std::time_t formatted_time, const Locale& locale) const {
+		FormatError error;
+		auto result = Format(formatted_time, locale, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format time.
+	 */
+	String Format(std::time_t formatted_time) const {
+		return Format(formatted_time, Locale());
+	}
+
+	/**
+	 Format time with locale information to a shared string, and catch
+	 format error.
+
+	 See BasicFormatter::FormatShared for details.
+	 */
+	std::shared_ptr<const String> FormatShared(
+		std::time_t formatted_time,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		std::shared_ptr<const String> cached_text;
+		String text;
+		internal::StringWriter<Char> writer(text);
+		if (! Write(GetReferencedTimeObject(), formatted_time, locale, writer, &cached_text, format_error)) {
+			return nullptr;
+		}
+
+		if (cached_text == nullptr) {
+			cached_text = std::make_shared<const String>(std::move(text));
+		}
+		return cached_text;
+	}
+
+	/**
+	 Format time to a shared string.
+	 */
+	std::shared_ptr<const String> FormatShared(std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatShared(formatted_time, Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format time with locale information to a string view, and catch format
+	 error.
+
+	 See BasicFormatter::FormatView for details.
+	 */
+	StringView FormatView(
+		std::time_t formatted_time,
+		const Locale& locale,
+		String& buffer,
+		FormatError& format_error) const {
+
+		buffer.clear();
+		internal::ViewWriter<Char> writer(buffer);
+		if (! Write(formatted_time, locale, writer, format_error)) {
+			return {};
+		}
+		return writer.GetView();
+	}
+
+	/**
+	 Format time to a string view.
+	 */
+	StringView FormatView(std::time_t formatted_time, String& buffer) const {
+		FormatError error;
+		auto result = FormatView(formatted_time, Locale(), buffer, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format time with locale information to an output iterator, and catch
+	 format error.
+
+	 @return
+	   The output iterator past the last written character. Part of result
+	   may have been written if fail to format.
+	 */
+	template<typename OutputIt>
+	OutputIt FormatTo(OutputIt output, std::time_t formatted_time, const Locale& locale, FormatError& format_error) const {
+		internal::OutputIteratorWriter<Char, OutputIt> writer(output);
+		Write(formatted_time, locale, writer, format_error);
+		return writer.GetOutput();
+	}
+
+	/**
+	 Format time to an output iterator.
+	 */
+	template<typename OutputIt>
+	OutputIt FormatTo(OutputIt output, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatTo(output, formatted_time, Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format time with locale information to a buffer, and catch format error.
+
+	 @return
+	   Length of the entire result, which may be greater than capacity. 0 is
+	   returned if fail to format.
+	 */
+	std::size_t FormatTo(
+		Char* buffer,
+		std::size_t capacity,
+		std::time_t formatted_time,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		internal::BufferWriter<Char> writer(buffer, capacity);
+		if (! Write(formatted_time, locale, writer, format_error)) {
+			return 0;
+		}
+		return writer.GetSize();
+	}
+
+	/**
+	 Format time to a buffer.
+	 */
+	std::size_t FormatTo(Char* buffer, std::size_t capacity, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatTo(buffer, capacity, formatted_time, Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format a batch of times with locale information.
+
+	 The referenced time is converted only once for the whole batch, and
+	 results are written to one contiguous string of the batch result. For
+	 large batches, localized texts are rendered from the locale into a
+	 table in advance, so each locale callback is called once per value
+	 rather than once per formatted time.
+
+	 @param formatted_times
+	   The target times to be formatted.
+
+	 @param count
+	   Count of the formatted times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param batch_result
+	   An output parameter that stores results, in the same order of the
+	   formatted times. Results stored previously are cleared.
+	 */
+	void FormatBatch(
+		const std::time_t* formatted_times,
+		std::size_t count,
+		const Locale& locale,
+		BatchResult& batch_result) const {
+
+		//Filling a locale table calls each callback over its whole domain,
+		//which is not worth it for a few times.
+		const std::size_t min_locale_table_count = 256;
+
+		if (count < min_locale_table_count) {
+			FormatBatchWithLocale(formatted_times, count, locale, batch_result);
+			return;
+		}
+
+		internal::LocaleTable<Char> locale_table(locale);
+		FormatBatchWithLocale(formatted_times, count, locale_table, batch_result);
+	}
+
+	/**
+	 Format a batch of times.
+	 */
+	void FormatBatch(const std::time_t* formatted_times, std::size_t count, BatchResult& batch_result) const {
+		FormatBatch(formatted_times, count, Locale(), batch_result);
+	}
+
+	/**
+	 Format a batch of times with locale information in parallel.
+
+	 The times are split into chunks that are formatted by the threads of
+	 the thread pool, each into its own batch result, and then the results
+	 are stitched together in the order of the formatted times, so the
+	 output is identical to the one formatted by a single thread.
+
+	 Localized texts are rendered into a table once on the calling thread,
+	 and the table is shared by all threads. Locale callbacks may still be
+	 called from multiple threads for values out of their domains, such as
+	 leap seconds, so they must be thread safe.
+
+	 @param formatted_times
+	   The target times to be formatted.
+
+	 @param count
+	   Count of the formatted times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param thread_pool
+	   The thread pool that runs the formatting.
+
+	 @param batch_result
+	   An output parameter that stores results, in the same order of the
+	   formatted times. Results stored previously are cleared.
+	 */
+	void FormatBatch(
+		const std::time_t* formatted_times,
+		std::size_t count,
+		const Locale& locale,
+		ThreadPool& thread_pool,
+		BatchResult& batch_result) const {
+
+		//Small chunks are not worth the cost of scheduling and stitching.
+		const std::size_t min_chunk_size = 4096;
+
+		std::size_t chunk_count = thread_pool.GetThreadCount() + 1;
+		if (count / min_chunk_size < chunk_count) {
+			chunk_count = count / min_chunk_size;
+		}
+
+		if (chunk_count <= 1) {
+			FormatBatch(formatted_times, count, locale, batch_result);
+			return;
+		}
+
+		std::size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+		std::vector<BatchResult> chunk_results(chunk_count);
+		internal::LocaleTable<Char> locale_table(locale);
+
+		thread_pool.Run(chunk_count, [&](std::size_t chunk_index) {
+
+			std::size_t begin = chunk_index * chunk_size;
+			std::size_t end = (begin + chunk_size < count) ? (begin + chunk_size) : count;
+			FormatBatchWithLocale(formatted_times + begin, end - begin, locale_table, chunk_results[chunk_index]);
+		});
+
+		batch_result.Clear();
+
+		std::size_t text_length = 0;
+		for (const auto& each_result : chunk_results) {
+			text_length += each_result.texts.length();
+		}
+
+		batch_result.texts.reserve(text_length);
+		batch_result.entries.reserve(count);
+
+		for (const auto& each_result : chunk_results) {
+
+			std::size_t base_offset = batch_result.texts.length();
+			batch_result.texts.append(each_result.texts);
+
+			for (auto each_entry : each_result.entries) {
+				each_entry.offset += base_offset;
+				batch_result.entries.push_back(each_entry);
+			}
+		}
+	}
+
+	/**
+	 Format a batch of times in parallel.
+	 */
+	void FormatBatch(
+		const std::time_t* formatted_times,
+		std::size_t count,
+		ThreadPool& thread_pool,
+		BatchResult& batch_result) const {
+
+		FormatBatch(formatted_times, count, Locale(), thread_pool, batch_result);
+	}
+
+	/**
+	 Get the earliest referenced time after the bound one, at which the
+	 result of formatting the formatted time may change.
+
+	 See BasicFormatter::NextChangeTime for details.
+	 */
+	std::time_t NextChangeTime(std::time_t formatted_time) const {
+		return internal::NextChangeTime(*expression_, referenced_time_, formatted_time, time_zone_);
+	}
+
+private:
+	/**
+	 Format a batch of times with either a locale or a locale table.
+	 */
+	template<typename L>
+	void FormatBatchWithLocale(
+		const std::time_t* formatted_times,
+		std::size_t count,
+		const L& locale,
+		BatchResult& batch_result) const {
+
+		batch_result.Clear();
+		batch_result.entries.reserve(count);
+
+		auto referenced = GetReferencedTimeObject();
+		internal::StringWriter<Char> writer(batch_result.texts);
+
+		for (std::size_t index = 0; index < count; ++index) {
+
+			typename BatchResult::Entry entry;
+			entry.offset = batch_result.texts.length();
+
+			FormatError error;
+			if (! Write(referenced, formatted_times[index], locale, writer, nullptr, error)) {
+				batch_result.texts.resize(entry.offset);
+				entry.status = error.status;
+			}
+
+			entry.length = batch_result.texts.length() - entry.offset;
+			batch_result.entries.push_back(entry);
+		}
+	}
+
+	bool Write(
+		std::time_t formatted_time,
+		const Locale& locale,
+		internal::Writer<Char>& writer,
+		FormatError& format_error) const {
+
+		return Write(GetReferencedTimeObject(), formatted_time, locale, writer, nullptr, format_error);
+	}
+
+	template<typename L>
+	bool Write(
+		const internal::Time& referenced_time,
+		std::time_t formatted_time,
+		const L& locale,
+		internal::Writer<Char>& writer,
+		std::shared_ptr<const String>* cached_text,
+		FormatError& format_error) const {
+
+		return internal::Format(
+			*expression_,
+			rule_index_,
+			referenced_time,
+			formatted_time,
+			locale,
+			result_cache_.get(),
+			writer,
+			cached_text,
+			format_error);
+	}
+
+	internal::Time GetReferencedTimeObject() const {
+		if (has_referenced_tm_) {
+			return internal::Time(referenced_time_, referenced_tm_, time_zone_);
+		}
+		return internal::Time(referenced_time_, time_zone_);
+	}
+
+private:
+	std::shared_ptr<const CompiledExpression> expression_;
+	std::shared_ptr<internal::ResultCache<Char>> result_cache_;
+	std::time_t referenced_time_;
+	TimeZone time_zone_;
+	std::tm referenced_tm_{};
+	bool has_referenced_tm_ = false;
+	internal::RuleIndex rule_index_;
+};
+
+using BoundFormatter = BasicBoundFormatter<char>;
+using WideBoundFormatter = BasicBoundFormatter<wchar_t>;
+
+}
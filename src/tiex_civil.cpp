@@ -0,0 +1,107 @@
+#include "tiex_civil.h"
+#include <limits>
+
+namespace tiex {
+namespace internal {
+namespace {
+
+constexpr std::int64_t SecondsPerDay = 24 * 60 * 60;
+
+
+std::int64_t FloorDivide(std::int64_t dividend, std::int64_t divisor) {
+    auto quotient = dividend / divisor;
+    if ((dividend % divisor != 0) && ((dividend < 0) != (divisor < 0))) {
+        --quotient;
+    }
+    return quotient;
+}
+
+
+std::int64_t FloorModulo(std::int64_t dividend, std::int64_t divisor) {
+    return dividend - FloorDivide(dividend, divisor) * divisor;
+}
+
+}
+
+
+std::int64_t DaysFromCivil(std::int64_t year, int month, int day) {
+
+    //See http://howardhinnant.github.io/date_algorithms.html
+    year -= (month <= 2) ? 1 : 0;
+    std::int64_t era = FloorDivide(year, 400);
+    std::int64_t year_of_era = year - era * 400;
+    std::int64_t day_of_year = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+    std::int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+
+void CivilFromDays(std::int64_t days, std::int64_t& year, int& month, int& day) {
+
+    days += 719468;
+    std::int64_t era = FloorDivide(days, 146097);
+    std::int64_t day_of_era = days - era * 146097;
+    std::int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    std::int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    std::int64_t shifted_month = (5 * day_of_year + 2) / 153;
+
+    day = static_cast<int>(day_of_year - (153 * shifted_month + 2) / 5 + 1);
+    month = static_cast<int>((shifted_month < 10) ? (shifted_month + 3) : (shifted_month - 9));
+    year = year_of_era + era * 400 + ((month <= 2) ? 1 : 0);
+}
+
+
+int GetWeekday(std::int64_t days) {
+    //1970-01-01 is Thursday.
+    return static_cast<int>(FloorModulo(days + 4, 7));
+}
+
+
+std::int64_t CivilToSeconds(const std::tm& tm) {
+
+    std::int64_t year = static_cast<std::int64_t>(tm.tm_year) + 1900 + FloorDivide(tm.tm_mon, 12);
+    int month = static_cast<int>(FloorModulo(tm.tm_mon, 12)) + 1;
+
+    std::int64_t days = DaysFromCivil(year, month, 1) + tm.tm_mday - 1;
+    return
+        days * SecondsPerDay +
+        static_cast<std::int64_t>(tm.tm_hour) * 60 * 60 +
+        static_cast<std::int64_t>(tm.tm_min) * 60 +
+        tm.tm_sec;
+}
+
+
+bool CivilFromSeconds(std::int64_t seconds, std::tm& tm) {
+
+    std::int64_t days = FloorDivide(seconds, SecondsPerDay);
+    std::int64_t seconds_of_day = seconds - days * SecondsPerDay;
+
+    std::int64_t year = 0;
+    int month = 0;
+    int day = 0;
+    CivilFromDays(days, year, month, day);
+
+    std::int64_t tm_year = year - 1900;
+    if ((tm_year < std::numeric_limits<int>::min()) || (tm_year > std::numeric_limits<int>::max())) {
+        return false;
+    }
+
+    tm.tm_year = static_cast<int>(tm_year);
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = static_cast<int>(seconds_of_day / (60 * 60));
+    tm.tm_min = static_cast<int>(seconds_of_day / 60 % 60);
+    tm.tm_sec = static_cast<int>(seconds_of_day % 60);
+    tm.tm_wday = GetWeekday(days);
+    tm.tm_yday = static_cast<int>(days - DaysFromCivil(year, 1, 1));
+    tm.tm_isdst = 0;
+    return true;
+}
+
+
+bool NormalizeTm(std::tm& tm) {
+    return CivilFromSeconds(CivilToSeconds(tm), tm);
+}
+
+}
+}
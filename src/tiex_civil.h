@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+namespace tiex {
+namespace internal {
+
+/**
+ Functions in this file implement the proleptic Gregorian calendar with
+ plain integer arithmetic, so that converting and normalizing civil times
+ don't need std::mktime, which takes a global lock and re-reads the time
+ zone environment on each call. Time zones are applied by TimeZone.
+
+ Civil seconds are seconds since 1970-01-01 00:00:00 of a calendar that has
+ no time zone; they equal to epoch seconds only in UTC.
+ */
+
+/**
+ Get the number of days since 1970-01-01 of a civil date.
+
+ @param month
+   From 1 to 12.
+ */
+std::int64_t DaysFromCivil(std::int64_t year, int month, int day);
+
+/**
+ Get the civil date of the number of days since 1970-01-01.
+ */
+void CivilFromDays(std::int64_t days, std::int64_t& year, int& month, int& day);
+
+/**
+ Get the weekday of the number of days since 1970-01-01, from 0 to 6,
+ which 0 is Sunday.
+ */
+int GetWeekday(std::int64_t days);
+
+/**
+ Convert the fields of a tm to civil seconds.
+
+ Fields are not required to be in their normal ranges, the overflowed parts
+ are carried to upper fields, as std::mktime does. tm_wday, tm_yday and
+ tm_isdst are ignored.
+ */
+std::int64_t CivilToSeconds(const std::tm& tm);
+
+/**
+ Convert civil seconds to the fields of a tm, tm_isdst is set to 0.
+
+ @return
+   Whether the conversion is succeeded. It fails if the year can't be
+   represented by tm.
+ */
+bool CivilFromSeconds(std::int64_t seconds, std::tm& tm);
+
+/**
+ Normalize fields of a tm to their normal ranges, and fill tm_wday and
+ tm_yday.
+ */
+bool NormalizeTm(std::tm& tm);
+
+}
+}
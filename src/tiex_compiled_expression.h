@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include "tiex_expression.h"
+
+namespace tiex {
+namespace internal {
+
+/**
+ A compiled expression is the flat form of an expression that formatters
+ work with.
+
+ All data of the expression is stored in one block of memory, in which
+ conditions of all rules are in one contiguous array, followed by the
+ results of all rules, the instructions of all results, and the literals of
+ all results, which are pooled into one character buffer and referred by
+ offsets. So matching walks contiguous memory, and an expression of a few
+ rules fits in a handful of cache lines.
+
+ A compiled expression is immutable after constructed.
+ */
+template<typename C>
+class CompiledExpression {
+public:
+	using Char = C;
+
+	/**
+	 The result of a rule, which refers to a range of instructions.
+	 */
+	class Result {
+	public:
+		std::size_t instruction_offset = 0;
+		std::size_t instruction_count = 0;
+		bool has_standard_specifiers = false;
+	};
+
+public:
+	explicit CompiledExpression(const BasicExpression<Char>& expression) {
+
+		rule_count_ = expression.rules.size();
+
+		for (const auto& each_rule : expression.rules) {
+			instruction_count_ += each_rule.result.instructions.size();
+			literal_length_ += each_rule.result.literals.length();
+		}
+
+		std::size_t results_offset = AlignOffset<Result>(rule_count_ * sizeof(Condition));
+		std::size_t instructions_offset = AlignOffset<Instruction>(results_offset + rule_count_ * sizeof(Result));
+		std::size_t literals_offset = AlignOffset<Char>(instructions_offset + instruction_count_ * sizeof(Instruction));
+		std::size_t size = literals_offset + literal_length_ * sizeof(Char);
+
+		block_.reset(new Block[(size + sizeof(Block) - 1) / sizeof(Block)]);
+		auto bytes = reinterpret_cast<unsigned char*>(block_.get());
+
+		auto conditions = reinterpret_cast<Condition*>(bytes);
+		auto results = reinterpret_cast<Result*>(bytes + results_offset);
+		auto instructions = reinterpret_cast<Instruction*>(bytes + instructions_offset);
+		auto literals = reinterpret_cast<Char*>(bytes + literals_offset);
+
+		std::size_t instruction_offset = 0;
+		std::size_t literal_offset = 0;
+
+		for (std::size_t index = 0; index < rule_count_; ++index) {
+
+			const auto& rule = expression.rules[index];
+
+			new (conditions + index) Condition(rule.condition);
+
+			Result result;
+			result.instruction_offset = instruction_offset;
+			result.instruction_count = rule.result.instructions.size();
+			result.has_standard_specifiers = rule.result.has_standard_specifiers;
+			new (results + index) Result(result);
+
+			//Literal offsets are rebased to the pool of the whole expression.
+			for (const auto& each_instruction : rule.result.instructions) {
+
+				auto instruction = new (instructions + instruction_offset) Instruction(each_instruction);
+				if (instruction->code == Instruction::Code::Literal) {
+					instruction->offset += literal_offset;
+				}
+				++instruction_offset;
+			}
+
+			std::memcpy(literals + literal_offset, rule.result.literals.data(), rule.result.literals.length() * sizeof(Char));
+			literal_offset += rule.result.literals.length();
+		}
+
+		conditions_ = conditions;
+		results_ = results;
+		instructions_ = instructions;
+		literals_ = literals;
+	}
+
+	CompiledExpression(const CompiledExpression&) = delete;
+	CompiledExpression& operator=(const CompiledExpression&) = delete;
+
+	std::size_t GetRuleCount() const {
+		return rule_count_;
+	}
+
+	const Condition* GetConditions() const {
+		return conditions_;
+	}
+
+	const Result& GetResult(std::size_t rule) const {
+		return results_[rule];
+	}
+
+	const Instruction* GetInstructions(std::size_t rule) const {
+		return instructions_ + results_[rule].instruction_offset;
+	}
+
+	/**
+	 Get the literal pool, which offsets of literal instructions refer to.
+	 */
+	const Char* GetLiterals() const {
+		return literals_;
+	}
+
+	/**
+	 Convert back to an expression, in which literals are split into results.
+	 */
+	BasicExpression<Char> ToExpression() const {
+
+		BasicExpression<Char> expression;
+		expression.rules.resize(rule_count_);
+
+		for (std::size_t index = 0; index < rule_count_; ++index) {
+
+			auto& rule = expression.rules[index];
+			rule.condition = conditions_[index];
+			rule.result.has_standard_specifiers = results_[index].has_standard_specifiers;
+
+			const auto* instructions = GetInstructions(index);
+			for (std::size_t instruction_index = 0; instruction_index < results_[index].instruction_count; ++instruction_index) {
+
+				auto instruction = instructions[instruction_index];
+				if (instruction.code == Instruction::Code::Literal) {
+					rule.result.literals.append(literals_ + instruction.offset, instruction.length);
+					instruction.offset = rule.result.literals.length() - instruction.length;
+				}
+				rule.result.instructions.push_back(instruction);
+			}
+		}
+
+		return expression;
+	}
+
+private:
+	using Block = std::max_align_t;
+
+	template<typename T>
+	static std::size_t AlignOffset(std::size_t offset) {
+		return (offset + alignof(T) - 1) / alignof(T) * alignof(T);
+	}
+
+private:
+	std::unique_ptr<Block[]> block_;
+	std::size_t rule_count_ = 0;
+	std::size_t instruction_count_ = 0;
+	std::size_t literal_length_ = 0;
+	const Condition* conditions_ = nullptr;
+	const Result* results_ = nullptr;
+	const Instruction* instructions_ = nullptr;
+	const Char* literals_ = nullptr;
+};
+
+}
+}
@@ -1,13 +1,91 @@
 #include "tiex_difference.h"
 #include "tiex_generate.h"
+#include <cassert>
 
 namespace tiex {
+namespace {
+
+template<Unit U>
+void DifferenceBatch(const std::time_t* times1, const std::time_t* times2, std::size_t count, int* differences) {
+
+    //Note: the order of operands are reversed.
+    for (std::size_t index = 0; index < count; ++index) {
+        differences[index] = static_cast<int>(internal::GetDifferenceWithTimet<U>(times2[index], times1[index]));
+    }
+}
+
+}
+
 
 int Difference(std::time_t time1, std::time_t time2, Unit unit) {
+    return Difference(time1, time2, unit, internal::GetLocalTimeZone());
+}
+
+int Difference(std::time_t time1, std::time_t time2, Unit unit, const TimeZone& time_zone) {
     long difference = 0;
     //Note: the order of operands are reversed.
-    internal::GetTimeDifference(unit, internal::Time(time2), internal::Time(time1), difference);
+    internal::GetTimeDifference(unit, internal::Time(time2, time_zone), internal::Time(time1, time_zone), difference);
     return static_cast<int>(difference);
 }
 
-}
\ No newline at end of file
+
+void DifferenceBatch(
+    const std::time_t* times1,
+    const std::time_t* times2,
+    std::size_t count,
+    Unit unit,
+    int* differences) {
+
+    DifferenceBatch(times1, times2, count, unit, internal::GetLocalTimeZone(), differences);
+}
+
+void DifferenceBatch(
+    const std::time_t* times1,
+    const std::time_t* times2,
+    std::size_t count,
+    Unit unit,
+    const TimeZone& time_zone,
+    int* differences) {
+
+    switch (unit) {
+        case Unit::Second:
+            DifferenceBatch<Unit::Second>(times1, times2, count, differences);
+            return;
+        case Unit::Minute:
+            DifferenceBatch<Unit::Minute>(times1, times2, count, differences);
+            return;
+        case Unit::Hour:
+            DifferenceBatch<Unit::Hour>(times1, times2, count, differences);
+            return;
+        case Unit::Day:
+            DifferenceBatch<Unit::Day>(times1, times2, count, differences);
+            return;
+        case Unit::Week:
+            DifferenceBatch<Unit::Week>(times1, times2, count, differences);
+            return;
+        default:
+            break;
+    }
+
+    assert((unit == Unit::Month) || (unit == Unit::Year));
+
+    if (count == 0) {
+        return;
+    }
+
+    //Rows often share the same time, whose tm is converted only once.
+    internal::Time time1(times1[0], time_zone);
+    for (std::size_t index = 0; index < count; ++index) {
+
+        if (times1[index] != time1.GetTimet()) {
+            time1 = internal::Time(times1[index], time_zone);
+        }
+
+        long difference = 0;
+        //Note: the order of operands are reversed.
+        internal::GetTimeDifference(unit, internal::Time(times2[index], time_zone), time1, difference);
+        differences[index] = static_cast<int>(difference);
+    }
+}
+
+}
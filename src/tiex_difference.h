@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <ctime>
+#include "tiex_time_zone.h"
 #include "tiex_unit.h"
 
 namespace tiex {
@@ -12,4 +14,57 @@ namespace tiex {
  */
 int Difference(std::time_t time1, std::time_t time2, Unit unit);
 
-}
\ No newline at end of file
+/**
+ Calculate the difference of two time points by specified time unit, in
+ the specified time zone.
+
+ The time zone affects months and years only.
+ */
+int Difference(std::time_t time1, std::time_t time2, Unit unit, const TimeZone& time_zone);
+
+/**
+ Calculate the differences of pairs of time points by specified time unit.
+
+ This function is equivalent to calling Difference for each pair, that is
+ "differences[i] = times1[i] - times2[i]", but it is much faster for lots
+ of pairs. Differences in fixed-length units, from seconds to weeks, are
+ calculated in one loop whose divisor is a constant, which is vectorized by
+ compilers.
+
+ @param times1
+   An array of count time points.
+
+ @param times2
+   An array of count time points.
+
+ @param count
+   Count of pairs.
+
+ @param unit
+   The unit of differences.
+
+ @param differences
+   An output array of count differences.
+ */
+void DifferenceBatch(
+    const std::time_t* times1,
+    const std::time_t* times2,
+    std::size_t count,
+    Unit unit,
+    int* differences);
+
+/**
+ Calculate the differences of pairs of time points by specified time unit,
+ in the specified time zone.
+
+ The time zone affects months and years only.
+ */
+void DifferenceBatch(
+    const std::time_t* times1,
+    const std::time_t* times2,
+    std::size_t count,
+    Unit unit,
+    const TimeZone& time_zone,
+    int* differences);
+
+}
@@ -39,7 +39,7 @@ public:
     /**
      Clear error information, reset to default state.
      */
-    void Clear() {
+    constexpr void Clear() {
         status = Status::None;
         index = 0;
     }
@@ -87,7 +87,7 @@ public:
     /**
      Clear error information, reset to default state.
      */
-    void Clear() {
+    constexpr void Clear() {
         status = Status::None;
     }
     
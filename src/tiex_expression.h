@@ -1,6 +1,6 @@
 #pragma once
 
-#include <map>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include "tiex_unit.h"
@@ -24,15 +24,60 @@ public:
 
 class Specifier {
 public:
+    /**
+     The conversion character of a standard specifier, such as 'H' of %H.
+     */
+    char standard_char = 0;
+
+    /**
+     The unit of a %~ specifier.
+     */
     Unit unit = Unit::Second;
 };
 
 
+/**
+ An instruction of the program that generates a result.
+ */
+class Instruction {
+public:
+    enum class Code {
+
+        /**
+         Write the literal characters in [offset, offset + length) of
+         the literal pool of the result.
+         */
+        Literal,
+
+        /**
+         Write the absolute difference between the referenced time and the
+         formatted time, in the unit of the specifier.
+         */
+        Difference,
+
+        /**
+         Write a field of the formatted time, by the standard specifier.
+         */
+        Field,
+    };
+
+public:
+    Code code = Code::Literal;
+    std::size_t offset = 0;
+    std::size_t length = 0;
+    Specifier specifier;
+};
+
+
+/**
+ A result is compiled to a program at parse time, which is a sequence of
+ instructions that are executed in order to generate the result text.
+ */
 template<typename C>
 class BasicResult {
 public:
-    std::vector<std::basic_string<C>> texts;
-    std::map<std::size_t, Specifier> specifiers;
+    std::basic_string<C> literals;
+    std::vector<Instruction> instructions;
     bool has_standard_specifiers = false;
 };
 
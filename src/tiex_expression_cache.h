@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "tiex_compiled_expression.h"
+
+namespace tiex {
+namespace internal {
+
+/**
+ A cache of parsed expressions, keyed by expression strings.
+
+ Expressions are immutable once cached, and they are shared by all
+ formatters that are created from the same string, so an expression string
+ is parsed only once no matter how many times it is used.
+
+ The cache is thread safe. It is split into shards by the hash of strings,
+ and each shard is guarded by a shared mutex, so lookups, which are far
+ more frequent than insertions, run simultaneously without blocking each
+ other. When a shard is full, all expressions in it are dropped; formatters
+ that hold them are not affected.
+ */
+template<typename C>
+class ExpressionCache {
+public:
+	using String = std::basic_string<C>;
+	using StringView = std::basic_string_view<C>;
+	using Expression = CompiledExpression<C>;
+
+public:
+	explicit ExpressionCache(std::size_t capacity) :
+		shard_capacity_((capacity + ShardCount - 1) / ShardCount) {
+
+	}
+
+	ExpressionCache(const ExpressionCache&) = delete;
+	ExpressionCache& operator=(const ExpressionCache&) = delete;
+
+	/**
+	 Find the cached expression of a string.
+
+	 @return
+	   nullptr if the expression is not cached.
+	 */
+	std::shared_ptr<const Expression> Find(StringView string) const {
+
+		const auto& shard = GetShard(string);
+
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+		auto iterator = shard.expressions.find(string);
+		if (iterator == shard.expressions.end()) {
+			return nullptr;
+		}
+		return iterator->second->expression;
+	}
+
+	/**
+	 Insert the expression of a string.
+
+	 @return
+	   The cached expression, which is the one that has been inserted by
+	   another thread, if any.
+	 */
+	std::shared_ptr<const Expression> Insert(StringView string, std::shared_ptr<const Expression> expression) {
+
+		auto& shard = GetShard(string);
+
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		auto iterator = shard.expressions.find(string);
+		if (iterator != shard.expressions.end()) {
+			return iterator->second->expression;
+		}
+
+		if (shard.expressions.size() >= shard_capacity_) {
+			shard.expressions.clear();
+		}
+
+		auto entry = std::make_unique<Entry>(Entry{ String(string), expression });
+		StringView key = entry->string;
+		shard.expressions.emplace(key, std::move(entry));
+		return expression;
+	}
+
+	std::size_t GetSize() const {
+
+		std::size_t size = 0;
+		for (const auto& each_shard : shards_) {
+			std::shared_lock<std::shared_mutex> lock(each_shard.mutex);
+			size += each_shard.expressions.size();
+		}
+		return size;
+	}
+
+	void Clear() {
+
+		for (auto& each_shard : shards_) {
+			std::unique_lock<std::shared_mutex> lock(each_shard.mutex);
+			each_shard.expressions.clear();
+		}
+	}
+
+private:
+	static constexpr std::size_t ShardCount = 16;
+
+	/**
+	 Strings are owned by entries, which are allocated separately, so that
+	 keys of the map can be views of them, and lookups by views don't
+	 construct strings.
+	 */
+	class Entry {
+	public:
+		String string;
+		std::shared_ptr<const Expression> expression;
+	};
+
+	class Shard {
+	public:
+		mutable std::shared_mutex mutex;
+		std::unordered_map<StringView, std::unique_ptr<Entry>> expressions;
+	};
+
+private:
+	const Shard& GetShard(StringView string) const {
+		return shards_[std::hash<StringView>()(string) % ShardCount];
+	}
+
+	Shard& GetShard(StringView string) {
+		return shards_[std::hash<StringView>()(string) % ShardCount];
+	}
+
+private:
+	std::size_t shard_capacity_;
+	std::array<Shard, ShardCount> shards_;
+};
+
+
+/**
+ Get the process-wide expression cache, which is used by
+ BasicFormatter::CreateShared.
+ */
+template<typename C>
+ExpressionCache<C>& GetSharedExpressionCache() {
+	static ExpressionCache<C> cache(1024);
+	return cache;
+}
+
+}
+}
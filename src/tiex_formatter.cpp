@@ -8,9 +8,9 @@ namespace tiex {
 namespace internal {
 
 template<typename C>
-BasicExpression<C> Parse(const std::basic_string<C>& expression_string, ParseError& parse_error) {
+BasicExpression<C> Parse(std::basic_string_view<C> expression_string, ParseError& parse_error) {
 
-	Scanner<C> scanner(expression_string.c_str(), expression_string.length());
+	Scanner<C> scanner(expression_string.data(), expression_string.length());
 	Parser<C> parser(scanner);
 
 	auto expression = parser.Parse();
@@ -20,69 +20,262 @@ BasicExpression<C> Parse(const std::basic_string<C>& expression_string, ParseErr
 }
 
 template
-BasicExpression<char> Parse<char>(const std::basic_string<char>& expression, ParseError& parse_error);
+BasicExpression<char> Parse<char>(std::basic_string_view<char> expression, ParseError& parse_error);
 
 template
-BasicExpression<wchar_t> Parse<wchar_t>(const std::basic_string<wchar_t>& expression, ParseError& parse_error);
+BasicExpression<wchar_t> Parse<wchar_t>(std::basic_string_view<wchar_t> expression, ParseError& parse_error);
+
+
+template<typename C, typename L>
+bool GenerateRule(
+	const CompiledExpression<C>& expression,
+	std::size_t rule,
+	const Time& referenced_time,
+	const Time& formatted_time,
+	const L& locale,
+	ResultCache<C>* result_cache,
+	Writer<C>& writer,
+	std::shared_ptr<const std::basic_string<C>>* cached_text) {
+
+	auto generate_result = [&](Writer<C>& result_writer) {
+		return GenerateInstructions(
+			expression.GetLiterals(),
+			expression.GetInstructions(rule),
+			expression.GetResult(rule).instruction_count,
+			referenced_time,
+			formatted_time,
+			locale,
+			result_writer);
+	};
+
+	if ((result_cache == nullptr) || (! result_cache->GetRuleKey(rule).is_cacheable)) {
+		return generate_result(writer);
+	}
+
+	//Pure literal text is written directly, unless a shared string is
+	//wanted.
+	const auto& rule_key = result_cache->GetRuleKey(rule);
+	if ((! rule_key.has_difference) && (cached_text == nullptr)) {
+		return generate_result(writer);
+	}
+
+	long difference = 0;
+	if (rule_key.has_difference) {
+		if (! GetTimeDifference(rule_key.unit, referenced_time, formatted_time, difference)) {
+			return false;
+		}
+	}
+
+	auto text = result_cache->Find(rule, difference);
+	if (text == nullptr) {
+
+		std::basic_string<C> generated_text;
+		StringWriter<C> generated_writer(generated_text);
+		if (! generate_result(generated_writer)) {
+			return false;
+		}
+
+		text = std::make_shared<const std::basic_string<C>>(std::move(generated_text));
+		result_cache->Insert(rule, difference, text);
+	}
+
+	if (cached_text != nullptr) {
+		*cached_text = std::move(text);
+	}
+	else {
+		writer.Write(*text);
+	}
+	return true;
+}
 
 
 template<typename C>
-std::basic_string<C> Format(
-	const BasicExpression<C>& expression,
+bool Format(
+	const CompiledExpression<C>& expression,
 	std::time_t referenced_time,
 	std::time_t formatted_time,
+	const TimeZone& time_zone,
 	const BasicLocale<C>& locale,
+	ResultCache<C>* result_cache,
+	Writer<C>& writer,
+	std::shared_ptr<const std::basic_string<C>>* cached_text,
 	FormatError& format_error) {
 
-	if (expression.rules.empty()) {
+	if (expression.GetRuleCount() == 0) {
 		format_error.status = FormatError::Status::NoMatchedRule;
-		return {};
+		return false;
 	}
 
-	internal::Time referenced(referenced_time);
-	internal::Time formatted(formatted_time);
+	internal::Time referenced(referenced_time, time_zone);
+	internal::Time formatted(formatted_time, time_zone);
 
-	for (const auto& each_rule : expression.rules) {
+	const auto* conditions = expression.GetConditions();
+	return internal::FormatFirstMatchedRule(
+		expression.GetRuleCount(),
+		[conditions](std::size_t index) -> const Condition& {
+			return conditions[index];
+		},
+		referenced,
+		formatted,
+		[&](std::size_t index) {
+			return GenerateRule(
+				expression,
+				index,
+				referenced,
+				formatted,
+				locale,
+				result_cache,
+				writer,
+				cached_text);
+		},
+		format_error);
+}
 
-		bool is_matched = false;
-		bool is_succeeded = internal::MatchCondition(each_rule.condition, referenced, formatted, is_matched);
-		if (! is_succeeded) {
-			format_error.status = FormatError::Status::TimeError;
-			return {};
-		}
+template
+bool Format(
+	const CompiledExpression<char>& expression,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<char>& locale,
+	ResultCache<char>* result_cache,
+	Writer<char>& writer,
+	std::shared_ptr<const std::basic_string<char>>* cached_text,
+	FormatError& format_error);
 
-		if (is_matched) {
+template
+bool Format(
+	const CompiledExpression<wchar_t>& expression,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<wchar_t>& locale,
+	ResultCache<wchar_t>* result_cache,
+	Writer<wchar_t>& writer,
+	std::shared_ptr<const std::basic_string<wchar_t>>* cached_text,
+	FormatError& format_error);
 
-			std::basic_string<C> result_text;
-			bool is_succeeded = GenerateResultText(each_rule.result, referenced, formatted, locale, result_text);
-			if (! is_succeeded) {
-				format_error.status = FormatError::Status::TimeError;
-				return {};
-			}
 
-			return result_text;
-		}
+template<typename C>
+std::vector<ResolvedCondition> ResolveConditions(const CompiledExpression<C>& expression, const Time& referenced_time) {
+
+	std::vector<ResolvedCondition> resolved_conditions(expression.GetRuleCount());
+
+	auto referenced_tm = referenced_time.GetTm();
+	if (referenced_tm == nullptr) {
+		return resolved_conditions;
 	}
 
-	format_error.status = FormatError::Status::NoMatchedRule;
-	return {};
+	for (std::size_t index = 0; index < expression.GetRuleCount(); ++index) {
+
+		auto& resolved_condition = resolved_conditions[index];
+		resolved_condition.is_valid = ResolveCondition(
+			expression.GetConditions()[index],
+			*referenced_tm,
+			referenced_time.GetTimeZone(),
+			resolved_condition.backward_time,
+			resolved_condition.forward_time);
+	}
+
+	return resolved_conditions;
 }
 
 template
-std::basic_string<char> Format(
-	const BasicExpression<char>& expression,
-	std::time_t referenced_time,
+std::vector<ResolvedCondition> ResolveConditions(const CompiledExpression<char>& expression, const Time& referenced_time);
+
+template
+std::vector<ResolvedCondition> ResolveConditions(const CompiledExpression<wchar_t>& expression, const Time& referenced_time);
+
+
+template<typename C, typename L>
+bool Format(
+	const CompiledExpression<C>& expression,
+	const RuleIndex& rule_index,
+	const Time& referenced_time,
+	std::time_t formatted_time,
+	const L& locale,
+	ResultCache<C>* result_cache,
+	Writer<C>& writer,
+	std::shared_ptr<const std::basic_string<C>>* cached_text,
+	FormatError& format_error) {
+
+	int rule = rule_index.Find(formatted_time);
+
+	if (rule == RuleIndex::NoMatchedRule) {
+		format_error.status = FormatError::Status::NoMatchedRule;
+		return false;
+	}
+
+	if (rule == RuleIndex::InvalidCondition) {
+		format_error.status = FormatError::Status::TimeError;
+		return false;
+	}
+
+	bool is_succeeded = GenerateRule(
+		expression,
+		static_cast<std::size_t>(rule),
+		referenced_time,
+		internal::Time(formatted_time, referenced_time.GetTimeZone()),
+		locale,
+		result_cache,
+		writer,
+		cached_text);
+
+	if (! is_succeeded) {
+		format_error.status = FormatError::Status::TimeError;
+		return false;
+	}
+
+	return true;
+}
+
+template
+bool Format(
+	const CompiledExpression<char>& expression,
+	const RuleIndex& rule_index,
+	const Time& referenced_time,
 	std::time_t formatted_time,
 	const BasicLocale<char>& locale,
+	ResultCache<char>* result_cache,
+	Writer<char>& writer,
+	std::shared_ptr<const std::basic_string<char>>* cached_text,
 	FormatError& format_error);
 
 template
-std::basic_string<wchar_t> Format(
-	const BasicExpression<wchar_t>& expression,
-	std::time_t referenced_time,
+bool Format(
+	const CompiledExpression<char>& expression,
+	const RuleIndex& rule_index,
+	const Time& referenced_time,
+	std::time_t formatted_time,
+	const LocaleTable<char>& locale_table,
+	ResultCache<char>* result_cache,
+	Writer<char>& writer,
+	std::shared_ptr<const std::basic_string<char>>* cached_text,
+	FormatError& format_error);
+
+template
+bool Format(
+	const CompiledExpression<wchar_t>& expression,
+	const RuleIndex& rule_index,
+	const Time& referenced_time,
 	std::time_t formatted_time,
 	const BasicLocale<wchar_t>& locale,
+	ResultCache<wchar_t>* result_cache,
+	Writer<wchar_t>& writer,
+	std::shared_ptr<const std::basic_string<wchar_t>>* cached_text,
+	FormatError& format_error);
+
+template
+bool Format(
+	const CompiledExpression<wchar_t>& expression,
+	const RuleIndex& rule_index,
+	const Time& referenced_time,
+	std::time_t formatted_time,
+	const LocaleTable<wchar_t>& locale_table,
+	ResultCache<wchar_t>* result_cache,
+	Writer<wchar_t>& writer,
+	std::shared_ptr<const std::basic_string<wchar_t>>* cached_text,
 	FormatError& format_error);
 
 }
-}
+}
\ No newline at end of file
@@ -2,23 +2,38 @@
 
 #include <cassert>
 #include <ctime>
+#include <memory>
 #include <string>
+#include <string_view>
+#include "tiex_batch.h"
+#include "tiex_bound_formatter.h"
+#include "tiex_compiled_expression.h"
 #include "tiex_error.h"
 #include "tiex_expression.h"
+#include "tiex_expression_cache.h"
 #include "tiex_locale.h"
+#include "tiex_result_cache.h"
+#include "tiex_serialization.h"
+#include "tiex_thread_pool.h"
+#include "tiex_time_zone.h"
+#include "tiex_writer.h"
 
 namespace tiex {
 namespace internal {
 
 template<typename C>
-BasicExpression<C> Parse(const std::basic_string<C>& expression_string, ParseError& parse_error);
+BasicExpression<C> Parse(std::basic_string_view<C> expression_string, ParseError& parse_error);
 
 template<typename C>
-std::basic_string<C> Format(
-	const BasicExpression<C>& expression,
+bool Format(
+	const CompiledExpression<C>& expression,
 	std::time_t referenced_time, 
 	std::time_t formatted_time,
+	const TimeZone& time_zone,
 	const BasicLocale<C>& locale,
+	ResultCache<C>* result_cache,
+	Writer<C>& writer,
+	std::shared_ptr<const std::basic_string<C>>* cached_text,
 	FormatError& format_error);
 
 }
@@ -32,14 +47,24 @@ std::basic_string<C> Format(
  string and pass it to the static function Create. You should reuse one
  formatter whenever possible if the same expression is needed for multiple
  times, to avoid re-parsing and performance.
+
+ A formatter is immutable after created. All of its methods are const and
+ reentrant, so one formatter can be shared by multiple threads and used
+ simultaneously, as long as locale callbacks are thread safe. The parsed
+ expression is shared between copies of a formatter and the bound
+ formatters created from it, so copying a formatter is cheap.
  */
 template<typename C>
 class BasicFormatter {
 public:
 	using Char = C;
 	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
 	using Locale = BasicLocale<Char>;
 	using Expression = BasicExpression<Char>;
+	using CompiledExpression = internal::CompiledExpression<Char>;
+	using BoundFormatter = BasicBoundFormatter<Char>;
+	using BatchResult = BasicBatchResult<Char>;
 
 public:
 	/**
@@ -51,7 +76,7 @@ public:
 	 @return
 	   An empty formatter if fail to parse the expression.
 	 */
-	static BasicFormatter Create(const String& expression) {
+	static BasicFormatter Create(StringView expression) {
 		ParseError error;
 		auto formatter = Create(expression, error);
 		assert(error.status == ParseError::Status::None);
@@ -70,21 +95,167 @@ public:
 	 @return
 	   An empty formatter if fail to parse the expression.
 	 */
-	static BasicFormatter Create(const String& expression, ParseError& parse_error) {
+	static BasicFormatter Create(StringView expression, ParseError& parse_error) {
 		return BasicFormatter(internal::Parse(expression, parse_error));
 	}
 
+	/**
+	 Create a formatter that shares the parsed expression with other
+	 formatters created from the same string.
+
+	 Parsed expressions are kept in a process-wide cache, so the string is
+	 parsed only the first time, and later calls, from any thread, return
+	 formatters referring to the same immutable expression. It suits
+	 expressions that are used all over a program, which would otherwise be
+	 parsed again and again.
+
+	 @param string
+	   An expression string that to be parsed.
+
+	 @return
+	   An empty formatter if fail to parse the expression.
+	 */
+	static BasicFormatter CreateShared(StringView expression) {
+		ParseError error;
+		auto formatter = CreateShared(expression, error);
+		assert(error.status == ParseError::Status::None);
+		return formatter;
+	}
+
+	/**
+	 Create a formatter that shares the parsed expression, and catch parse
+	 error.
+
+	 Expressions that fail to parse are not cached.
+
+	 @param string
+	   An expression string that to be parsed.
+
+	 @param parse_error
+	   An output parameter that stores information about parse error.
+
+	 @return
+	   An empty formatter if fail to parse the expression.
+	 */
+	static BasicFormatter CreateShared(StringView expression, ParseError& parse_error) {
+
+		auto& cache = internal::GetSharedExpressionCache<Char>();
+
+		auto cached_expression = cache.Find(expression);
+		if (cached_expression != nullptr) {
+			parse_error = ParseError();
+			return BasicFormatter(std::move(cached_expression));
+		}
+
+		auto parsed_expression = internal::Parse(expression, parse_error);
+		if (parse_error.status != ParseError::Status::None) {
+			return BasicFormatter();
+		}
+
+		return BasicFormatter(cache.Insert(
+			expression,
+			std::make_shared<const CompiledExpression>(parsed_expression)));
+	}
+
+	/**
+	 Create a formatter from a binary blob that is returned by Serialize,
+	 without parsing.
+
+	 @param data
+	   The blob, which is copied.
+
+	 @param size
+	   Length of the blob in bytes.
+
+	 @param formatter
+	   An output parameter that stores the formatter.
+
+	 @return
+	   Whether the blob is valid.
+	 */
+	static bool Deserialize(const void* data, std::size_t size, BasicFormatter& formatter) {
+
+		Expression expression;
+		if (! tiex::Deserialize(data, size, expression)) {
+			return false;
+		}
+
+		formatter = BasicFormatter(expression);
+		return true;
+	}
+
 public:
 	/**
 	 Construct an empty formatter.
 	 */
-	BasicFormatter() = default;
+	BasicFormatter() : expression_(GetEmptyExpression()) {
+
+	}
 
 	/**
 	 Construct a formatter with an expression.
 	 */
-	explicit BasicFormatter(Expression expression) : expression_(std::move(expression)) {
+	explicit BasicFormatter(const Expression& expression) :
+		expression_(std::make_shared<const CompiledExpression>(expression)) {
+
+	}
+
+	/**
+	 Format times in a time zone with locale information and catch format error.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to the formatted time.
+
+	 @param formatted_time
+	   The target time to be formatted to string.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @param locale
+	   Contains localization information that affect format result.
 
+	 @param format_error
+	   An output parameter that stores information about format error.
+
+	 @return
+	   A format result string. An empty string is returned if fail to format.
+	 */
+	String Format(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		String text;
+		internal::StringWriter<Char> writer(text);
+		if (! Write(referenced_time, formatted_time, time_zone, locale, writer, nullptr, format_error)) {
+			return {};
+		}
+		return text;
+	}
+
+	/**
+	 Format times in a time zone.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to the formatted time.
+
+	 @param formatted_time
+	   The target time to be formatted to string.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @return
+	   A format result string. An empty string is returned if fail to format.
+	 */
+	String Format(std::time_t referenced_time, std::time_t formatted_time, const TimeZone& time_zone) const {
+		FormatError error;
+		auto result = Format(referenced_time, formatted_time, time_zone, Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
 	}
 
 	/**
@@ -109,9 +280,9 @@ public:
 		std::time_t referenced_time,
 		std::time_t formatted_time,
 		const Locale& locale,
-		FormatError& format_error) {
+		FormatError& format_error) const {
 
-		return internal::Format(expression_, referenced_time, formatted_time, locale, format_error);
+		return Format(referenced_time, formatted_time, TimeZone(), locale, format_error);
 	}
 
 	/**
@@ -129,7 +300,7 @@ public:
 	 @return
 	   A format result string. An empty string is returned if fail to format.
 	 */
-	String Format(std::time_t referenced_time, std::time_t formatted_time, FormatError& format_error) {
+	String Format(std::time_t referenced_time, std::time_t formatted_time, FormatError& format_error) const {
 		return Format(referenced_time, formatted_time, Locale(), format_error);
 	}
 
@@ -148,7 +319,7 @@ public:
 	 @return
 	   A format result string. An empty string is returned if fail to format.
 	 */
-	String Format(std::time_t referenced_time, std::time_t formatted_time, const Locale& locale) {
+	String Format(std::time_t referenced_time, std::time_t formatted_time, const Locale& locale) const {
 		FormatError error;
 		auto result = Format(referenced_time, formatted_time, locale, error);
 		assert(error.status == FormatError::Status::None);
@@ -167,12 +338,471 @@ public:
 	 @return
 	   A format result string. An empty string is returned if fail to format.
 	 */
-	String Format(std::time_t referenced_time, std::time_t formatted_time) {
+	String Format(std::time_t referenced_time, std::time_t formatted_time) const {
 		return Format(referenced_time, formatted_time, Locale());
 	}
 
+	/**
+	 Format times in a time zone with locale information to a shared
+	 string, and catch format error.
+
+	 If the formatter has a result cache and the matched rule is cacheable,
+	 the cached string is returned without generating it again, otherwise a
+	 new string is returned. See WithResultCache.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to the formatted time.
+
+	 @param formatted_time
+	   The target time to be formatted to string.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param format_error
+	   An output parameter that stores information about format error.
+
+	 @return
+	   A format result string. nullptr is returned if fail to format.
+	 */
+	std::shared_ptr<const String> FormatShared(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		std::shared_ptr<const String> cached_text;
+		String text;
+		internal::StringWriter<Char> writer(text);
+		if (! Write(referenced_time, formatted_time, time_zone, locale, writer, &cached_text, format_error)) {
+			return nullptr;
+		}
+
+		if (cached_text == nullptr) {
+			cached_text = std::make_shared<const String>(std::move(text));
+		}
+		return cached_text;
+	}
+
+	/**
+	 Format times to a shared string.
+	 */
+	std::shared_ptr<const String> FormatShared(std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatShared(referenced_time, formatted_time, TimeZone(), Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a string view,
+	 and catch format error.
+
+	 If the matched result is pure literal text, such as "{Just now}", the
+	 returned view refers to the storage of the formatter, and nothing is
+	 copied. Otherwise, the result is formatted to the buffer, and the
+	 returned view refers to the buffer.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to the formatted time.
+
+	 @param formatted_time
+	   The target time to be formatted.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param buffer
+	   A string that stores the result if it is not pure literal text. Its
+	   previous content is discarded in this case.
+
+	 @param format_error
+	   An output parameter that stores information about format error.
+
+	 @return
+	   A view of the result, which is valid as long as the formatter, or a
+	   copy of it, is alive and the buffer is not modified. An empty view is
+	   returned if fail to format.
+	 */
+	StringView FormatView(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		String& buffer,
+		FormatError& format_error) const {
+
+		buffer.clear();
+		internal::ViewWriter<Char> writer(buffer);
+		if (! Write(referenced_time, formatted_time, time_zone, locale, writer, nullptr, format_error)) {
+			return {};
+		}
+		return writer.GetView();
+	}
+
+	/**
+	 Format times to a string view.
+	 */
+	StringView FormatView(std::time_t referenced_time, std::time_t formatted_time, String& buffer) const {
+		FormatError error;
+		auto result = FormatView(referenced_time, formatted_time, TimeZone(), Locale(), buffer, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to an output
+	 iterator, and catch format error.
+
+	 No memory is allocated by formatting itself, unless locale callbacks or
+	 %Z are used in the matched rule.
+
+	 @param output
+	   An output iterator that format result is written to.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to the formatted time.
+
+	 @param formatted_time
+	   The target time to be formatted.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param format_error
+	   An output parameter that stores information about format error.
+
+	 @return
+	   The output iterator past the last written character. Part of result
+	   may have been written if fail to format.
+	 */
+	template<typename OutputIt>
+	OutputIt FormatTo(
+		OutputIt output,
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		internal::OutputIteratorWriter<Char, OutputIt> writer(output);
+		Write(referenced_time, formatted_time, time_zone, locale, writer, nullptr, format_error);
+		return writer.GetOutput();
+	}
+
+	/**
+	 Format times to an output iterator.
+	 */
+	template<typename OutputIt>
+	OutputIt FormatTo(OutputIt output, std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatTo(output, referenced_time, formatted_time, TimeZone(), Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a buffer, and
+	 catch format error.
+
+	 No memory is allocated by formatting itself, unless locale callbacks or
+	 %Z are used in the matched rule.
+
+	 @param buffer
+	   The buffer that format result is written to. No null terminator is
+	   appended.
+
+	 @param capacity
+	   Capacity of the buffer in characters. Result that exceeds the capacity
+	   is truncated.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to the formatted time.
+
+	 @param formatted_time
+	   The target time to be formatted.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param format_error
+	   An output parameter that stores information about format error.
+
+	 @return
+	   Length of the entire result, which may be greater than capacity. 0 is
+	   returned if fail to format.
+	 */
+	std::size_t FormatTo(
+		Char* buffer,
+		std::size_t capacity,
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		internal::BufferWriter<Char> writer(buffer, capacity);
+		if (! Write(referenced_time, formatted_time, time_zone, locale, writer, nullptr, format_error)) {
+			return 0;
+		}
+		return writer.GetSize();
+	}
+
+	/**
+	 Format times to a buffer.
+	 */
+	std::size_t FormatTo(Char* buffer, std::size_t capacity, std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatTo(buffer, capacity, referenced_time, formatted_time, TimeZone(), Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Get the length of format result, which is used to prepare a buffer for
+	 FormatTo.
+
+	 @return
+	   Length of the result. 0 is returned if fail to format.
+	 */
+	std::size_t FormattedSize(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		return FormatTo(nullptr, 0, referenced_time, formatted_time, time_zone, locale, format_error);
+	}
+
+	/**
+	 Get the length of format result.
+	 */
+	std::size_t FormattedSize(std::time_t referenced_time, std::time_t formatted_time) const {
+		return FormatTo(nullptr, 0, referenced_time, formatted_time);
+	}
+
+	/**
+	 Format a batch of times against the same referenced time in a time zone
+	 with locale information.
+
+	 It is equivalent to binding the formatter to the referenced time and
+	 formatting the times with the bound formatter, so the referenced time
+	 is converted only once for the whole batch.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to the formatted times.
+
+	 @param formatted_times
+	   The target times to be formatted.
+
+	 @param count
+	   Count of the formatted times.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+
+	 @param batch_result
+	   An output parameter that stores results, in the same order of the
+	   formatted times. Results stored previously are cleared.
+	 */
+	void FormatBatch(
+		std::time_t referenced_time,
+		const std::time_t* formatted_times,
+		std::size_t count,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		BatchResult& batch_result) const {
+
+		Bind(referenced_time, time_zone).FormatBatch(formatted_times, count, locale, batch_result);
+	}
+
+	/**
+	 Format a batch of times against the same referenced time.
+	 */
+	void FormatBatch(
+		std::time_t referenced_time,
+		const std::time_t* formatted_times,
+		std::size_t count,
+		BatchResult& batch_result) const {
+
+		FormatBatch(referenced_time, formatted_times, count, TimeZone(), Locale(), batch_result);
+	}
+
+	/**
+	 Format a batch of times against the same referenced time in a time zone
+	 with locale information, in parallel.
+
+	 See BasicBoundFormatter::FormatBatch for details.
+	 */
+	void FormatBatch(
+		std::time_t referenced_time,
+		const std::time_t* formatted_times,
+		std::size_t count,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		ThreadPool& thread_pool,
+		BatchResult& batch_result) const {
+
+		Bind(referenced_time, time_zone).FormatBatch(formatted_times, count, locale, thread_pool, batch_result);
+	}
+
+	/**
+	 Get the earliest referenced time after the specified one, at which the
+	 result of formatting the formatted time may change, in a time zone.
+
+	 It is used to schedule refreshing of displayed results, instead of
+	 re-formatting them periodically. The result is guaranteed not to change
+	 before the returned time, while it may remain the same at that time,
+	 for example, if adjacent rules have the same result.
+
+	 @param referenced_time
+	   The current referenced time.
+
+	 @param formatted_time
+	   The target time to be formatted.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @return
+	   The next change time, which is greater than the referenced time.
+	   std::numeric_limits<std::time_t>::max() is returned if the result
+	   never changes.
+	 */
+	std::time_t NextChangeTime(std::time_t referenced_time, std::time_t formatted_time, const TimeZone& time_zone) const {
+		return internal::NextChangeTime(*expression_, referenced_time, formatted_time, time_zone);
+	}
+
+	/**
+	 Get the earliest referenced time after the specified one, at which the
+	 result of formatting the formatted time may change.
+	 */
+	std::time_t NextChangeTime(std::time_t referenced_time, std::time_t formatted_time) const {
+		return NextChangeTime(referenced_time, formatted_time, TimeZone());
+	}
+
+	/**
+	 Bind the formatter to a referenced time.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to formatted times.
+
+	 @return
+	   A bound formatter that formats times against the referenced time.
+	 */
+	BoundFormatter Bind(std::time_t referenced_time) const {
+		return Bind(referenced_time, TimeZone());
+	}
+
+	/**
+	 Bind the formatter to a referenced time in a time zone.
+
+	 @param referenced_time
+	   The referenced time that is used to compare to formatted times.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @return
+	   A bound formatter that formats times against the referenced time.
+	 */
+	BoundFormatter Bind(std::time_t referenced_time, const TimeZone& time_zone) const {
+		return BoundFormatter(expression_, referenced_time, time_zone, result_cache_);
+	}
+
+	/**
+	 Get a copy of the formatter that caches generated results.
+
+	 Results of rules without standard specifiers, whose %~ specifiers are
+	 all in the same unit, depend only on the matched rule and the value of
+	 that difference, so they are generated once and reused afterwards. It
+	 pays off when lots of times are formatted by rules such as
+	 "[-1~h,0]{%~min minutes ago}", which has only 60 distinct results.
+
+	 The cache is shared by copies of the returned formatter and the bound
+	 formatters created from it, and it is thread safe. The original
+	 formatter is not affected.
+
+	 @param capacity
+	   Maximum count of cached results. All cached results are dropped when
+	   the cache is full.
+
+	 @return
+	   A formatter that has a result cache.
+	 */
+	BasicFormatter WithResultCache(std::size_t capacity = 4096) const {
+		BasicFormatter formatter(*this);
+		formatter.result_cache_ = std::make_shared<internal::ResultCache<Char>>(*expression_, capacity);
+		return formatter;
+	}
+
+	/**
+	 Get the count of cached results, which is 0 if the formatter has no
+	 result cache.
+	 */
+	std::size_t GetCachedResultCount() const {
+		return (result_cache_ != nullptr) ? result_cache_->GetSize() : 0;
+	}
+
+	/**
+	 Serialize the parsed expression to a binary blob, which can be stored
+	 and loaded later without parsing, by Deserialize or BasicExpressionBlob.
+	 */
+	std::string Serialize() const {
+		return tiex::Serialize(expression_->ToExpression());
+	}
+
+private:
+	explicit BasicFormatter(std::shared_ptr<const CompiledExpression> expression) : expression_(std::move(expression)) {
+
+	}
+
+	bool Write(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		internal::Writer<Char>& writer,
+		std::shared_ptr<const String>* cached_text,
+		FormatError& format_error) const {
+
+		return internal::Format(
+			*expression_,
+			referenced_time,
+			formatted_time,
+			time_zone,
+			locale,
+			result_cache_.get(),
+			writer,
+			cached_text,
+			format_error);
+	}
+
+	static const std::shared_ptr<const CompiledExpression>& GetEmptyExpression() {
+		static const auto expression = std::make_shared<const CompiledExpression>(Expression());
+		return expression;
+	}
+
 private:
-	Expression expression_;
+	std::shared_ptr<const CompiledExpression> expression_;
+	std::shared_ptr<internal::ResultCache<Char>> result_cache_;
 };
 
 using Formatter = BasicFormatter<char>;
@@ -6,32 +6,21 @@ namespace internal {
     
 long GetDifferenceWithTimet(Unit unit, std::time_t referenced_time, std::time_t formatted_time) {
     
-    long difference = static_cast<long>(formatted_time - referenced_time);
-    
     switch (unit) {
-            
-        case Unit::Week:
-            difference /= 7;
-            
-        case Unit::Day:
-            difference /= 24;
-            
-        case Unit::Hour:
-            difference /= 60;
-            
-        case Unit::Minute:
-            difference /= 60;
-            
         case Unit::Second:
-            break;
-            
+            return GetDifferenceWithTimet<Unit::Second>(referenced_time, formatted_time);
+        case Unit::Minute:
+            return GetDifferenceWithTimet<Unit::Minute>(referenced_time, formatted_time);
+        case Unit::Hour:
+            return GetDifferenceWithTimet<Unit::Hour>(referenced_time, formatted_time);
+        case Unit::Day:
+            return GetDifferenceWithTimet<Unit::Day>(referenced_time, formatted_time);
+        case Unit::Week:
+            return GetDifferenceWithTimet<Unit::Week>(referenced_time, formatted_time);
         default:
             assert(false);
-            difference = 0;
-            break;
+            return 0;
     }
-    
-    return difference;
 }
     
     
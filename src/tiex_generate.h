@@ -1,11 +1,12 @@
 #pragma once
 
 #include <ctime>
-#include <iomanip>
-#include <sstream>
 #include "tiex_expression.h"
 #include "tiex_locale.h"
+#include "tiex_locale_table.h"
+#include "tiex_render.h"
 #include "tiex_time.h"
+#include "tiex_writer.h"
 
 namespace tiex {
 namespace internal {
@@ -13,21 +14,53 @@ namespace internal {
 long GetDifferenceWithTimet(Unit unit, std::time_t referenced_time, std::time_t formatted_time);
 long GetDifferenceWithTm(Unit unit, const std::tm& referenced_tm, const std::tm& formatted_tm);
 bool GetTimeDifference(Unit unit, const Time& reference_time, const Time& formatted_time, long& difference);
-    
-template<typename C>
-std::basic_string<C> ToString(int value);
 
-template<>
-inline std::string ToString<char>(int value) {
-	return std::to_string(value);
+/**
+ Get the difference in a unit of fixed length, which is known at compile
+ time. The difference is truncated toward zero.
+ */
+template<Unit U>
+long GetDifferenceWithTimet(std::time_t referenced_time, std::time_t formatted_time) {
+
+	static_assert((U != Unit::Month) && (U != Unit::Year), "Months and years are not of fixed length.");
+
+	constexpr long seconds =
+		(U == Unit::Minute) ? 60 :
+		(U == Unit::Hour) ? 60 * 60 :
+		(U == Unit::Day) ? 24 * 60 * 60 :
+		(U == Unit::Week) ? 7 * 24 * 60 * 60 :
+		1;
+
+	return static_cast<long>(formatted_time - referenced_time) / seconds;
 }
 
-template<>
-inline std::wstring ToString<wchar_t>(int value) {
-	return std::to_wstring(value);
-};
+/**
+ Get the difference in a unit that is known at compile time.
+ */
+template<Unit U>
+bool GetTimeDifference(const Time& reference_time, const Time& formatted_time, long& difference) {
 
+	if constexpr ((U == Unit::Month) || (U == Unit::Year)) {
+
+		auto referenced_tm = reference_time.GetTm();
+		if (referenced_tm == nullptr) {
+			return false;
+		}
+
+		auto formatted_tm = formatted_time.GetTm();
+		if (formatted_tm == nullptr) {
+			return false;
+		}
 
+		difference = GetDifferenceWithTm(U, *referenced_tm, *formatted_tm);
+		return true;
+	}
+	else {
+		difference = GetDifferenceWithTimet<U>(reference_time.GetTimet(), formatted_time.GetTimet());
+		return true;
+	}
+}
+    
 template<typename C>
 bool GetLocaleText(
 	C specifier_char,
@@ -119,96 +152,157 @@ bool GetLocaleText(
 
 
 template<typename C>
-bool OverrideStandardSpecifiers(const std::tm& formatted_tm, const BasicLocale<C>& locale, std::basic_string<C>& result_text) {
-
-	if ((locale.get_month == nullptr) &&
-		(locale.get_weekday == nullptr) &&
-		(locale.get_am_pm == nullptr) &&
-		(locale.get_hour == nullptr) &&
-		(locale.get_minute == nullptr) &&
-		(locale.get_second == nullptr)) {
+bool WriteLocaleText(C specifier_char, const std::tm& formatted_tm, const BasicLocale<C>& locale, Writer<C>& writer) {
+
+	std::basic_string<C> locale_text;
+	if (! GetLocaleText(specifier_char, formatted_tm, locale, locale_text)) {
 		return false;
 	}
 
-	bool has_overridden_all = true;
+	writer.Write(locale_text);
+	return true;
+}
 
-	std::size_t index = 0;
-	while (index < result_text.length() - 1) {
+/**
+ Write the localized text from a locale table, falling back to the locale
+ for texts that are not in the table.
+ */
+template<typename C>
+bool WriteLocaleText(C specifier_char, const std::tm& formatted_tm, const LocaleTable<C>& locale_table, Writer<C>& writer) {
 
-		if (result_text[index] != '%') {
-			++index;
-			continue;
-		}
+	std::basic_string_view<C> locale_text;
+	if (locale_table.Find(specifier_char, formatted_tm, locale_text)) {
+		writer.Write(locale_text.data(), locale_text.length());
+		return true;
+	}
 
-		C next_char = result_text[index + 1];
-		std::basic_string<C> override_text;
-		bool has_got = GetLocaleText(next_char, formatted_tm, locale, override_text);
-		if (! has_got) {
+	return WriteLocaleText(specifier_char, formatted_tm, locale_table.GetLocale(), writer);
+}
 
-			if (next_char != '%') {
-				has_overridden_all = false;
-			}
-			index += 2;
-			continue;
-		}
 
-		result_text.replace(index, 2, override_text);
-		index += override_text.length();
+/**
+ Generate a standard specifier, with either a locale or a locale table.
+ */
+template<typename C, typename L>
+bool GenerateStandardSpecifier(
+	char specifier_char,
+	const Time& formatted_time,
+	const L& locale,
+	Writer<C>& writer) {
+
+	auto formatted_tm = formatted_time.GetTm();
+	if (formatted_tm == nullptr) {
+		return false;
 	}
 
-	return has_overridden_all;
+	if (WriteLocaleText(static_cast<C>(specifier_char), *formatted_tm, locale, writer)) {
+		return true;
+	}
+
+	return RenderStandardSpecifier(specifier_char, *formatted_tm, formatted_time, writer);
 }
-    
 
-template<typename C>
-bool GenerateResultText(
-	const BasicResult<C>& result,
+
+/**
+ Execute an instruction, whose literal offset refers to the literal pool.
+ Localized texts come from either a locale or a locale table.
+ */
+template<typename C, typename L>
+bool GenerateInstruction(
+	const C* literals,
+	const Instruction& instruction,
 	const Time& reference_time,
 	const Time& formatted_time,
-	const BasicLocale<C>& locale,
-	std::basic_string<C>& text) {
+	const L& locale,
+	Writer<C>& writer) {
 
-	std::basic_string<C> result_text;
+	switch (instruction.code) {
 
-	for (std::size_t index = 0; index < result.texts.size(); ++index) {
+	case Instruction::Code::Literal:
+		writer.WritePersistent(literals + instruction.offset, instruction.length);
+		return true;
 
-		const auto& each_text = result.texts[index];
-		if (each_text.empty()) {
+	case Instruction::Code::Field:
+		return GenerateStandardSpecifier(instruction.specifier.standard_char, formatted_time, locale, writer);
 
-			auto iterator = result.specifiers.find(index);
-			if (iterator != result.specifiers.end()) {
+	case Instruction::Code::Difference: {
 
-				long difference = 0;
-				bool is_succeeded = GetTimeDifference(iterator->second.unit, reference_time, formatted_time, difference);
-				if (!is_succeeded) {
-					return false;
-				}
-
-				result_text.append(ToString<C>(std::abs(difference)));
-			}
-		}
-		else {
-			result_text.append(each_text);
+		long difference = 0;
+		bool is_succeeded = GetTimeDifference(instruction.specifier.unit, reference_time, formatted_time, difference);
+		if (! is_succeeded) {
+			return false;
 		}
+
+		WriteNumber(
+			(difference < 0) ? (0ull - static_cast<unsigned long long>(difference)) : static_cast<unsigned long long>(difference),
+			writer);
+		return true;
 	}
 
-	if (result.has_standard_specifiers) {
+	default:
+		return false;
+	}
+}
 
-		auto formatted_tm = formatted_time.GetTm();
-		if (formatted_tm == nullptr) {
+
+/**
+ Execute a sequence of instructions, whose literal offsets refer to the
+ literal pool.
+ */
+template<typename C, typename L>
+bool GenerateInstructions(
+	const C* literals,
+	const Instruction* instructions,
+	std::size_t instruction_count,
+	const Time& reference_time,
+	const Time& formatted_time,
+	const L& locale,
+	Writer<C>& writer) {
+
+	for (std::size_t index = 0; index < instruction_count; ++index) {
+		if (! GenerateInstruction(literals, instructions[index], reference_time, formatted_time, locale, writer)) {
 			return false;
 		}
+	}
 
-		bool has_overridden_all = OverrideStandardSpecifiers(*formatted_tm, locale, result_text);
-		if (! has_overridden_all) {
+	return true;
+}
 
-			std::basic_ostringstream<C> stream;
-			stream << std::put_time(formatted_tm, result_text.c_str());
-			result_text = stream.str();
-		}
+
+template<typename C>
+bool GenerateResult(
+	const BasicResult<C>& result,
+	const Time& reference_time,
+	const Time& formatted_time,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer) {
+
+	return GenerateInstructions(
+		result.literals.data(),
+		result.instructions.data(),
+		result.instructions.size(),
+		reference_time,
+		formatted_time,
+		locale,
+		writer);
+}
+
+
+template<typename C>
+bool GenerateResultText(
+	const BasicResult<C>& result,
+	const Time& reference_time,
+	const Time& formatted_time,
+	const BasicLocale<C>& locale,
+	std::basic_string<C>& text) {
+
+	std::basic_string<C> result_text;
+	StringWriter<C> writer(result_text);
+	if (! GenerateResult(result, reference_time, formatted_time, locale, writer)) {
+		return false;
 	}
 
-	text = result_text;
+	text = std::move(result_text);
 	return true;
 }
     
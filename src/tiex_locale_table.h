@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include "tiex_locale.h"
+
+namespace tiex {
+namespace internal {
+
+/**
+ A table of localized texts that are rendered from a locale in advance.
+
+ Each callback of the locale has a small, finite domain: 12 months and 7
+ weekdays in each of their options, 24 hours and 12 hours, 60 minutes, 60
+ seconds, a.m. and p.m.. All of them are rendered once when the table is
+ constructed, and stored in one contiguous string, so looking up a
+ text is an index into the table, without calling std::function or
+ allocating memory.
+
+ Values out of the domains, such as a leap second, are not in the table,
+ they are left to the locale, which the table refers to and must outlive
+ the table.
+ */
+template<typename C>
+class LocaleTable {
+public:
+	using Char = C;
+	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
+	using Locale = BasicLocale<Char>;
+
+public:
+	explicit LocaleTable(const Locale& locale) : locale_(locale) {
+
+		if (locale.get_minute != nullptr) {
+			for (int minute = 0; minute < 60; ++minute) {
+				AddText(MinuteSlot + minute, locale.get_minute(minute));
+			}
+		}
+
+		if (locale.get_second != nullptr) {
+			for (int second = 0; second < 60; ++second) {
+				AddText(SecondSlot + second, locale.get_second(second));
+			}
+		}
+
+		if (locale.get_hour != nullptr) {
+
+			typename Locale::HourOptions options;
+			for (int hour = 0; hour < 24; ++hour) {
+				AddText(HourSlot + hour, locale.get_hour(hour, options));
+			}
+
+			options.is_12_hour_clock = true;
+			for (int hour = 1; hour <= 12; ++hour) {
+				AddText(Hour12Slot + hour - 1, locale.get_hour(hour, options));
+			}
+		}
+
+		if (locale.get_am_pm != nullptr) {
+			AddText(AmPmSlot, locale.get_am_pm(false));
+			AddText(AmPmSlot + 1, locale.get_am_pm(true));
+		}
+
+		if (locale.get_weekday != nullptr) {
+
+			typename Locale::WeekdayOptions options;
+			for (int weekday = 0; weekday < 7; ++weekday) {
+				AddText(WeekdaySlot + weekday, locale.get_weekday(weekday, options));
+			}
+
+			options.is_abbreviated = true;
+			for (int weekday = 0; weekday < 7; ++weekday) {
+				AddText(AbbreviatedWeekdaySlot + weekday, locale.get_weekday(weekday, options));
+			}
+		}
+
+		if (locale.get_month != nullptr) {
+
+			typename Locale::MonthOptions options;
+			for (int month = 1; month <= 12; ++month) {
+				AddText(MonthSlot + month - 1, locale.get_month(month, options));
+			}
+
+			options.is_abbreviated = true;
+			for (int month = 1; month <= 12; ++month) {
+				AddText(AbbreviatedMonthSlot + month - 1, locale.get_month(month, options));
+			}
+
+			options.is_number = true;
+			options.is_abbreviated = false;
+			for (int month = 1; month <= 12; ++month) {
+				AddText(NumberMonthSlot + month - 1, locale.get_month(month, options));
+			}
+		}
+	}
+
+	LocaleTable(const LocaleTable&) = delete;
+	LocaleTable& operator=(const LocaleTable&) = delete;
+
+	/**
+	 Find the localized text of a specifier.
+
+	 @return
+	   False if the text is not in the table, either because the locale
+	   has no callback for the specifier, or because the value is out of the
+	   domain of the callback.
+	 */
+	bool Find(Char specifier_char, const std::tm& formatted_tm, StringView& text) const {
+
+		std::size_t slot = 0;
+		if (! GetSlot(specifier_char, formatted_tm, slot)) {
+			return false;
+		}
+
+		const auto& entry = entries_[slot];
+		if (! entry.has_text) {
+			return false;
+		}
+
+		text = StringView(texts_.data() + entry.offset, entry.length);
+		return true;
+	}
+
+	/**
+	 Get the locale that the table is rendered from.
+	 */
+	const Locale& GetLocale() const {
+		return locale_;
+	}
+
+private:
+	static constexpr std::size_t MinuteSlot = 0;
+	static constexpr std::size_t SecondSlot = MinuteSlot + 60;
+	static constexpr std::size_t HourSlot = SecondSlot + 60;
+	static constexpr std::size_t Hour12Slot = HourSlot + 24;
+	static constexpr std::size_t AmPmSlot = Hour12Slot + 12;
+	static constexpr std::size_t WeekdaySlot = AmPmSlot + 2;
+	static constexpr std::size_t AbbreviatedWeekdaySlot = WeekdaySlot + 7;
+	static constexpr std::size_t MonthSlot = AbbreviatedWeekdaySlot + 7;
+	static constexpr std::size_t AbbreviatedMonthSlot = MonthSlot + 12;
+	static constexpr std::size_t NumberMonthSlot = AbbreviatedMonthSlot + 12;
+	static constexpr std::size_t SlotCount = NumberMonthSlot + 12;
+
+	class Entry {
+	public:
+		std::size_t offset = 0;
+		std::size_t length = 0;
+		bool has_text = false;
+	};
+
+private:
+	/**
+	 Map a specifier to its slot, in the same way as GetLocaleText calls
+	 the callbacks.
+	 */
+	static bool GetSlot(Char specifier_char, const std::tm& formatted_tm, std::size_t& slot) {
+
+		auto map = [&slot](std::size_t base, int value, int count) {
+			if ((value < 0) || (value >= count)) {
+				return false;
+			}
+			slot = base + value;
+			return true;
+		};
+
+		switch (specifier_char) {
+		case 'M':
+			return map(MinuteSlot, formatted_tm.tm_min, 60);
+		case 'S':
+			return map(SecondSlot, formatted_tm.tm_sec, 60);
+		case 'H':
+			return map(HourSlot, formatted_tm.tm_hour, 24);
+		case 'I':
+			if ((formatted_tm.tm_hour < 0) || (formatted_tm.tm_hour >= 24)) {
+				return false;
+			}
+			return map(Hour12Slot, (formatted_tm.tm_hour + 11) % 12, 12);
+		case 'p':
+			return map(AmPmSlot, (formatted_tm.tm_hour >= 12) ? 1 : 0, 2);
+		case 'A':
+			return map(WeekdaySlot, formatted_tm.tm_wday, 7);
+		case 'a':
+			return map(AbbreviatedWeekdaySlot, formatted_tm.tm_wday, 7);
+		case 'B':
+			return map(MonthSlot, formatted_tm.tm_mon, 12);
+		case 'b':
+		case 'h':
+			return map(AbbreviatedMonthSlot, formatted_tm.tm_mon, 12);
+		case 'm':
+			return map(NumberMonthSlot, formatted_tm.tm_mon, 12);
+		default:
+			return false;
+		}
+	}
+
+	void AddText(std::size_t slot, const String& text) {
+
+		auto& entry = entries_[slot];
+		entry.offset = texts_.length();
+		entry.length = text.length();
+		entry.has_text = true;
+		texts_.append(text);
+	}
+
+private:
+	const Locale& locale_;
+	std::array<Entry, SlotCount> entries_{};
+	String texts_;
+};
+
+}
+}
@@ -1,4 +1,5 @@
 #include "tiex_match.h"
+#include <limits>
 
 namespace tiex {
 namespace internal {
@@ -6,75 +7,29 @@ namespace {
     
 std::tm AdjuatTm(const std::tm& tm, const Boundary& boundary) {
     
-    if (boundary.value == 0) {
-        return tm;
-    }
-    
-    int adjusted_value = boundary.value;
-    if (boundary.round && (boundary.unit != Unit::Second)) {
-        if (adjusted_value < 0) {
-            ++adjusted_value;
-        }
-    }
-    
-    auto adjusted_tm = tm;
-    
     switch (boundary.unit) {
         case Unit::Second:
-            adjusted_tm.tm_sec += adjusted_value;
-            break;
+            return AdjustTm<Unit::Second>(tm, boundary.value, boundary.round);
         case Unit::Minute:
-            adjusted_tm.tm_min += adjusted_value;
-            break;
+            return AdjustTm<Unit::Minute>(tm, boundary.value, boundary.round);
         case Unit::Hour:
-            adjusted_tm.tm_hour += adjusted_value;
-            break;
+            return AdjustTm<Unit::Hour>(tm, boundary.value, boundary.round);
         case Unit::Day:
-            adjusted_tm.tm_mday += adjusted_value;
-            break;
+            return AdjustTm<Unit::Day>(tm, boundary.value, boundary.round);
         case Unit::Week:
-            adjusted_tm.tm_mday += adjusted_value * 7;
-            break;
+            return AdjustTm<Unit::Week>(tm, boundary.value, boundary.round);
         case Unit::Month:
-            adjusted_tm.tm_mon += adjusted_value;
-            break;
+            return AdjustTm<Unit::Month>(tm, boundary.value, boundary.round);
         case Unit::Year:
-            adjusted_tm.tm_year += adjusted_value;
-            break;
+            return AdjustTm<Unit::Year>(tm, boundary.value, boundary.round);
         default:
-            break;
+            return tm;
     }
-    
-    if (boundary.round) {
-        
-        switch (boundary.unit) {
-            case Unit::Year:
-                adjusted_tm.tm_mon = 0;
-            case Unit::Month:
-                adjusted_tm.tm_mday = 1;
-            case Unit::Week:
-            case Unit::Day:
-                adjusted_tm.tm_hour = 0;
-            case Unit::Hour:
-                adjusted_tm.tm_min = 0;
-            case Unit::Minute:
-                adjusted_tm.tm_sec = 0;
-                break;
-            default:
-                break;
-        }
-        
-        if (boundary.unit == Unit::Week) {
-            adjusted_tm.tm_mday -= tm.tm_wday;
-        }
-    }
-    
-    return adjusted_tm;
 }
     
 }
     
-bool MakeBoundaryTime(const Boundary& boundary, const std::tm& tm, std::time_t& time) {
+bool MakeBoundaryTime(const Boundary& boundary, const std::tm& tm, const TimeZone& time_zone, std::time_t& time) {
     
     if (boundary.value == std::numeric_limits<int>::min()) {
         time = std::numeric_limits<std::time_t>::min();
@@ -87,36 +42,22 @@ bool MakeBoundaryTime(const Boundary& boundary, const std::tm& tm, std::time_t&
     }
     
     auto adjusted_tm = AdjuatTm(tm, boundary);
+    return time_zone.MakeTime(adjusted_tm, time);
+}
     
-    auto converted_tm = adjusted_tm;
-    time = std::mktime(&converted_tm);
-    
-    if (time != -1) {
-        return true;
-    }
-    
-    //Check for error
-    
-    //No adjustment was maked to tm, so no error could happend.
-    if (boundary.value == 0) {
-        return true;
-    }
+
+bool ResolveCondition(
+    const Condition& condition,
+    const std::tm& referenced_tm,
+    const TimeZone& time_zone,
+    std::time_t& backward_time,
+    std::time_t& forward_time) {
     
-    //if std::mktime succeeds, tm would be modified, so check
-    //for modifications to determinate success.
-    bool is_changed =
-        (adjusted_tm.tm_sec != converted_tm.tm_sec) ||
-        (adjusted_tm.tm_min != converted_tm.tm_min) ||
-        (adjusted_tm.tm_hour != converted_tm.tm_hour) ||
-        (adjusted_tm.tm_mday != converted_tm.tm_mday) ||
-        (adjusted_tm.tm_mon != converted_tm.tm_mon) ||
-        (adjusted_tm.tm_year != converted_tm.tm_year);
-    
-    if (is_changed) {
-        return true;
+    if (! MakeBoundaryTime(condition.backward, referenced_tm, time_zone, backward_time)) {
+        return false;
     }
     
-    return false;
+    return MakeBoundaryTime(condition.forward, referenced_tm, time_zone, forward_time);
 }
     
     
@@ -135,8 +76,10 @@ bool MatchCondition(
     
     auto formatted_timet = formatted_time.GetTimet();
     
+    const auto& time_zone = referenced_time.GetTimeZone();
+    
     std::time_t backward_time = 0;
-    bool is_succeeded = internal::MakeBoundaryTime(condition.backward, *referenced_tm, backward_time);
+    bool is_succeeded = internal::MakeBoundaryTime(condition.backward, *referenced_tm, time_zone, backward_time);
     if (! is_succeeded) {
         return false;
     }
@@ -144,7 +87,7 @@ bool MatchCondition(
     if (backward_time <= formatted_timet) {
         
         std::time_t forward_time = 0;
-        is_succeeded = internal::MakeBoundaryTime(condition.forward, *referenced_tm, forward_time);
+        is_succeeded = internal::MakeBoundaryTime(condition.forward, *referenced_tm, time_zone, forward_time);
         if (! is_succeeded) {
             return false;
         }
@@ -1,13 +1,100 @@
 #pragma once
 
+#include <cstddef>
 #include <ctime>
+#include "tiex_civil.h"
+#include "tiex_error.h"
 #include "tiex_expression.h"
 #include "tiex_time.h"
 
 namespace tiex {
 namespace internal {
 
-bool MakeBoundaryTime(const Boundary& boundary, const std::tm& tm, std::time_t& time);
+/**
+ Adjust a broken-down referenced time by the value of a boundary, whose
+ unit is known at compile time. If round is true, the adjusted time is
+ rounded down to the start of the unit.
+
+ The returned tm may be out of the normal range, it is normalized when
+ converted to time_t.
+ */
+template<Unit U>
+std::tm AdjustTm(const std::tm& tm, int value, bool round) {
+
+    if (value == 0) {
+        return tm;
+    }
+
+    int adjusted_value = value;
+    if ((U != Unit::Second) && round && (adjusted_value < 0)) {
+        ++adjusted_value;
+    }
+
+    auto adjusted_tm = tm;
+
+    if constexpr (U == Unit::Second) {
+        adjusted_tm.tm_sec += adjusted_value;
+    }
+    else if constexpr (U == Unit::Minute) {
+        adjusted_tm.tm_min += adjusted_value;
+    }
+    else if constexpr (U == Unit::Hour) {
+        adjusted_tm.tm_hour += adjusted_value;
+    }
+    else if constexpr (U == Unit::Day) {
+        adjusted_tm.tm_mday += adjusted_value;
+    }
+    else if constexpr (U == Unit::Week) {
+        adjusted_tm.tm_mday += adjusted_value * 7;
+    }
+    else if constexpr (U == Unit::Month) {
+        adjusted_tm.tm_mon += adjusted_value;
+    }
+    else if constexpr (U == Unit::Year) {
+        adjusted_tm.tm_year += adjusted_value;
+    }
+
+    if ((U == Unit::Second) || (! round)) {
+        return adjusted_tm;
+    }
+
+    if constexpr (U == Unit::Year) {
+        adjusted_tm.tm_mon = 0;
+    }
+    if constexpr ((U == Unit::Year) || (U == Unit::Month)) {
+        adjusted_tm.tm_mday = 1;
+    }
+    if constexpr ((U != Unit::Hour) && (U != Unit::Minute)) {
+        adjusted_tm.tm_hour = 0;
+    }
+    if constexpr (U != Unit::Minute) {
+        adjusted_tm.tm_min = 0;
+    }
+    adjusted_tm.tm_sec = 0;
+
+    if constexpr (U == Unit::Week) {
+        adjusted_tm.tm_mday -= GetWeekday(DaysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday));
+    }
+
+    return adjusted_tm;
+}
+
+bool MakeBoundaryTime(const Boundary& boundary, const std::tm& tm, const TimeZone& time_zone, std::time_t& time);
+
+inline bool MakeBoundaryTime(const Boundary& boundary, const std::tm& tm, std::time_t& time) {
+    return MakeBoundaryTime(boundary, tm, GetLocalTimeZone(), time);
+}
+    
+/**
+ Resolve both boundaries of a condition to absolute times, against the
+ broken-down referenced time in the time zone.
+ */
+bool ResolveCondition(
+    const Condition& condition,
+    const std::tm& referenced_tm,
+    const TimeZone& time_zone,
+    std::time_t& backward_time,
+    std::time_t& forward_time);
     
 bool MatchCondition(
     const Condition& condition,
@@ -15,5 +102,49 @@ bool MatchCondition(
     const Time& formatted_time,
     bool& is_matched);
 
+/**
+ Generate the result of the first rule whose condition matches the
+ formatted time, which is shared by all kinds of expressions.
+
+ @param get_condition
+   Gets the condition of a rule by its index.
+
+ @param generate_rule
+   Generates the result of a rule by its index, returns whether it is
+   succeeded.
+ */
+template<typename ConditionGetter, typename RuleGenerator>
+bool FormatFirstMatchedRule(
+    std::size_t rule_count,
+    const ConditionGetter& get_condition,
+    const Time& referenced_time,
+    const Time& formatted_time,
+    const RuleGenerator& generate_rule,
+    FormatError& format_error) {
+
+    for (std::size_t index = 0; index < rule_count; ++index) {
+
+        bool is_matched = false;
+        bool is_succeeded = MatchCondition(get_condition(index), referenced_time, formatted_time, is_matched);
+        if (! is_succeeded) {
+            format_error.status = FormatError::Status::TimeError;
+            return false;
+        }
+
+        if (is_matched) {
+
+            if (! generate_rule(index)) {
+                format_error.status = FormatError::Status::TimeError;
+                return false;
+            }
+
+            return true;
+        }
+    }
+
+    format_error.status = FormatError::Status::NoMatchedRule;
+    return false;
+}
+
 }
 }
@@ -0,0 +1,675 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "tiex_formatter.h"
+#include "tiex_generate.h"
+#include "tiex_match.h"
+
+namespace tiex {
+namespace internal {
+namespace {
+
+/**
+ The farthest distance from the referenced time to search changes, about
+ 2000 years, beyond which the output is considered never changing.
+ */
+const std::int64_t MaxSearchDistance = std::int64_t(1) << 36;
+
+
+/**
+ Find the first time after the specified time, at which the value got by
+ get_value differs from the one at the specified time.
+
+ The value must be monotone over time, that is, once it changes, it never
+ changes back; so the change is found by an exponential search followed
+ by a binary search, with O(log(distance)) evaluations.
+
+ @return
+   Whether a change is found.
+ */
+template<typename Value, typename ValueGetter>
+bool FindNextChange(std::time_t time, const ValueGetter& get_value, std::time_t& change_time) {
+
+    Value value{};
+    if (! get_value(time, value)) {
+        return false;
+    }
+
+    auto is_changed_at_distance = [&](std::int64_t distance, bool& is_changed) {
+
+        if (static_cast<std::int64_t>(std::numeric_limits<std::time_t>::max()) - distance < time) {
+            return false;
+        }
+
+        Value distant_value{};
+        if (! get_value(static_cast<std::time_t>(time + distance), distant_value)) {
+            return false;
+        }
+
+        is_changed = (distant_value != value);
+        return true;
+    };
+
+    //The value at low_distance is the same, and the one at high_distance
+    //is changed.
+    std::int64_t low_distance = 0;
+    std::int64_t high_distance = 1;
+
+    while (true) {
+
+        bool is_changed = false;
+        if (! is_changed_at_distance(high_distance, is_changed)) {
+            return false;
+        }
+
+        if (is_changed) {
+            break;
+        }
+
+        low_distance = high_distance;
+        high_distance *= 2;
+        if (high_distance > MaxSearchDistance) {
+            return false;
+        }
+    }
+
+    while (high_distance - low_distance > 1) {
+
+        auto middle_distance = low_distance + (high_distance - low_distance) / 2;
+
+        bool is_changed = false;
+        if (! is_changed_at_distance(middle_distance, is_changed)) {
+            return false;
+        }
+
+        if (is_changed) {
+            high_distance = middle_distance;
+        }
+        else {
+            low_distance = middle_distance;
+        }
+    }
+
+    change_time = static_cast<std::time_t>(time + high_distance);
+    return true;
+}
+
+
+/**
+ The number of corrections tried on a computed change time, before falling
+ back to searching.
+ */
+const int MaxCorrectionCount = 4;
+
+
+bool AddSeconds(std::time_t time, std::int64_t seconds, std::time_t& result) {
+
+    if ((seconds > 0) && (static_cast<std::int64_t>(std::numeric_limits<std::time_t>::max()) - seconds < time)) {
+        return false;
+    }
+
+    if ((seconds < 0) && (static_cast<std::int64_t>(std::numeric_limits<std::time_t>::min()) - seconds > time)) {
+        return false;
+    }
+
+    result = static_cast<std::time_t>(time + seconds);
+    return true;
+}
+
+
+bool MakeBoundaryTimeAt(
+    const Boundary& boundary,
+    std::time_t referenced_time,
+    const TimeZone& time_zone,
+    std::time_t& boundary_time) {
+
+    Time referenced(referenced_time, time_zone);
+    auto referenced_tm = referenced.GetTm();
+    if (referenced_tm == nullptr) {
+        return false;
+    }
+
+    return MakeBoundaryTime(boundary, *referenced_tm, time_zone, boundary_time);
+}
+
+
+/**
+ Get the start of the period of a unit that contains the time, or the
+ start of the next one.
+ */
+bool GetPeriodStart(Unit unit, std::time_t time, bool is_next, const TimeZone& time_zone, std::time_t& start_time) {
+
+    Boundary boundary;
+    boundary.unit = unit;
+    boundary.round = true;
+    boundary.value = is_next ? 1 : -1;
+    return MakeBoundaryTimeAt(boundary, time, time_zone, start_time);
+}
+
+
+/**
+ Find the first referenced time after the specified one, at which the time
+ of a boundary reaches the target time.
+
+ A boundary is a shift of the referenced time by whole units, so the
+ referenced time is moved by the distance from the boundary time to the
+ target, and a rounded boundary is moved to the rollover of its unit. The
+ result is verified by resolving the boundary at it and right before it,
+ and corrected a few times for transitions of the time zone and lengths of
+ months; searching is the last resort.
+
+ @param boundary_time
+   The time of the boundary at the referenced time, which is before the
+   target time.
+ */
+bool FindBoundaryReachTime(
+    const Boundary& boundary,
+    std::time_t referenced_time,
+    std::time_t boundary_time,
+    std::time_t target_time,
+    const TimeZone& time_zone,
+    std::time_t& reach_time) {
+
+    //Infinite boundaries never move.
+    if ((boundary.value == std::numeric_limits<int>::min()) ||
+        (boundary.value == std::numeric_limits<int>::max())) {
+        return false;
+    }
+
+    bool is_stepped = boundary.round && (boundary.unit != Unit::Second);
+
+    //The earliest referenced time later than the time, at which the boundary
+    //may move.
+    auto get_next_time = [&](std::time_t time, std::time_t& next_time) {
+        if (is_stepped) {
+            return GetPeriodStart(boundary.unit, time, true, time_zone, next_time);
+        }
+        return AddSeconds(time, 1, next_time);
+    };
+
+    std::int64_t distance = static_cast<std::int64_t>(target_time) - boundary_time;
+
+    std::time_t candidate_time = 0;
+    if (is_stepped) {
+
+        //The boundary is the same for the whole period of the referenced
+        //time, so the rollover is found from the start of the period.
+        std::time_t period_start_time = 0;
+        std::time_t shifted_time = 0;
+        if (! GetPeriodStart(boundary.unit, referenced_time, false, time_zone, period_start_time) ||
+            ! AddSeconds(period_start_time, distance - 1, shifted_time) ||
+            ! get_next_time(shifted_time, candidate_time)) {
+            return false;
+        }
+    }
+    else if (! AddSeconds(referenced_time, distance, candidate_time)) {
+        return false;
+    }
+
+    for (int count = 0; count < MaxCorrectionCount; ++count) {
+
+        if ((candidate_time <= referenced_time) && ! get_next_time(referenced_time, candidate_time)) {
+            return false;
+        }
+
+        std::time_t candidate_boundary_time = 0;
+        if (! MakeBoundaryTimeAt(boundary, candidate_time, time_zone, candidate_boundary_time)) {
+            return false;
+        }
+
+        if (candidate_boundary_time < target_time) {
+
+            if (is_stepped) {
+                if (! get_next_time(candidate_time, candidate_time)) {
+                    return false;
+                }
+            }
+            else if (! AddSeconds(candidate_time, static_cast<std::int64_t>(target_time) - candidate_boundary_time, candidate_time)) {
+                return false;
+            }
+            continue;
+        }
+
+        //The boundary must not reach the target before the candidate.
+        std::time_t previous_time = candidate_time - 1;
+        if (is_stepped) {
+            if (! GetPeriodStart(boundary.unit, candidate_time - 1, false, time_zone, previous_time)) {
+                return false;
+            }
+        }
+
+        if (previous_time <= referenced_time) {
+            reach_time = candidate_time;
+            return true;
+        }
+
+        std::time_t previous_boundary_time = 0;
+        if (! MakeBoundaryTimeAt(boundary, previous_time, time_zone, previous_boundary_time)) {
+            return false;
+        }
+
+        if (previous_boundary_time < target_time) {
+            reach_time = candidate_time;
+            return true;
+        }
+
+        candidate_time = is_stepped ? previous_time : previous_time - (previous_boundary_time - target_time);
+    }
+
+    auto is_reached = [&](std::time_t time, bool& value) {
+        std::time_t time_of_boundary = 0;
+        if (! MakeBoundaryTimeAt(boundary, time, time_zone, time_of_boundary)) {
+            return false;
+        }
+        value = (time_of_boundary >= target_time);
+        return true;
+    };
+    return FindNextChange<bool>(referenced_time, is_reached, reach_time);
+}
+
+
+/**
+ Whether a boundary shifts the referenced time by months or years without
+ rounding, so its day of month may be out of the range of the shifted
+ month and normalized into the next one.
+
+ The time of such a boundary only moves forward within a month of the
+ referenced time. At the start of a month it may jump in either direction:
+ Mar 30 - 1 month is normalized to Mar 2, while Apr 1 - 1 month is Mar 1.
+ */
+bool IsNormalizedBoundary(const Boundary& boundary) {
+
+    return
+        (! boundary.round) &&
+        ((boundary.unit == Unit::Month) || (boundary.unit == Unit::Year)) &&
+        (boundary.value != std::numeric_limits<int>::min()) &&
+        (boundary.value != std::numeric_limits<int>::max());
+}
+
+
+/**
+ Get the start of a month, which is counted in months from the year 1900.
+ */
+bool GetMonthStart(std::int64_t month, const TimeZone& time_zone, std::time_t& start_time) {
+
+    std::int64_t year = (month >= 0) ? (month / 12) : ((month - 11) / 12);
+    if ((year < std::numeric_limits<int>::min()) || (year > std::numeric_limits<int>::max())) {
+        return false;
+    }
+
+    std::tm tm{};
+    tm.tm_year = static_cast<int>(year);
+    tm.tm_mon = static_cast<int>(month - year * 12);
+    tm.tm_mday = 1;
+    tm.tm_isdst = -1;
+    return time_zone.MakeTime(tm, start_time);
+}
+
+
+/**
+ Find the first referenced time after the specified one, at which whether
+ the time of a normalized boundary reaches the target time changes.
+
+ Once reached, the boundary can only fall behind the target at the start
+ of the next month, since it starts from the first day of the shifted
+ month there and moves forward after that. Otherwise, the boundary reaches
+ the target within the month of the referenced time that is shifted to
+ the month before the target, or the one shifted to the month of the
+ target, or at the start of the month after them. The time in the month
+ is found by a binary search, as the boundary is monotone within it.
+
+ @param boundary_time
+   The time of the boundary at the referenced time.
+ */
+bool FindNormalizedBoundaryChange(
+    const Boundary& boundary,
+    std::time_t referenced_time,
+    std::time_t boundary_time,
+    std::time_t target_time,
+    const TimeZone& time_zone,
+    std::time_t& change_time) {
+
+    auto is_reached_at = [&](std::time_t time, bool& is_reached) {
+        std::time_t time_of_boundary = 0;
+        if (! MakeBoundaryTimeAt(boundary, time, time_zone, time_of_boundary)) {
+            return false;
+        }
+        is_reached = (time_of_boundary >= target_time);
+        return true;
+    };
+
+    if (boundary_time >= target_time) {
+
+        std::time_t month_start_time = 0;
+        bool is_reached = false;
+        if (! GetPeriodStart(Unit::Month, referenced_time, true, time_zone, month_start_time) ||
+            ! is_reached_at(month_start_time, is_reached) ||
+            is_reached) {
+            return false;
+        }
+
+        change_time = month_start_time;
+        return true;
+    }
+
+    Time target(target_time, time_zone);
+    auto target_tm = target.GetTm();
+    if (target_tm == nullptr) {
+        return false;
+    }
+
+    std::int64_t shifted_months = boundary.value;
+    if (boundary.unit == Unit::Year) {
+        shifted_months *= 12;
+    }
+
+    std::int64_t target_month = static_cast<std::int64_t>(target_tm->tm_year) * 12 + target_tm->tm_mon;
+
+    for (std::int64_t offset = -1; offset <= 1; ++offset) {
+
+        std::int64_t month = target_month - shifted_months + offset;
+
+        std::time_t month_start_time = 0;
+        std::time_t next_month_start_time = 0;
+        if (! GetMonthStart(month, time_zone, month_start_time) ||
+            ! GetMonthStart(month + 1, time_zone, next_month_start_time)) {
+            return false;
+        }
+
+        if (next_month_start_time - 1 <= referenced_time) {
+            continue;
+        }
+
+        std::time_t low_time = std::max(month_start_time, static_cast<std::time_t>(referenced_time + 1));
+        std::time_t high_time = next_month_start_time - 1;
+
+        bool is_reached = false;
+        if (! is_reached_at(high_time, is_reached)) {
+            return false;
+        }
+
+        if (! is_reached) {
+            continue;
+        }
+
+        while (low_time < high_time) {
+
+            std::time_t middle_time = low_time + (high_time - low_time) / 2;
+            if (! is_reached_at(middle_time, is_reached)) {
+                return false;
+            }
+
+            if (is_reached) {
+                high_time = middle_time;
+            }
+            else {
+                low_time = middle_time + 1;
+            }
+        }
+
+        change_time = low_time;
+        return true;
+    }
+
+    return false;
+}
+
+
+std::int64_t GetUnitSeconds(Unit unit) {
+
+    switch (unit) {
+        case Unit::Minute:
+            return 60;
+        case Unit::Hour:
+            return 60 * 60;
+        case Unit::Day:
+            return 24 * 60 * 60;
+        case Unit::Week:
+            return 7 * 24 * 60 * 60;
+        default:
+            return 1;
+    }
+}
+
+
+/**
+ Find the first referenced time after the specified one, at which the
+ difference in a unit between the referenced time and the formatted time
+ changes.
+
+ Differences in fixed units are truncated quotients, which change at the
+ multiples of the unit from the formatted time. Differences in months and
+ years change when the day and time of the referenced time pass those of
+ the formatted time, or when it rolls over to a new month or year, so the
+ few such times in the near future are checked in order.
+ */
+bool FindDifferenceChange(
+    Unit unit,
+    std::time_t referenced_time,
+    std::time_t formatted_time,
+    const TimeZone& time_zone,
+    std::time_t& change_time) {
+
+    if ((unit != Unit::Month) && (unit != Unit::Year)) {
+
+        std::int64_t unit_seconds = GetUnitSeconds(unit);
+        std::int64_t distance = static_cast<std::int64_t>(formatted_time) - referenced_time;
+        std::int64_t difference = distance / unit_seconds;
+
+        //The difference decreases while the referenced time increases, and
+        //0 covers the longest period since it is truncated toward zero.
+        if (difference > 0) {
+            return AddSeconds(formatted_time, -difference * unit_seconds + 1, change_time);
+        }
+        return AddSeconds(formatted_time, (-distance / unit_seconds + 1) * unit_seconds, change_time);
+    }
+
+    Time formatted(formatted_time, time_zone);
+    auto formatted_tm = formatted.GetTm();
+    if (formatted_tm == nullptr) {
+        return false;
+    }
+
+    Time referenced(referenced_time, time_zone);
+    auto referenced_tm = referenced.GetTm();
+    if (referenced_tm == nullptr) {
+        return false;
+    }
+
+    auto get_difference = [&](std::time_t time, long& difference) {
+        Time time_object(time, time_zone);
+        return GetTimeDifference(unit, time_object, formatted, difference);
+    };
+
+    long difference = 0;
+    if (! get_difference(referenced_time, difference)) {
+        return false;
+    }
+
+    std::vector<std::time_t> candidate_times;
+    for (int period = 0; period <= 1; ++period) {
+
+        std::tm passing_tm = *referenced_tm;
+        passing_tm.tm_isdst = -1;
+        passing_tm.tm_mday = formatted_tm->tm_mday;
+        passing_tm.tm_hour = formatted_tm->tm_hour;
+        passing_tm.tm_min = formatted_tm->tm_min;
+        passing_tm.tm_sec = formatted_tm->tm_sec;
+        if (unit == Unit::Month) {
+            passing_tm.tm_mon += period;
+        }
+        else {
+            passing_tm.tm_year += period;
+            passing_tm.tm_mon = formatted_tm->tm_mon;
+        }
+
+        std::time_t passing_time = 0;
+        if (time_zone.MakeTime(passing_tm, passing_time)) {
+            candidate_times.push_back(passing_time);
+            if (passing_time < std::numeric_limits<std::time_t>::max()) {
+                candidate_times.push_back(passing_time + 1);
+            }
+        }
+
+        Boundary rollover;
+        rollover.unit = unit;
+        rollover.round = true;
+        rollover.value = period + 1;
+
+        std::time_t rollover_time = 0;
+        if (MakeBoundaryTime(rollover, *referenced_tm, time_zone, rollover_time)) {
+            candidate_times.push_back(rollover_time);
+        }
+    }
+
+    std::sort(candidate_times.begin(), candidate_times.end());
+
+    for (auto each_time : candidate_times) {
+
+        if (each_time <= referenced_time) {
+            continue;
+        }
+
+        long candidate_difference = 0;
+        if (! get_difference(each_time, candidate_difference)) {
+            break;
+        }
+
+        if (candidate_difference == difference) {
+            continue;
+        }
+
+        long previous_difference = difference;
+        if ((each_time - 1 > referenced_time) && ! get_difference(each_time - 1, previous_difference)) {
+            break;
+        }
+
+        if (previous_difference == difference) {
+            change_time = each_time;
+            return true;
+        }
+        break;
+    }
+
+    return FindNextChange<long>(referenced_time, get_difference, change_time);
+}
+
+
+void UpdateNextChangeTime(std::time_t change_time, std::time_t& next_change_time) {
+    if (change_time < next_change_time) {
+        next_change_time = change_time;
+    }
+}
+
+}
+
+
+template<typename C>
+std::time_t NextChangeTime(
+    const CompiledExpression<C>& expression,
+    std::time_t referenced_time,
+    std::time_t formatted_time,
+    const TimeZone& time_zone) {
+
+    std::time_t next_change_time = std::numeric_limits<std::time_t>::max();
+
+    Time referenced(referenced_time, time_zone);
+    auto referenced_tm = referenced.GetTm();
+    if (referenced_tm == nullptr) {
+        return next_change_time;
+    }
+
+    //Boundaries move forward along with the referenced time, so whether the
+    //formatted time is after the backward boundary turns from true to false
+    //only once, and whether it is before the forward boundary turns from
+    //false to true only once. A rule is matched when both are true, so the
+    //matched rule can only change when one of them changes, for the rules
+    //up to the matched one. Normalized boundaries may jump back at the
+    //starts of months, so both of their turns are found.
+    std::size_t matched_index = expression.GetRuleCount();
+
+    for (std::size_t index = 0; index < expression.GetRuleCount(); ++index) {
+
+        const auto& condition = expression.GetConditions()[index];
+
+        std::time_t backward_time = 0;
+        std::time_t forward_time = 0;
+        if (! ResolveCondition(condition, *referenced_tm, time_zone, backward_time, forward_time)) {
+            return next_change_time;
+        }
+
+        std::time_t change_time = 0;
+
+        //The backward boundary passes the formatted time when it reaches
+        //the next second.
+        bool is_after_backward = (backward_time <= formatted_time);
+        if (formatted_time < std::numeric_limits<std::time_t>::max()) {
+
+            if (IsNormalizedBoundary(condition.backward)) {
+                if (FindNormalizedBoundaryChange(condition.backward, referenced_time, backward_time, formatted_time + 1, time_zone, change_time)) {
+                    UpdateNextChangeTime(change_time, next_change_time);
+                }
+            }
+            else if (is_after_backward &&
+                FindBoundaryReachTime(condition.backward, referenced_time, backward_time, formatted_time + 1, time_zone, change_time)) {
+                UpdateNextChangeTime(change_time, next_change_time);
+            }
+        }
+
+        bool is_before_forward = (formatted_time <= forward_time);
+        if (IsNormalizedBoundary(condition.forward)) {
+            if (FindNormalizedBoundaryChange(condition.forward, referenced_time, forward_time, formatted_time, time_zone, change_time)) {
+                UpdateNextChangeTime(change_time, next_change_time);
+            }
+        }
+        else if (! is_before_forward &&
+            FindBoundaryReachTime(condition.forward, referenced_time, forward_time, formatted_time, time_zone, change_time)) {
+            UpdateNextChangeTime(change_time, next_change_time);
+        }
+
+        if (is_after_backward && is_before_forward) {
+            matched_index = index;
+            break;
+        }
+    }
+
+    if (matched_index == expression.GetRuleCount()) {
+        return next_change_time;
+    }
+
+    //Differences between the referenced time and the formatted time are
+    //monotone over referenced times as well.
+    const auto* instructions = expression.GetInstructions(matched_index);
+    for (std::size_t index = 0; index < expression.GetResult(matched_index).instruction_count; ++index) {
+
+        const auto& each_instruction = instructions[index];
+        if (each_instruction.code != Instruction::Code::Difference) {
+            continue;
+        }
+
+        std::time_t change_time = 0;
+        if (FindDifferenceChange(each_instruction.specifier.unit, referenced_time, formatted_time, time_zone, change_time)) {
+            UpdateNextChangeTime(change_time, next_change_time);
+        }
+    }
+
+    return next_change_time;
+}
+
+template
+std::time_t NextChangeTime(
+    const CompiledExpression<char>& expression,
+    std::time_t referenced_time,
+    std::time_t formatted_time,
+    const TimeZone& time_zone);
+
+template
+std::time_t NextChangeTime(
+    const CompiledExpression<wchar_t>& expression,
+    std::time_t referenced_time,
+    std::time_t formatted_time,
+    const TimeZone& time_zone);
+
+}
+}
@@ -1,20 +1,98 @@
 #pragma once
 
+#include <cstddef>
+#include <limits>
+#include <string_view>
+#include <utility>
 #include "tiex_error.h"
 #include "tiex_expression.h"
+#include "tiex_render.h"
 #include "tiex_scanner.h"
 
 namespace tiex {
 namespace internal {
 
+/**
+ A sink of Parser that builds a BasicExpression, each of whose results owns
+ its instructions and literals.
+
+ A sink receives what the parser reads, and determines the types that the
+ parser fills. Parser is evaluated at compile time with a sink that can be
+ evaluated at compile time as well, see StaticTableSink.
+ */
 template<typename C>
+class ExpressionSink {
+public:
+	using Char = C;
+	using Expression = BasicExpression<Char>;
+	using Rule = BasicRule<Char>;
+	using Result = BasicResult<Char>;
+
+public:
+	void AddRule(Expression& expression, Rule&& rule) {
+		expression.rules.push_back(std::move(rule));
+	}
+
+	void MakeRule(const Condition& condition, Result&& result, Rule& rule) {
+		rule.condition = condition;
+		rule.result = std::move(result);
+	}
+
+	void BeginResult(Result& result) {
+
+	}
+
+	void EndResult(Result& result) {
+
+	}
+
+	/**
+	 Append literal characters to a result, they are merged into the last
+	 instruction if it is a literal as well.
+	 */
+	void AppendLiteral(Result& result, const Char* chars, std::size_t length) {
+
+		if (result.instructions.empty() ||
+			(result.instructions.back().code != Instruction::Code::Literal)) {
+
+			Instruction instruction;
+			instruction.code = Instruction::Code::Literal;
+			instruction.offset = result.literals.length();
+			result.instructions.push_back(instruction);
+		}
+
+		result.literals.append(chars, length);
+		result.instructions.back().length += length;
+	}
+
+	void AppendInstruction(Result& result, const Instruction& instruction) {
+
+		result.instructions.push_back(instruction);
+		if (instruction.code == Instruction::Code::Field) {
+			result.has_standard_specifiers = true;
+		}
+	}
+};
+
+
+/**
+ A parser of format expressions, which reads tokens from a scanner, and
+ passes rules, literals and instructions to a sink.
+
+ The parser can be evaluated at compile time if the sink can, so the
+ expressions parsed at runtime and at compile time share the grammar.
+ */
+template<typename C, typename Sink = ExpressionSink<C>>
 class Parser {
 public:
 	using Char = C;
-	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
+	using Expression = typename Sink::Expression;
+	using Rule = typename Sink::Rule;
+	using Result = typename Sink::Result;
 
 public:
-	Parser(Scanner<Char>& scanner) : scanner_(scanner) {
+	constexpr Parser(Scanner<Char>& scanner, Sink sink = Sink()) : scanner_(scanner), sink_(std::move(sink)) {
 
 	}
 
@@ -22,53 +100,58 @@ public:
 	Parser& operator=(const Parser&) = delete;
     
 
-    BasicExpression<Char> Parse() {
+    constexpr Expression Parse() {
 
 		parse_error_.Clear();
 
-		BasicExpression<Char> expression;
+		Expression expression;
 		ParseExpression(expression);
 		return expression;
 	}
     
 
-    const ParseError& GetParseError() const {
+    constexpr const ParseError& GetParseError() const {
         return parse_error_;
     }
+
+
+	constexpr const Sink& GetSink() const {
+		return sink_;
+	}
     
 
 //These private mehtods are declared as public just for testing purpose.
 public:
-	bool ParseExpression(BasicExpression<Char>& expression) {
+	constexpr bool ParseExpression(Expression& expression) {
 
-		std::vector<BasicRule<Char>> rules;
+		Expression parsed_expression;
 
 		scanner_.SkipWhiteSpaces();
 
 		bool is_succeeded = false;
 		do {
 
-			BasicRule<Char> rule;
+			Rule rule;
 			is_succeeded = ParseRule(rule);
 			if (! is_succeeded) {
 				break;
 			}
 
-			rules.push_back(rule);
+			sink_.AddRule(parsed_expression, std::move(rule));
 
 			scanner_.SkipWhiteSpaces();
 		} 
 		while (! scanner_.IsEnd());
 
 		if (is_succeeded) {
-			expression.rules = std::move(rules);
+			expression = std::move(parsed_expression);
 		}
 
 		return is_succeeded;
 	}
 
 
-	bool ParseRule(BasicRule<Char>& rule) {
+	constexpr bool ParseRule(Rule& rule) {
 
 		Condition condition;
 		if (! ParseCondition(condition)) {
@@ -77,18 +160,17 @@ public:
 
 		scanner_.SkipWhiteSpaces();
 
-		BasicResult<Char> result;
+		Result result;
 		if (! ParseResult(result)) {
 			return false;
 		}
 
-		rule.condition = std::move(condition);
-		rule.result = std::move(result);
+		sink_.MakeRule(condition, std::move(result), rule);
 		return true;
 	}
 
 
-	bool ParseCondition(Condition& condition) {
+	constexpr bool ParseCondition(Condition& condition) {
 
 		if (! ParseChar('[')) {
 			return false;
@@ -126,7 +208,7 @@ public:
 	}
 
 
-	bool ParseBoundary(bool is_forward, Boundary& boundary) {
+	constexpr bool ParseBoundary(bool is_forward, Boundary& boundary) {
 
 		Char ch = 0;
 		if (! scanner_.GetChar(ch)) {
@@ -177,7 +259,7 @@ public:
 	}
 
 
-	bool ParseRound(bool& round) {
+	constexpr bool ParseRound(bool& round) {
 
 		Char ch = 0;
 		if (! scanner_.ReadChar(ch)) {
@@ -200,9 +282,9 @@ public:
 	}
 
 
-	bool ParseUnit(Unit& unit) {
+	constexpr bool ParseUnit(Unit& unit) {
 
-		String word;
+		StringView word;
 		if (! ParseWord(word)) {
 			return false;
 		}
@@ -216,20 +298,23 @@ public:
 	}
 
 
-	bool ParseResult(BasicResult<Char>& result) {
+	constexpr bool ParseResult(Result& result) {
 
 		if (! ParseChar('{')) {
 			return false;
 		}
 
 		bool is_succeeded = true;
-		std::vector<String> texts;
-		std::map<std::size_t, Specifier> specifiers;
-		bool has_standard_specifiers = false;
-		String current_text;
+		Result program;
+		sink_.BeginResult(program);
 
 		while (true) {
 
+			StringView text;
+			if (scanner_.ReadUntil('%', '}', text)) {
+				sink_.AppendLiteral(program, text.data(), text.length());
+			}
+
 			Char ch = 0;
 			if (! scanner_.ReadChar(ch)) {
 				SetError(ParseError::Status::UnexpectedEnd);
@@ -238,62 +323,69 @@ public:
 			}
 
 			if (ch == '}') {
-				if (! current_text.empty()) {
-					texts.push_back(current_text);
-				}
 				break;
 			}
 
-			if (ch == '%') {
+			if (! scanner_.ReadChar(ch)) {
+				SetError(ParseError::Status::UnexpectedEnd);
+				is_succeeded = false;
+				break;
+			}
 
-				if (! scanner_.ReadChar(ch)) {
-					SetError(ParseError::Status::UnexpectedEnd);
+			if (ch == '~') {
+
+				Unit unit = Unit::Second;
+				if (! ParseUnit(unit)) {
 					is_succeeded = false;
 					break;
 				}
 
-				if (ch == '~') {
-
-					Unit unit = Unit::Second;
-					if (! ParseUnit(unit)) {
-						is_succeeded = false;
-						break;
-					}
+				Instruction instruction;
+				instruction.code = Instruction::Code::Difference;
+				instruction.specifier.unit = unit;
+				sink_.AppendInstruction(program, instruction);
+				continue;
+			}
 
-					if (! current_text.empty()) {
-						texts.push_back(current_text);
-						current_text.clear();
-					}
+			//Modifiers of alternative representations have no effect,
+			//as what they do in the "C" locale.
+			Char conversion_char = ch;
+			Char next_char = 0;
+			if (((ch == 'E') || (ch == 'O')) &&
+				scanner_.GetChar(next_char) &&
+				IsStandardSpecifierChar(next_char)) {
 
-					auto specifier_index = texts.size();
-					texts.push_back({});
+				scanner_.ReadChar(conversion_char);
+			}
 
-					Specifier specifier;
-					specifier.unit = unit;
-					specifiers[specifier_index] = specifier;
-				}
-				else {
-					has_standard_specifiers = true;
-					current_text.push_back('%');
-					current_text.push_back(ch);
-				}
+			if (conversion_char == '%') {
+				sink_.AppendLiteral(program, &conversion_char, 1);
+				continue;
 			}
-			else {
-				current_text.push_back(ch);
+
+			//Unsupported specifiers are kept as they are.
+			if (! IsStandardSpecifierChar(conversion_char)) {
+				const Char specifier_chars[] = { '%', ch };
+				sink_.AppendLiteral(program, specifier_chars, 2);
+				continue;
 			}
+
+			Instruction instruction;
+			instruction.code = Instruction::Code::Field;
+			instruction.specifier.standard_char = static_cast<char>(conversion_char);
+			sink_.AppendInstruction(program, instruction);
 		}
 
 		if (is_succeeded) {
-			result.texts = std::move(texts);
-			result.specifiers = std::move(specifiers);
-			result.has_standard_specifiers = has_standard_specifiers;
+			sink_.EndResult(program);
+			result = std::move(program);
 		}
 
 		return is_succeeded;
 	}
 
 
-	bool ParseChar(Char expected_char) {
+	constexpr bool ParseChar(Char expected_char) {
 
 		Char read_char = 0;
 		if (! scanner_.GetChar(read_char)) {
@@ -311,9 +403,9 @@ public:
 	}
 
 
-	bool ParseNumber(int& value) {
+	constexpr bool ParseNumber(int& value) {
 
-		String number;
+		StringView number;
 		if (! scanner_.ReadNumber(number)) {
 
 			if (scanner_.IsEnd()) {
@@ -325,18 +417,16 @@ public:
 			return false;
 		}
 
-		try {
-			value = std::stoi(number);
-			return true;
-		}
-		catch (...) {
+		if (! ConvertNumber(number, value)) {
 			SetError(ParseError::Status::ConversionFailed, -static_cast<int>(number.length()));
 			return false;
 		}
+
+		return true;
 	}
 
 
-	bool ParseWord(String& word) {
+	constexpr bool ParseWord(StringView& word) {
 
 		if (! scanner_.ReadWord(word)) {
 
@@ -353,7 +443,7 @@ public:
 	}
     
 private:
-	static bool GetUnit(const String& string, Unit& unit) {
+	static constexpr bool GetUnit(StringView string, Unit& unit) {
 
 		if (string.length() == 1) {
 
@@ -393,17 +483,18 @@ private:
 	}
 
 private:
-	void SetError(ParseError::Status status, int index_adjustment) {
+	constexpr void SetError(ParseError::Status status, int index_adjustment) {
 		parse_error_.status = status;
 		parse_error_.index = scanner_.GetCurrentIndex() + index_adjustment;
 	}
     
-    void SetError(ParseError::Status status) {
+    constexpr void SetError(ParseError::Status status) {
         SetError(status, 0);
     }
     
 private:
 	Scanner<Char>& scanner_;
+	Sink sink_;
     ParseError parse_error_;
 };
 
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <ctime>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tiex_bound_formatter.h"
+#include "tiex_formatter.h"
+#include "tiex_locale.h"
+#include "tiex_time_zone.h"
+#include "tiex_timing_wheel.h"
+
+namespace tiex {
+
+/**
+ A refresh scheduler keeps results of lots of displayed times up to date
+ against a moving current time, which is used as the referenced time.
+
+ Each time is scheduled to its next change time in a hierarchical timing
+ wheel, so advancing the current time only re-formats the times whose
+ results may change, instead of all of them.
+
+ A refresh scheduler is not thread safe.
+ */
+template<typename C>
+class BasicRefreshScheduler {
+public:
+	using Char = C;
+	using String = std::basic_string<Char>;
+	using Locale = BasicLocale<Char>;
+	using Formatter = BasicFormatter<Char>;
+	using BoundFormatter = BasicBoundFormatter<Char>;
+	using Id = std::uint64_t;
+
+	/**
+	 A change of the result of a time.
+	 */
+	class Change {
+	public:
+		/**
+		 The id of the time.
+		 */
+		Id id = 0;
+
+		/**
+		 The new result.
+		 */
+		String text;
+	};
+
+public:
+	/**
+	 Construct a refresh scheduler.
+
+	 @param formatter
+	   The formatter that formats the times.
+
+	 @param current_time
+	   The initial current time.
+
+	 @param time_zone
+	   The time zone in which times are converted to local times.
+
+	 @param locale
+	   Contains localization information that affect format result.
+	 */
+	BasicRefreshScheduler(
+		Formatter formatter,
+		std::time_t current_time,
+		const TimeZone& time_zone,
+		Locale locale) :
+
+		formatter_(std::move(formatter)),
+		time_zone_(time_zone),
+		locale_(std::move(locale)),
+		bound_formatter_(formatter_.Bind(current_time, time_zone_)),
+		timing_wheel_(current_time) {
+
+	}
+
+	/**
+	 Construct a refresh scheduler in the local time zone.
+	 */
+	BasicRefreshScheduler(Formatter formatter, std::time_t current_time) :
+		BasicRefreshScheduler(std::move(formatter), current_time, TimeZone(), Locale()) {
+
+	}
+
+	BasicRefreshScheduler(const BasicRefreshScheduler&) = delete;
+	BasicRefreshScheduler& operator=(const BasicRefreshScheduler&) = delete;
+
+	/**
+	 Get the current time.
+	 */
+	std::time_t GetCurrentTime() const {
+		return timing_wheel_.GetCurrentTime();
+	}
+
+	/**
+	 Get the count of times in the scheduler.
+	 */
+	std::size_t GetCount() const {
+		return entries_.size();
+	}
+
+	/**
+	 Add a time to the scheduler, which replaces the existing one with the
+	 same id.
+
+	 @return
+	   The result of the time at the current time. An empty string is
+	   returned if fail to format.
+	 */
+	String Add(Id id, std::time_t formatted_time) {
+
+		auto& entry = entries_[id];
+		entry.formatted_time = formatted_time;
+		Refresh(id, entry);
+		return entry.text;
+	}
+
+	/**
+	 Remove a time from the scheduler.
+
+	 @return
+	   Whether the time exists.
+	 */
+	bool Remove(Id id) {
+
+		auto iterator = entries_.find(id);
+		if (iterator == entries_.end()) {
+			return false;
+		}
+
+		timing_wheel_.Cancel(id);
+		entries_.erase(iterator);
+		return true;
+	}
+
+	/**
+	 Get the result of a time at the current time.
+	 */
+	String GetText(Id id) const {
+
+		auto iterator = entries_.find(id);
+		if (iterator == entries_.end()) {
+			return {};
+		}
+		return iterator->second.text;
+	}
+
+	/**
+	 Advance the current time, and get times whose results are changed.
+
+	 @param current_time
+	   The new current time. Nothing happens if it is earlier than the
+	   current time.
+
+	 @param changes
+	   An output parameter that changes are appended to, in the order of
+	   the times they change.
+	 */
+	void Advance(std::time_t current_time, std::vector<Change>& changes) {
+
+		expired_ids_.clear();
+		timing_wheel_.Advance(current_time, expired_ids_);
+
+		for (auto each_id : expired_ids_) {
+
+			auto iterator = entries_.find(each_id);
+			if (iterator == entries_.end()) {
+				continue;
+			}
+
+			auto& entry = iterator->second;
+			auto previous_text = std::move(entry.text);
+			Refresh(each_id, entry);
+
+			if (entry.text != previous_text) {
+				Change change;
+				change.id = each_id;
+				change.text = entry.text;
+				changes.push_back(std::move(change));
+			}
+		}
+	}
+
+	/**
+	 Advance the current time, and get times whose results are changed.
+	 */
+	std::vector<Change> Advance(std::time_t current_time) {
+		std::vector<Change> changes;
+		Advance(current_time, changes);
+		return changes;
+	}
+
+private:
+	class Entry {
+	public:
+		std::time_t formatted_time = 0;
+		String text;
+	};
+
+private:
+	void Refresh(Id id, Entry& entry) {
+
+		//Times refreshed at the same current time share a bound formatter, so
+		//conditions are resolved once per tick rather than once per time.
+		auto current_time = timing_wheel_.GetCurrentTime();
+		if (bound_formatter_.GetReferencedTime() != current_time) {
+			bound_formatter_ = formatter_.Bind(current_time, time_zone_);
+		}
+
+		FormatError error;
+		entry.text = bound_formatter_.Format(entry.formatted_time, locale_, error);
+
+		auto next_change_time = bound_formatter_.NextChangeTime(entry.formatted_time);
+		if (next_change_time == std::numeric_limits<std::time_t>::max()) {
+			timing_wheel_.Cancel(id);
+			return;
+		}
+
+		timing_wheel_.Schedule(id, next_change_time);
+	}
+
+private:
+	Formatter formatter_;
+	TimeZone time_zone_;
+	Locale locale_;
+	BoundFormatter bound_formatter_;
+	internal::TimingWheel timing_wheel_;
+	std::unordered_map<Id, Entry> entries_;
+	std::vector<Id> expired_ids_;
+};
+
+using RefreshScheduler = BasicRefreshScheduler<char>;
+using WideRefreshScheduler = BasicRefreshScheduler<wchar_t>;
+
+}
@@ -0,0 +1,84 @@
+#include "tiex_render.h"
+#include "tiex_civil.h"
+
+namespace tiex {
+namespace internal {
+namespace {
+
+const char* const WeekdayNames[] = {
+    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday",
+};
+
+const char* const AbbreviatedWeekdayNames[] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat",
+};
+
+const char* const MonthNames[] = {
+    "January", "February", "March", "April", "May", "June",
+    "July", "August", "September", "October", "November", "December",
+};
+
+const char* const AbbreviatedMonthNames[] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
+};
+
+
+int GetIsoWeekCount(std::int64_t year) {
+
+    //A year has 53 weeks if it ends on Thursday, or its previous year ends
+    //on Wednesday.
+    if (GetWeekday(DaysFromCivil(year, 12, 31)) == 4) {
+        return 53;
+    }
+    if (GetWeekday(DaysFromCivil(year - 1, 12, 31)) == 3) {
+        return 53;
+    }
+    return 52;
+}
+
+}
+
+
+const char* GetWeekdayName(int weekday, bool is_abbreviated) {
+
+    if ((weekday < 0) || (weekday > 6)) {
+        return "?";
+    }
+    return is_abbreviated ? AbbreviatedWeekdayNames[weekday] : WeekdayNames[weekday];
+}
+
+
+const char* GetMonthName(int month, bool is_abbreviated) {
+
+    if ((month < 0) || (month > 11)) {
+        return "?";
+    }
+    return is_abbreviated ? AbbreviatedMonthNames[month] : MonthNames[month];
+}
+
+
+int GetIsoWeek(const std::tm& tm, std::int64_t& iso_year) {
+
+    std::int64_t year = static_cast<std::int64_t>(tm.tm_year) + 1900;
+
+    //Weeks start on Monday, and the first week is the one contains Thursday.
+    int weekday_from_monday = (tm.tm_wday + 6) % 7;
+    int week = (tm.tm_yday - weekday_from_monday + 10) / 7;
+
+    if (week < 1) {
+        iso_year = year - 1;
+        return GetIsoWeekCount(iso_year);
+    }
+
+    if (week > GetIsoWeekCount(year)) {
+        iso_year = year + 1;
+        return 1;
+    }
+
+    iso_year = year;
+    return week;
+}
+
+}
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include "tiex_scanner.h"
+#include "tiex_time.h"
+#include "tiex_writer.h"
+
+namespace tiex {
+namespace internal {
+
+/**
+ Functions in this file render standard specifiers natively, as what
+ std::strftime does in the "C" locale, so that generating results doesn't
+ need string streams and std::put_time.
+ */
+
+/**
+ Determinate whether a character is the conversion character of a standard
+ specifier that RenderStandardSpecifier supports.
+ */
+constexpr bool IsStandardSpecifierChar(int ch) {
+
+	if (ch <= 0 || ch > 0x7f) {
+		return false;
+	}
+	return std::string_view("aAbBcCdDeFgGhHIjklmMnpPrRsStTuUVwWxXyYzZ").find(static_cast<char>(ch)) != std::string_view::npos;
+}
+
+/**
+ Get the name of a weekday, from 0 to 6, which 0 is Sunday.
+ */
+const char* GetWeekdayName(int weekday, bool is_abbreviated);
+
+/**
+ Get the name of a month, from 0 to 11.
+ */
+const char* GetMonthName(int month, bool is_abbreviated);
+
+/**
+ Get the ISO 8601 week number of a tm, and the year the week belongs to.
+ */
+int GetIsoWeek(const std::tm& tm, std::int64_t& iso_year);
+
+
+template<typename C>
+bool RenderStandardSpecifier(char specifier_char, const std::tm& tm, const Time& time, Writer<C>& writer);
+
+
+template<typename C>
+void RenderSignedNumber(std::int64_t number, std::size_t width, Writer<C>& writer) {
+
+	if (number < 0) {
+		writer.Write(static_cast<C>('-'));
+		WriteNumber<C>(0ull - static_cast<unsigned long long>(number), width, '0', writer);
+	}
+	else {
+		WriteNumber<C>(static_cast<unsigned long long>(number), width, '0', writer);
+	}
+}
+
+
+template<typename C>
+void RenderName(const char* name, Writer<C>& writer) {
+	WriteAscii<C>(name, std::char_traits<char>::length(name), writer);
+}
+
+
+/**
+ Render a specifier that is composed of other specifiers, such as %T.
+ Alphas in the pattern are conversion characters, others are literals.
+ */
+template<typename C>
+bool RenderCompositeSpecifier(const char* pattern, const std::tm& tm, const Time& time, Writer<C>& writer) {
+
+	for (auto iterator = pattern; *iterator != 0; ++iterator) {
+
+		if (! IsAlpha(*iterator)) {
+			writer.Write(static_cast<C>(*iterator));
+			continue;
+		}
+
+		if (! RenderStandardSpecifier(*iterator, tm, time, writer)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+template<typename C>
+bool RenderStandardSpecifier(char specifier_char, const std::tm& tm, const Time& time, Writer<C>& writer) {
+
+	auto floor_divide = [](std::int64_t dividend, std::int64_t divisor) {
+		auto quotient = dividend / divisor;
+		return ((dividend % divisor) < 0) ? (quotient - 1) : quotient;
+	};
+
+	std::int64_t year = static_cast<std::int64_t>(tm.tm_year) + 1900;
+	int hour_12 = (tm.tm_hour % 12 == 0) ? 12 : (tm.tm_hour % 12);
+
+	switch (specifier_char) {
+
+	case 'a':
+	case 'A':
+		RenderName(GetWeekdayName(tm.tm_wday, specifier_char == 'a'), writer);
+		return true;
+
+	case 'b':
+	case 'h':
+	case 'B':
+		RenderName(GetMonthName(tm.tm_mon, specifier_char != 'B'), writer);
+		return true;
+
+	case 'c':
+		return RenderCompositeSpecifier("a b e H:M:S Y", tm, time, writer);
+
+	case 'C':
+		RenderSignedNumber(floor_divide(year, 100), 2, writer);
+		return true;
+
+	case 'd':
+		WriteNumber<C>(tm.tm_mday, 2, '0', writer);
+		return true;
+
+	case 'D':
+	case 'x':
+		return RenderCompositeSpecifier("m/d/y", tm, time, writer);
+
+	case 'e':
+		WriteNumber<C>(tm.tm_mday, 2, ' ', writer);
+		return true;
+
+	case 'F':
+		return RenderCompositeSpecifier("Y-m-d", tm, time, writer);
+
+	case 'g':
+	case 'G': {
+		std::int64_t iso_year = 0;
+		GetIsoWeek(tm, iso_year);
+		if (specifier_char == 'G') {
+			RenderSignedNumber(iso_year, 0, writer);
+		}
+		else {
+			WriteNumber<C>(iso_year - floor_divide(iso_year, 100) * 100, 2, '0', writer);
+		}
+		return true;
+	}
+
+	case 'H':
+		WriteNumber<C>(tm.tm_hour, 2, '0', writer);
+		return true;
+
+	case 'I':
+		WriteNumber<C>(hour_12, 2, '0', writer);
+		return true;
+
+	case 'j':
+		WriteNumber<C>(tm.tm_yday + 1, 3, '0', writer);
+		return true;
+
+	case 'k':
+		WriteNumber<C>(tm.tm_hour, 2, ' ', writer);
+		return true;
+
+	case 'l':
+		WriteNumber<C>(hour_12, 2, ' ', writer);
+		return true;
+
+	case 'm':
+		WriteNumber<C>(tm.tm_mon + 1, 2, '0', writer);
+		return true;
+
+	case 'M':
+		WriteNumber<C>(tm.tm_min, 2, '0', writer);
+		return true;
+
+	case 'n':
+		writer.Write(static_cast<C>('\n'));
+		return true;
+
+	case 'p':
+		RenderName((tm.tm_hour >= 12) ? "PM" : "AM", writer);
+		return true;
+
+	case 'P':
+		RenderName((tm.tm_hour >= 12) ? "pm" : "am", writer);
+		return true;
+
+	case 'r':
+		return RenderCompositeSpecifier("I:M:S p", tm, time, writer);
+
+	case 'R':
+		return RenderCompositeSpecifier("H:M", tm, time, writer);
+
+	case 's':
+		RenderSignedNumber(static_cast<std::int64_t>(time.GetTimet()), 0, writer);
+		return true;
+
+	case 'S':
+		WriteNumber<C>(tm.tm_sec, 2, '0', writer);
+		return true;
+
+	case 't':
+		writer.Write(static_cast<C>('\t'));
+		return true;
+
+	case 'T':
+	case 'X':
+		return RenderCompositeSpecifier("H:M:S", tm, time, writer);
+
+	case 'u':
+		WriteNumber<C>((tm.tm_wday == 0) ? 7 : tm.tm_wday, writer);
+		return true;
+
+	case 'U':
+		WriteNumber<C>((tm.tm_yday + 7 - tm.tm_wday) / 7, 2, '0', writer);
+		return true;
+
+	case 'V': {
+		std::int64_t iso_year = 0;
+		WriteNumber<C>(GetIsoWeek(tm, iso_year), 2, '0', writer);
+		return true;
+	}
+
+	case 'w':
+		WriteNumber<C>(tm.tm_wday, writer);
+		return true;
+
+	case 'W':
+		WriteNumber<C>((tm.tm_yday + 7 - (tm.tm_wday + 6) % 7) / 7, 2, '0', writer);
+		return true;
+
+	case 'y':
+		WriteNumber<C>(year - floor_divide(year, 100) * 100, 2, '0', writer);
+		return true;
+
+	case 'Y':
+		RenderSignedNumber(year, 0, writer);
+		return true;
+
+	case 'z': {
+		std::int32_t offset = 0;
+		bool is_dst = false;
+		if (! time.GetTimeZone().GetOffset(time.GetTimet(), offset, is_dst)) {
+			return false;
+		}
+		writer.Write(static_cast<C>((offset < 0) ? '-' : '+'));
+		std::uint32_t absolute_offset = (offset < 0) ? (0u - static_cast<std::uint32_t>(offset)) : offset;
+		WriteNumber<C>(absolute_offset / 3600, 2, '0', writer);
+		WriteNumber<C>(absolute_offset / 60 % 60, 2, '0', writer);
+		return true;
+	}
+
+	case 'Z': {
+		std::string abbreviation;
+		if (! time.GetTimeZone().GetAbbreviation(time.GetTimet(), abbreviation)) {
+			return false;
+		}
+		WriteAscii<C>(abbreviation.data(), abbreviation.length(), writer);
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+}
+}
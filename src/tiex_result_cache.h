@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tiex_compiled_expression.h"
+
+namespace tiex {
+namespace internal {
+
+/**
+ A cache of generated results, keyed by the matched rule and the difference
+ between the referenced time and the formatted time.
+
+ Only results without standard specifiers are cached, and all %~ specifiers
+ in such a result must be in the same unit. The text of these results
+ depends on nothing but the value of that difference, for example,
+ "[-1~h,0]{%~min minutes ago}" has only 60 distinct texts, so they are
+ generated once and shared afterwards.
+
+ The cache is thread safe. When it is full, all cached texts are dropped,
+ which keeps the working set of a long running formatter bounded.
+ */
+template<typename C>
+class ResultCache {
+public:
+	using String = std::basic_string<C>;
+
+	/**
+	 How the text of a rule is keyed in the cache.
+	 */
+	class RuleKey {
+	public:
+		bool is_cacheable = false;
+
+		/**
+		 Whether the text depends on a difference. If not, the rule has only
+		 one text.
+		 */
+		bool has_difference = false;
+		Unit unit = Unit::Second;
+	};
+
+public:
+	ResultCache(const CompiledExpression<C>& expression, std::size_t capacity) : capacity_(capacity) {
+
+		rule_keys_.reserve(expression.GetRuleCount());
+		for (std::size_t index = 0; index < expression.GetRuleCount(); ++index) {
+			rule_keys_.push_back(MakeRuleKey(expression, index));
+		}
+	}
+
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	const RuleKey& GetRuleKey(std::size_t rule) const {
+		return rule_keys_[rule];
+	}
+
+	/**
+	 Find the cached text of a rule.
+
+	 @return
+	   nullptr if the text is not cached.
+	 */
+	std::shared_ptr<const String> Find(std::size_t rule, long difference) const {
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto iterator = texts_.find(Key{ rule, difference });
+		if (iterator == texts_.end()) {
+			return nullptr;
+		}
+		return iterator->second;
+	}
+
+	void Insert(std::size_t rule, long difference, std::shared_ptr<const String> text) {
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (texts_.size() >= capacity_) {
+			texts_.clear();
+		}
+		texts_[Key{ rule, difference }] = std::move(text);
+	}
+
+	std::size_t GetSize() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return texts_.size();
+	}
+
+private:
+	class Key {
+	public:
+		std::size_t rule;
+		long difference;
+
+		bool operator==(const Key& other) const {
+			return (rule == other.rule) && (difference == other.difference);
+		}
+	};
+
+	class KeyHash {
+	public:
+		std::size_t operator()(const Key& key) const {
+			return std::hash<long>()(key.difference) * 31 + key.rule;
+		}
+	};
+
+private:
+	static RuleKey MakeRuleKey(const CompiledExpression<C>& expression, std::size_t rule) {
+
+		RuleKey rule_key;
+		const auto& result = expression.GetResult(rule);
+		if (result.has_standard_specifiers) {
+			return rule_key;
+		}
+
+		const auto* instructions = expression.GetInstructions(rule);
+		for (std::size_t index = 0; index < result.instruction_count; ++index) {
+
+			const auto& each_instruction = instructions[index];
+			if (each_instruction.code != Instruction::Code::Difference) {
+				continue;
+			}
+
+			if (rule_key.has_difference && (rule_key.unit != each_instruction.specifier.unit)) {
+				return rule_key;
+			}
+
+			rule_key.has_difference = true;
+			rule_key.unit = each_instruction.specifier.unit;
+		}
+
+		rule_key.is_cacheable = true;
+		return rule_key;
+	}
+
+private:
+	std::vector<RuleKey> rule_keys_;
+	std::size_t capacity_;
+	mutable std::mutex mutex_;
+	std::unordered_map<Key, std::shared_ptr<const String>, KeyHash> texts_;
+};
+
+}
+}
@@ -0,0 +1,106 @@
+#include "tiex_rule_index.h"
+#include <algorithm>
+#include <limits>
+
+namespace tiex {
+namespace internal {
+namespace {
+
+/**
+ The number of segments below which a linear scan is used to look up.
+ */
+constexpr std::size_t LinearSearchThreshold = 16;
+
+
+int FindFirstMatchedRule(const std::vector<ResolvedCondition>& resolved_conditions, std::time_t time) {
+
+	for (std::size_t index = 0; index < resolved_conditions.size(); ++index) {
+
+		const auto& each_condition = resolved_conditions[index];
+		if (! each_condition.is_valid) {
+			return RuleIndex::InvalidCondition;
+		}
+
+		if ((each_condition.backward_time <= time) && (time <= each_condition.forward_time)) {
+			return static_cast<int>(index);
+		}
+	}
+
+	return RuleIndex::NoMatchedRule;
+}
+
+}
+
+
+constexpr int RuleIndex::NoMatchedRule;
+constexpr int RuleIndex::InvalidCondition;
+
+
+RuleIndex::RuleIndex(const std::vector<ResolvedCondition>& resolved_conditions) {
+
+	//Collect times at which the set of matched rules may change.
+	std::vector<std::time_t> boundaries;
+	boundaries.reserve(resolved_conditions.size() * 2 + 1);
+	boundaries.push_back(std::numeric_limits<std::time_t>::min());
+
+	for (const auto& each_condition : resolved_conditions) {
+
+		//Conditions after an invalid one are never reached.
+		if (! each_condition.is_valid) {
+			break;
+		}
+
+		if (each_condition.backward_time > each_condition.forward_time) {
+			continue;
+		}
+
+		boundaries.push_back(each_condition.backward_time);
+
+		if (each_condition.forward_time != std::numeric_limits<std::time_t>::max()) {
+			boundaries.push_back(each_condition.forward_time + 1);
+		}
+	}
+
+	std::sort(boundaries.begin(), boundaries.end());
+	boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+	//Each elementary segment has a single winner, adjacent segments with
+	//the same winner are merged.
+	for (auto each_boundary : boundaries) {
+
+		int rule = FindFirstMatchedRule(resolved_conditions, each_boundary);
+		if (! segment_rules_.empty() && (segment_rules_.back() == rule)) {
+			continue;
+		}
+
+		segment_starts_.push_back(each_boundary);
+		segment_rules_.push_back(rule);
+	}
+}
+
+
+int RuleIndex::Find(std::time_t formatted_time) const {
+
+	if (segment_starts_.empty()) {
+		return NoMatchedRule;
+	}
+
+	std::size_t count = 0;
+
+	if (segment_starts_.size() <= LinearSearchThreshold) {
+		//Branchless counting of segments that start at or before the time.
+		for (auto each_start : segment_starts_) {
+			count += (each_start <= formatted_time) ? 1 : 0;
+		}
+	}
+	else {
+		auto iterator = std::upper_bound(segment_starts_.begin(), segment_starts_.end(), formatted_time);
+		count = iterator - segment_starts_.begin();
+	}
+
+	//The first segment starts at the minimum time, so count is at least 1.
+	return segment_rules_[count - 1];
+}
+
+}
+}
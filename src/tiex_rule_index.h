@@ -0,0 +1,63 @@
+#pragma once
+
+#include <ctime>
+#include <vector>
+
+namespace tiex {
+namespace internal {
+
+/**
+ A condition whose boundaries have been converted to absolute times.
+ */
+class ResolvedCondition {
+public:
+	std::time_t backward_time = 0;
+	std::time_t forward_time = 0;
+	bool is_valid = false;
+};
+
+
+/**
+ An index that maps formatted times to the first matched rule.
+
+ The first-match semantics of a list of resolved conditions is compiled
+ into disjoint, sorted segments of time, each one records the rule that
+ wins in it. Looking up a time is then a search over segment starts, whose
+ cost does not grow with the number of rules linearly.
+ */
+class RuleIndex {
+public:
+	/**
+	 Looking up result that means no rule matches.
+	 */
+	static constexpr int NoMatchedRule = -1;
+
+	/**
+	 Looking up result that means an unresolvable condition is reached
+	 before any rule matches.
+	 */
+	static constexpr int InvalidCondition = -2;
+
+public:
+	RuleIndex() = default;
+	explicit RuleIndex(const std::vector<ResolvedCondition>& resolved_conditions);
+
+	/**
+	 Find the index of the first rule that matches the formatted time.
+
+	 @return
+	   Index of the rule, or either NoMatchedRule or InvalidCondition.
+	 */
+	int Find(std::time_t formatted_time) const;
+
+	std::size_t GetSegmentCount() const {
+		return segment_starts_.size();
+	}
+
+private:
+	std::vector<std::time_t> segment_starts_;
+	std::vector<int> segment_rules_;
+};
+
+}
+}
@@ -1,8 +1,7 @@
 #pragma once
 
-#include <cctype>
-#include <cwctype>
-#include <string>
+#include <limits>
+#include <string_view>
 
 namespace tiex {
 namespace internal {
@@ -14,50 +13,100 @@ namespace internal {
  character no matter what locale is set, so a rewritten version here
  is used.
  */
-inline bool IsAlpha(int ch) {
+constexpr bool IsAlpha(int ch) {
 	return
 		(('a' <= ch) && (ch <= 'z')) ||
 		(('A' <= ch) && (ch <= 'Z'));
 }
 
 
-inline bool IsDigit(char ch) {
-	return std::isdigit(ch);
+/**
+ Determinate whether the specified character is an ASCII digit, as what
+ std::isdigit does in any locale.
+ */
+constexpr bool IsDigit(int ch) {
+	return ('0' <= ch) && (ch <= '9');
 }
 
-inline bool IsDigit(wchar_t ch) {
-	return std::iswdigit(ch);
+
+/**
+ Determinate whether the specified character is an ASCII white space, as
+ what std::isspace does in the "C" locale. Unlike std::isspace, it is
+ available at compile time, so the expressions parsed at runtime and at
+ compile time are the same.
+ */
+constexpr bool IsSpace(int ch) {
+	return (ch == ' ') || (('\t' <= ch) && (ch <= '\r'));
 }
 
 
-inline bool IsSpace(char ch) {
-	return std::isspace(ch);
-}
+/**
+ Convert a number that is read by Scanner::ReadNumber to int, without
+ throwing exceptions.
+
+ @return
+   False if the number is out of the range of int.
+ */
+template<typename C>
+constexpr bool ConvertNumber(std::basic_string_view<C> number, int& value) {
+
+	std::size_t index = 0;
+	bool is_negative = false;
+	if ((index < number.length()) && ((number[index] == '-') || (number[index] == '+'))) {
+		is_negative = (number[index] == '-');
+		++index;
+	}
+
+	if (index == number.length()) {
+		return false;
+	}
 
-inline bool IsSpace(wchar_t ch) {
-	return std::iswspace(ch);
+	const unsigned long long max_magnitude =
+		static_cast<unsigned long long>(std::numeric_limits<int>::max()) + (is_negative ? 1 : 0);
+
+	unsigned long long magnitude = 0;
+	for (; index < number.length(); ++index) {
+
+		magnitude = magnitude * 10 + static_cast<unsigned long long>(number[index] - '0');
+		if (magnitude > max_magnitude) {
+			return false;
+		}
+	}
+
+	value = is_negative ?
+		static_cast<int>(0 - static_cast<long long>(magnitude)) :
+		static_cast<int>(magnitude);
+	return true;
 }
 
 
+/**
+ A scanner reads characters and tokens from an expression string. Tokens
+ are returned as views of the string, so scanning doesn't allocate memory.
+ */
 template<typename C>
 class Scanner {
 public:
 	using Char = C;
-	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
 
 public:
-    Scanner(const Char* string, std::size_t length) :
+    constexpr Scanner(const Char* string, std::size_t length) :
 		begin_(string),
 		end_(string + length),
 		cursor_(string) {
 
 	}
 
+	constexpr explicit Scanner(StringView string) : Scanner(string.data(), string.length()) {
+
+	}
+
 	Scanner(const Scanner&) = delete;
 	Scanner& operator=(const Scanner&) = delete;
     
 
-	bool GetChar(Char& ch) const {
+	constexpr bool GetChar(Char& ch) const {
 
 		if (cursor_ == end_) {
 			return false;
@@ -68,7 +117,7 @@ public:
 	}
     
 
-	bool ReadChar(Char& ch) {
+	constexpr bool ReadChar(Char& ch) {
 
 		if (cursor_ == end_) {
 			return false;
@@ -80,70 +129,88 @@ public:
 	}
 
 
-	bool ReadWord(String& word) {
+	/**
+	 Read characters until either of the delimiters or the end.
 
-		String temp_word;
+	 Delimiters are found by std::char_traits::find, that is memchr and
+	 wmemchr, which are vectorized by C libraries, so long text is scanned
+	 in bulk. The position of delimiter2 is remembered until the cursor
+	 passes it, and delimiter1 is only searched before it, so a text with
+	 many delimiter1 before a delimiter2 is scanned once by each search.
 
-		while (cursor_ != end_) {
+	 @return
+	   Whether any character is read.
+	 */
+	constexpr bool ReadUntil(Char delimiter1, Char delimiter2, StringView& text) {
 
-			auto current_char = *cursor_;
-			if (IsAlpha(current_char)) {
-				temp_word.push_back(current_char);
-				++cursor_;
-			}
-			else {
-				break;
+		using Traits = std::char_traits<Char>;
+
+		if ((delimiter2_position_ == nullptr) ||
+			(delimiter2_position_ < cursor_) ||
+			(delimiter2_ != delimiter2)) {
+
+			delimiter2_position_ = Traits::find(cursor_, end_ - cursor_, delimiter2);
+			if (delimiter2_position_ == nullptr) {
+				delimiter2_position_ = end_;
 			}
+			delimiter2_ = delimiter2;
 		}
 
-		if (temp_word.empty()) {
+		auto text_end = delimiter2_position_;
+
+		auto delimiter1_position = Traits::find(cursor_, text_end - cursor_, delimiter1);
+		if (delimiter1_position != nullptr) {
+			text_end = delimiter1_position;
+		}
+
+		if (text_end == cursor_) {
 			return false;
 		}
 
-		word = temp_word;
+		text = StringView(cursor_, text_end - cursor_);
+		cursor_ = text_end;
 		return true;
 	}
 
-	bool ReadNumber(String& number) {
 
-		String temp_number;
-		bool has_sign = false;
+	constexpr bool ReadWord(StringView& word) {
 
-		Char current_char = *cursor_;
-		if (current_char == '-' || current_char == '+') {
-			temp_number.push_back(current_char);
-			has_sign = true;
+		auto word_begin = cursor_;
+		while ((cursor_ != end_) && IsAlpha(*cursor_)) {
 			++cursor_;
 		}
 
-		while (cursor_ != end_) {
-			current_char = *cursor_;
-			if (IsDigit(current_char)) {
-				temp_number.push_back(current_char);
-				++cursor_;
-			}
-			else {
-				break;
-			}
+		if (cursor_ == word_begin) {
+			return false;
 		}
 
-		bool is_succeeded = false;
-		if (has_sign) {
-			is_succeeded = temp_number.length() > 1;
+		word = StringView(word_begin, cursor_ - word_begin);
+		return true;
+	}
+
+	constexpr bool ReadNumber(StringView& number) {
+
+		auto number_begin = cursor_;
+
+		if ((cursor_ != end_) && ((*cursor_ == '-') || (*cursor_ == '+'))) {
+			++cursor_;
 		}
-		else {
-			is_succeeded = !temp_number.empty();
+
+		auto digit_begin = cursor_;
+		while ((cursor_ != end_) && IsDigit(*cursor_)) {
+			++cursor_;
 		}
 
-		if (is_succeeded) {
-			number = temp_number;
+		if (cursor_ == digit_begin) {
+			return false;
 		}
 
-		return is_succeeded;
+		number = StringView(number_begin, cursor_ - number_begin);
+		return true;
 	}
 
 
-	void SkipWhiteSpaces() {
+	constexpr void SkipWhiteSpaces() {
 
 		while (cursor_ != end_) {
 			if (IsSpace(*cursor_)) {
@@ -156,12 +223,12 @@ public:
 	}
     
 
-    std::size_t GetCurrentIndex() const {
+    constexpr std::size_t GetCurrentIndex() const {
         return cursor_ - begin_;
     }
     
 
-    bool IsEnd() const {
+    constexpr bool IsEnd() const {
         return cursor_ == end_;
     }
     
@@ -169,6 +236,13 @@ private:
     const Char* begin_;
     const Char* end_;
     const Char* cursor_;
+
+    /**
+     The position of the first delimiter2 that is not before the cursor, or
+     the end if there is none, cached by ReadUntil.
+     */
+    const Char* delimiter2_position_ = nullptr;
+    Char delimiter2_ = 0;
 };
 
 }
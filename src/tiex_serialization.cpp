@@ -0,0 +1,490 @@
+#include "tiex_serialization.h"
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include "tiex_generate.h"
+#include "tiex_match.h"
+#include "tiex_render.h"
+
+namespace tiex {
+namespace {
+
+const char Magic[4] = { 'T', 'I', 'E', 'X' };
+const std::uint16_t Version = 1;
+
+const std::size_t HeaderSize = 24;
+const std::size_t RuleRecordSize = 24;
+const std::size_t InstructionRecordSize = 16;
+
+
+void WriteUint8(std::uint8_t value, std::string& blob) {
+	blob.push_back(static_cast<char>(value));
+}
+
+void WriteUint16(std::uint16_t value, std::string& blob) {
+	WriteUint8(static_cast<std::uint8_t>(value), blob);
+	WriteUint8(static_cast<std::uint8_t>(value >> 8), blob);
+}
+
+void WriteUint32(std::uint32_t value, std::string& blob) {
+	WriteUint16(static_cast<std::uint16_t>(value), blob);
+	WriteUint16(static_cast<std::uint16_t>(value >> 16), blob);
+}
+
+std::uint16_t ReadUint16(const unsigned char* bytes) {
+	return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+std::uint32_t ReadUint32(const unsigned char* bytes) {
+	return
+		static_cast<std::uint32_t>(bytes[0]) |
+		(static_cast<std::uint32_t>(bytes[1]) << 8) |
+		(static_cast<std::uint32_t>(bytes[2]) << 16) |
+		(static_cast<std::uint32_t>(bytes[3]) << 24);
+}
+
+std::int32_t ReadInt32(const unsigned char* bytes) {
+	std::uint32_t value = ReadUint32(bytes);
+	std::int32_t result = 0;
+	std::memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+
+bool IsLittleEndian() {
+	const std::uint16_t probe = 1;
+	unsigned char first_byte = 0;
+	std::memcpy(&first_byte, &probe, 1);
+	return first_byte == 1;
+}
+
+
+bool IsValidUnit(std::uint8_t unit) {
+	return unit <= static_cast<std::uint8_t>(Unit::Year);
+}
+
+
+void WriteBoundaryUnit(const Boundary& boundary, std::string& blob) {
+	WriteUint8(static_cast<std::uint8_t>(boundary.unit), blob);
+	WriteUint8(boundary.round ? 1 : 0, blob);
+}
+
+Boundary ReadBoundary(const unsigned char* value_bytes, const unsigned char* unit_bytes) {
+	Boundary boundary;
+	boundary.value = ReadInt32(value_bytes);
+	boundary.unit = static_cast<Unit>(unit_bytes[0]);
+	boundary.round = (unit_bytes[1] != 0);
+	return boundary;
+}
+
+
+/**
+ Sections of a blob, which are located by the header.
+ */
+class BlobSections {
+public:
+	const unsigned char* rules = nullptr;
+	std::size_t rule_count = 0;
+	const unsigned char* instructions = nullptr;
+	std::size_t instruction_count = 0;
+	const unsigned char* literals = nullptr;
+	std::size_t literal_length = 0;
+};
+
+
+class RuleRecord {
+public:
+	Condition condition;
+	bool has_standard_specifiers = false;
+	std::size_t instruction_offset = 0;
+	std::size_t instruction_count = 0;
+};
+
+RuleRecord ReadRuleRecord(const unsigned char* bytes) {
+
+	RuleRecord record;
+	record.condition.backward = ReadBoundary(bytes, bytes + 8);
+	record.condition.forward = ReadBoundary(bytes + 4, bytes + 10);
+	record.has_standard_specifiers = (bytes[12] != 0);
+	record.instruction_offset = ReadUint32(bytes + 16);
+	record.instruction_count = ReadUint32(bytes + 20);
+	return record;
+}
+
+
+Instruction ReadInstructionRecord(const unsigned char* bytes) {
+
+	Instruction instruction;
+	instruction.code = static_cast<Instruction::Code>(bytes[0]);
+	instruction.specifier.standard_char = static_cast<char>(bytes[1]);
+	instruction.specifier.unit = static_cast<Unit>(bytes[2]);
+	instruction.offset = ReadUint32(bytes + 4);
+	instruction.length = ReadUint32(bytes + 8);
+	return instruction;
+}
+
+
+bool HasFieldInstruction(const unsigned char* instructions, std::size_t offset, std::size_t count) {
+
+	for (std::size_t index = offset; index < offset + count; ++index) {
+		if (instructions[index * InstructionRecordSize] == static_cast<std::uint8_t>(Instruction::Code::Field)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool IsValidRuleRecord(const unsigned char* bytes, const unsigned char* instructions, std::size_t instruction_count) {
+
+	if (! IsValidUnit(bytes[8]) || ! IsValidUnit(bytes[10])) {
+		return false;
+	}
+
+	if ((bytes[9] > 1) || (bytes[11] > 1) || (bytes[12] > 1)) {
+		return false;
+	}
+
+	std::uint64_t offset = ReadUint32(bytes + 16);
+	std::uint64_t count = ReadUint32(bytes + 20);
+	if (offset + count > instruction_count) {
+		return false;
+	}
+
+	//Results without standard specifiers are cached, a wrong flag would make
+	//a result with fields cached and stale, so it must agree with the
+	//instructions.
+	bool has_standard_specifiers = HasFieldInstruction(
+		instructions,
+		static_cast<std::size_t>(offset),
+		static_cast<std::size_t>(count));
+
+	return (bytes[12] != 0) == has_standard_specifiers;
+}
+
+
+bool IsValidInstructionRecord(const unsigned char* bytes, std::size_t literal_length) {
+
+	auto instruction = ReadInstructionRecord(bytes);
+	switch (bytes[0]) {
+
+	case static_cast<std::uint8_t>(Instruction::Code::Literal):
+		return
+			(static_cast<std::uint64_t>(instruction.offset) + instruction.length <= literal_length);
+
+	case static_cast<std::uint8_t>(Instruction::Code::Difference):
+		return IsValidUnit(bytes[2]);
+
+	case static_cast<std::uint8_t>(Instruction::Code::Field):
+		return internal::IsStandardSpecifierChar(instruction.specifier.standard_char);
+
+	default:
+		return false;
+	}
+}
+
+
+/**
+ Validate a blob and locate its sections.
+
+ @param char_size
+   The expected size of characters of the blob.
+ */
+bool ReadBlobSections(const void* data, std::size_t size, std::size_t char_size, BlobSections& sections) {
+
+	if ((data == nullptr) || (size < HeaderSize)) {
+		return false;
+	}
+
+	auto bytes = static_cast<const unsigned char*>(data);
+	if (std::memcmp(bytes, Magic, sizeof(Magic)) != 0) {
+		return false;
+	}
+
+	if (ReadUint16(bytes + 4) != Version) {
+		return false;
+	}
+
+	if (bytes[6] != char_size) {
+		return false;
+	}
+
+	std::uint64_t rule_count = ReadUint32(bytes + 8);
+	std::uint64_t instruction_count = ReadUint32(bytes + 12);
+	std::uint64_t literal_length = ReadUint32(bytes + 16);
+
+	std::uint64_t rules_offset = HeaderSize;
+	std::uint64_t instructions_offset = rules_offset + rule_count * RuleRecordSize;
+	std::uint64_t literals_offset = instructions_offset + instruction_count * InstructionRecordSize;
+	std::uint64_t blob_size = literals_offset + literal_length * char_size;
+	if (blob_size > size) {
+		return false;
+	}
+
+	sections.rules = bytes + rules_offset;
+	sections.rule_count = static_cast<std::size_t>(rule_count);
+	sections.instructions = bytes + instructions_offset;
+	sections.instruction_count = static_cast<std::size_t>(instruction_count);
+	sections.literals = bytes + literals_offset;
+	sections.literal_length = static_cast<std::size_t>(literal_length);
+
+	for (std::size_t index = 0; index < sections.rule_count; ++index) {
+		if (! IsValidRuleRecord(sections.rules + index * RuleRecordSize, sections.instructions, sections.instruction_count)) {
+			return false;
+		}
+	}
+
+	for (std::size_t index = 0; index < sections.instruction_count; ++index) {
+		if (! IsValidInstructionRecord(sections.instructions + index * InstructionRecordSize, sections.literal_length)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}
+
+
+template<typename C>
+std::string Serialize(const BasicExpression<C>& expression) {
+
+	std::size_t instruction_count = 0;
+	std::size_t literal_length = 0;
+	for (const auto& each_rule : expression.rules) {
+		instruction_count += each_rule.result.instructions.size();
+		literal_length += each_rule.result.literals.length();
+	}
+
+	const std::size_t max_count = std::numeric_limits<std::uint32_t>::max();
+	if ((expression.rules.size() > max_count) || (instruction_count > max_count) || (literal_length > max_count)) {
+		return {};
+	}
+
+	std::string blob;
+	blob.reserve(
+		HeaderSize +
+		expression.rules.size() * RuleRecordSize +
+		instruction_count * InstructionRecordSize +
+		literal_length * sizeof(C));
+
+	blob.append(Magic, sizeof(Magic));
+	WriteUint16(Version, blob);
+	WriteUint8(static_cast<std::uint8_t>(sizeof(C)), blob);
+	WriteUint8(0, blob);
+	WriteUint32(static_cast<std::uint32_t>(expression.rules.size()), blob);
+	WriteUint32(static_cast<std::uint32_t>(instruction_count), blob);
+	WriteUint32(static_cast<std::uint32_t>(literal_length), blob);
+	WriteUint32(0, blob);
+
+	std::size_t instruction_offset = 0;
+	for (const auto& each_rule : expression.rules) {
+
+		const auto& condition = each_rule.condition;
+		WriteUint32(static_cast<std::uint32_t>(condition.backward.value), blob);
+		WriteUint32(static_cast<std::uint32_t>(condition.forward.value), blob);
+		WriteBoundaryUnit(condition.backward, blob);
+		WriteBoundaryUnit(condition.forward, blob);
+		WriteUint8(each_rule.result.has_standard_specifiers ? 1 : 0, blob);
+		blob.append(3, '\0');
+		WriteUint32(static_cast<std::uint32_t>(instruction_offset), blob);
+		WriteUint32(static_cast<std::uint32_t>(each_rule.result.instructions.size()), blob);
+
+		instruction_offset += each_rule.result.instructions.size();
+	}
+
+	//Literal offsets are rebased to the literal pool of the whole expression.
+	std::size_t literal_offset = 0;
+	for (const auto& each_rule : expression.rules) {
+
+		for (const auto& each_instruction : each_rule.result.instructions) {
+
+			WriteUint8(static_cast<std::uint8_t>(each_instruction.code), blob);
+			WriteUint8(static_cast<std::uint8_t>(each_instruction.specifier.standard_char), blob);
+			WriteUint8(static_cast<std::uint8_t>(each_instruction.specifier.unit), blob);
+			WriteUint8(0, blob);
+
+			if (each_instruction.code == Instruction::Code::Literal) {
+				WriteUint32(static_cast<std::uint32_t>(literal_offset + each_instruction.offset), blob);
+				WriteUint32(static_cast<std::uint32_t>(each_instruction.length), blob);
+			}
+			else {
+				WriteUint32(0, blob);
+				WriteUint32(0, blob);
+			}
+			WriteUint32(0, blob);
+		}
+
+		literal_offset += each_rule.result.literals.length();
+	}
+
+	for (const auto& each_rule : expression.rules) {
+		for (C ch : each_rule.result.literals) {
+			auto value = static_cast<std::make_unsigned_t<C>>(ch);
+			for (std::size_t index = 0; index < sizeof(C); ++index) {
+				WriteUint8(static_cast<std::uint8_t>(value >> (index * CHAR_BIT)), blob);
+			}
+		}
+	}
+
+	return blob;
+}
+
+
+template<typename C>
+bool Deserialize(const void* data, std::size_t size, BasicExpression<C>& expression) {
+
+	BlobSections sections;
+	if (! ReadBlobSections(data, size, sizeof(C), sections)) {
+		return false;
+	}
+
+	auto read_char = [&sections](std::size_t index) {
+		const unsigned char* bytes = sections.literals + index * sizeof(C);
+		std::make_unsigned_t<C> value = 0;
+		for (std::size_t byte_index = 0; byte_index < sizeof(C); ++byte_index) {
+			value |= static_cast<std::make_unsigned_t<C>>(
+				static_cast<std::make_unsigned_t<C>>(bytes[byte_index]) << (byte_index * CHAR_BIT));
+		}
+		return static_cast<C>(value);
+	};
+
+	BasicExpression<C> new_expression;
+	new_expression.rules.reserve(sections.rule_count);
+
+	for (std::size_t rule_index = 0; rule_index < sections.rule_count; ++rule_index) {
+
+		auto record = ReadRuleRecord(sections.rules + rule_index * RuleRecordSize);
+
+		BasicRule<C> rule;
+		rule.condition = record.condition;
+		rule.result.has_standard_specifiers = record.has_standard_specifiers;
+		rule.result.instructions.reserve(record.instruction_count);
+
+		for (std::size_t index = 0; index < record.instruction_count; ++index) {
+
+			auto instruction = ReadInstructionRecord(
+				sections.instructions + (record.instruction_offset + index) * InstructionRecordSize);
+
+			if (instruction.code == Instruction::Code::Literal) {
+
+				std::size_t pool_offset = instruction.offset;
+				instruction.offset = rule.result.literals.length();
+
+				for (std::size_t char_index = 0; char_index < instruction.length; ++char_index) {
+					rule.result.literals.push_back(read_char(pool_offset + char_index));
+				}
+			}
+
+			rule.result.instructions.push_back(instruction);
+		}
+
+		new_expression.rules.push_back(std::move(rule));
+	}
+
+	expression = std::move(new_expression);
+	return true;
+}
+
+
+template std::string Serialize(const BasicExpression<char>& expression);
+template std::string Serialize(const BasicExpression<wchar_t>& expression);
+
+template bool Deserialize(const void* data, std::size_t size, BasicExpression<char>& expression);
+template bool Deserialize(const void* data, std::size_t size, BasicExpression<wchar_t>& expression);
+
+
+namespace internal {
+
+template<typename C>
+bool OpenExpressionBlob(const void* data, std::size_t size, BasicExpressionBlob<C>& blob) {
+
+	BlobSections sections;
+	if (! ReadBlobSections(data, size, sizeof(C), sections)) {
+		return false;
+	}
+
+	//Literals are referred directly, so they must be in the layout of C.
+	if (sizeof(C) > 1) {
+
+		if (! IsLittleEndian()) {
+			return false;
+		}
+
+		if (reinterpret_cast<std::uintptr_t>(sections.literals) % alignof(C) != 0) {
+			return false;
+		}
+	}
+
+	blob.rules_ = sections.rules;
+	blob.rule_count_ = sections.rule_count;
+	blob.instructions_ = sections.instructions;
+	blob.literals_ = reinterpret_cast<const C*>(sections.literals);
+	return true;
+}
+
+
+template<typename C>
+bool Format(
+	const BasicExpressionBlob<C>& blob,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer,
+	FormatError& format_error) {
+
+	Time referenced(referenced_time, time_zone);
+	Time formatted(formatted_time, time_zone);
+
+	return FormatFirstMatchedRule(
+		blob.rule_count_,
+		[&blob](std::size_t index) {
+			return ReadRuleRecord(blob.rules_ + index * RuleRecordSize).condition;
+		},
+		referenced,
+		formatted,
+		[&](std::size_t index) {
+
+			auto rule = ReadRuleRecord(blob.rules_ + index * RuleRecordSize);
+
+			const unsigned char* instruction_bytes = blob.instructions_ + rule.instruction_offset * InstructionRecordSize;
+			for (std::size_t instruction_index = 0; instruction_index < rule.instruction_count; ++instruction_index) {
+
+				auto instruction = ReadInstructionRecord(instruction_bytes + instruction_index * InstructionRecordSize);
+				if (! GenerateInstruction(blob.literals_, instruction, referenced, formatted, locale, writer)) {
+					return false;
+				}
+			}
+			return true;
+		},
+		format_error);
+}
+
+
+template bool OpenExpressionBlob(const void* data, std::size_t size, BasicExpressionBlob<char>& blob);
+template bool OpenExpressionBlob(const void* data, std::size_t size, BasicExpressionBlob<wchar_t>& blob);
+
+template
+bool Format(
+	const BasicExpressionBlob<char>& blob,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<char>& locale,
+	Writer<char>& writer,
+	FormatError& format_error);
+
+template
+bool Format(
+	const BasicExpressionBlob<wchar_t>& blob,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<wchar_t>& locale,
+	Writer<wchar_t>& writer,
+	FormatError& format_error);
+
+}
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include "tiex_error.h"
+#include "tiex_expression.h"
+#include "tiex_locale.h"
+#include "tiex_time_zone.h"
+#include "tiex_writer.h"
+
+namespace tiex {
+
+template<typename C>
+class BasicExpressionBlob;
+
+namespace internal {
+
+template<typename C>
+bool OpenExpressionBlob(const void* data, std::size_t size, BasicExpressionBlob<C>& blob);
+
+template<typename C>
+bool Format(
+	const BasicExpressionBlob<C>& blob,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer,
+	FormatError& format_error);
+
+}
+
+/**
+ Serialize an expression to a binary blob.
+
+ The blob is compact, versioned and position independent. All integers are
+ stored in little endian, and there is no pointer in it, so it can be
+ written to a file, and mapped to memory by another process. See
+ BasicExpressionBlob for how to use it without copying.
+
+ Layout of the blob, in which all records are aligned to 8 bytes:
+
+   header        24 bytes, "TIEX", version, character size and counts.
+   rules         24 bytes for each rule, conditions and instruction ranges.
+   instructions  16 bytes for each instruction.
+   literals      Characters of all literal instructions.
+
+ @return
+   The blob in bytes.
+ */
+template<typename C>
+std::string Serialize(const BasicExpression<C>& expression);
+
+/**
+ Deserialize an expression from a binary blob, which is copied into the
+ expression.
+
+ @param data
+   The blob that is returned by Serialize.
+
+ @param size
+   Length of the blob in bytes.
+
+ @param expression
+   An output parameter that stores the expression.
+
+ @return
+   Whether the blob is valid. It is invalid if it is truncated, corrupted,
+   in an unknown version, or serialized from an expression of a different
+   character type.
+ */
+template<typename C>
+bool Deserialize(const void* data, std::size_t size, BasicExpression<C>& expression);
+
+
+/**
+ An expression blob is a validated view of a binary blob that is returned
+ by Serialize. Rules are read from the blob directly when formatting, so a
+ mapped blob is used without copying or parsing.
+
+ The blob must outlive the expression blob. Literals of the blob are
+ referred directly, so if C is not char, the blob must be aligned to C, and
+ the platform must be little endian.
+ */
+template<typename C>
+class BasicExpressionBlob {
+public:
+	using Char = C;
+
+public:
+	/**
+	 Open a blob.
+
+	 @param data
+	   The blob, which is not copied.
+
+	 @param size
+	   Length of the blob in bytes.
+
+	 @param blob
+	   An output parameter that stores the expression blob.
+
+	 @return
+	   Whether the blob is valid.
+	 */
+	static bool Open(const void* data, std::size_t size, BasicExpressionBlob& blob) {
+		return internal::OpenExpressionBlob(data, size, blob);
+	}
+
+public:
+	/**
+	 Construct an empty expression blob, which has no rule.
+	 */
+	BasicExpressionBlob() = default;
+
+	std::size_t GetRuleCount() const {
+		return rule_count_;
+	}
+
+private:
+	friend bool internal::OpenExpressionBlob<Char>(const void* data, std::size_t size, BasicExpressionBlob& blob);
+
+	friend bool internal::Format<Char>(
+		const BasicExpressionBlob& blob,
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const BasicLocale<Char>& locale,
+		internal::Writer<Char>& writer,
+		FormatError& format_error);
+
+private:
+	const unsigned char* rules_ = nullptr;
+	std::size_t rule_count_ = 0;
+	const unsigned char* instructions_ = nullptr;
+	const Char* literals_ = nullptr;
+};
+
+using ExpressionBlob = BasicExpressionBlob<char>;
+using WideExpressionBlob = BasicExpressionBlob<wchar_t>;
+
+
+/**
+ A blob formatter formats times with an expression blob, see
+ BasicExpressionBlob.
+
+ Formatting is the same as BasicFormatter, and a blob formatter is
+ immutable as well, so it can be used by multiple threads simultaneously.
+ */
+template<typename C>
+class BasicBlobFormatter {
+public:
+	using Char = C;
+	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
+	using Locale = BasicLocale<Char>;
+	using ExpressionBlob = BasicExpressionBlob<Char>;
+
+public:
+	/**
+	 Construct an empty blob formatter.
+	 */
+	BasicBlobFormatter() = default;
+
+	/**
+	 Construct a blob formatter with an expression blob.
+	 */
+	explicit BasicBlobFormatter(const ExpressionBlob& blob) : blob_(blob) {
+
+	}
+
+	/**
+	 Format times in a time zone with locale information and catch format error.
+
+	 See BasicFormatter::Format for details.
+	 */
+	String Format(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		String text;
+		internal::StringWriter<Char> writer(text);
+		if (! internal::Format(blob_, referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return {};
+		}
+		return text;
+	}
+
+	/**
+	 Format times and catch format error.
+	 */
+	String Format(std::time_t referenced_time, std::time_t formatted_time, FormatError& format_error) const {
+		return Format(referenced_time, formatted_time, TimeZone(), Locale(), format_error);
+	}
+
+	/**
+	 Format times.
+	 */
+	String Format(std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = Format(referenced_time, formatted_time, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a buffer, and
+	 catch format error.
+
+	 See BasicFormatter::FormatTo for details.
+	 */
+	std::size_t FormatTo(
+		Char* buffer,
+		std::size_t capacity,
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		internal::BufferWriter<Char> writer(buffer, capacity);
+		if (! internal::Format(blob_, referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return 0;
+		}
+		return writer.GetSize();
+	}
+
+	/**
+	 Format times to a buffer.
+	 */
+	std::size_t FormatTo(Char* buffer, std::size_t capacity, std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatTo(buffer, capacity, referenced_time, formatted_time, TimeZone(), Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a string view,
+	 and catch format error.
+
+	 See BasicFormatter::FormatView for details. Views of pure literal
+	 results refer to the blob.
+	 */
+	StringView FormatView(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		String& buffer,
+		FormatError& format_error) const {
+
+		buffer.clear();
+		internal::ViewWriter<Char> writer(buffer);
+		if (! internal::Format(blob_, referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return {};
+		}
+		return writer.GetView();
+	}
+
+	/**
+	 Format times to a string view.
+	 */
+	StringView FormatView(std::time_t referenced_time, std::time_t formatted_time, String& buffer) const {
+		FormatError error;
+		auto result = FormatView(referenced_time, formatted_time, TimeZone(), Locale(), buffer, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+private:
+	ExpressionBlob blob_;
+};
+
+using BlobFormatter = BasicBlobFormatter<char>;
+using WideBlobFormatter = BasicBlobFormatter<wchar_t>;
+
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <cassert>
+#include <ctime>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "tiex_error.h"
+#include "tiex_generate.h"
+#include "tiex_locale.h"
+#include "tiex_match.h"
+#include "tiex_static_expression.h"
+#include "tiex_time.h"
+#include "tiex_time_zone.h"
+#include "tiex_writer.h"
+
+namespace tiex {
+namespace internal {
+
+/**
+ Functions in this file format times with a static expression that is a
+ template argument, so each rule and each instruction is instantiated
+ with its boundaries and units as constants. Rule checks are unrolled, and
+ the arithmetic of units is chosen at compile time.
+ */
+
+template<int Value, bool Round, Unit U>
+bool MakeSpecializedBoundaryTime(const std::tm& tm, const TimeZone& time_zone, std::time_t& time) {
+
+	if constexpr (Value == std::numeric_limits<int>::min()) {
+		time = std::numeric_limits<std::time_t>::min();
+		return true;
+	}
+	else if constexpr (Value == std::numeric_limits<int>::max()) {
+		time = std::numeric_limits<std::time_t>::max();
+		return true;
+	}
+	else {
+		return time_zone.MakeTime(AdjustTm<U>(tm, Value, Round), time);
+	}
+}
+
+
+template<const auto& Expression, std::size_t RuleIndex>
+bool MatchSpecializedRule(const Time& referenced_time, const Time& formatted_time, bool& is_matched) {
+
+	constexpr const Condition& condition = Expression.rules[RuleIndex].condition;
+
+	is_matched = false;
+
+	auto referenced_tm = referenced_time.GetTm();
+	if (referenced_tm == nullptr) {
+		return false;
+	}
+
+	const auto& time_zone = referenced_time.GetTimeZone();
+
+	std::time_t backward_time = 0;
+	bool is_succeeded = MakeSpecializedBoundaryTime<
+		condition.backward.value,
+		condition.backward.round,
+		condition.backward.unit>(*referenced_tm, time_zone, backward_time);
+
+	if (! is_succeeded) {
+		return false;
+	}
+
+	if (backward_time <= formatted_time.GetTimet()) {
+
+		std::time_t forward_time = 0;
+		is_succeeded = MakeSpecializedBoundaryTime<
+			condition.forward.value,
+			condition.forward.round,
+			condition.forward.unit>(*referenced_tm, time_zone, forward_time);
+
+		if (! is_succeeded) {
+			return false;
+		}
+
+		is_matched = (formatted_time.GetTimet() <= forward_time);
+	}
+
+	return true;
+}
+
+
+template<const auto& Expression, std::size_t InstructionIndex, typename C>
+bool GenerateSpecializedInstruction(
+	const Time& referenced_time,
+	const Time& formatted_time,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer) {
+
+	constexpr const Instruction& instruction = Expression.instructions[InstructionIndex];
+
+	if constexpr (instruction.code == Instruction::Code::Literal) {
+		writer.WritePersistent(Expression.literals.data() + instruction.offset, instruction.length);
+		return true;
+	}
+	else if constexpr (instruction.code == Instruction::Code::Field) {
+		return GenerateStandardSpecifier(instruction.specifier.standard_char, formatted_time, locale, writer);
+	}
+	else {
+
+		long difference = 0;
+		if (! GetTimeDifference<instruction.specifier.unit>(referenced_time, formatted_time, difference)) {
+			return false;
+		}
+
+		WriteNumber(
+			(difference < 0) ? (0ull - static_cast<unsigned long long>(difference)) : static_cast<unsigned long long>(difference),
+			writer);
+		return true;
+	}
+}
+
+
+template<const auto& Expression, std::size_t RuleIndex, typename C, std::size_t... InstructionIndexes>
+bool GenerateSpecializedRule(
+	std::index_sequence<InstructionIndexes...>,
+	const Time& referenced_time,
+	const Time& formatted_time,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer) {
+
+	constexpr std::size_t offset = Expression.rules[RuleIndex].instruction_offset;
+
+	return (GenerateSpecializedInstruction<Expression, offset + InstructionIndexes>(
+		referenced_time,
+		formatted_time,
+		locale,
+		writer) && ...);
+}
+
+
+/**
+ Try a rule.
+
+ @return
+   Whether the formatting is done, either the rule is matched or an error
+   occurs, in which case is_succeeded is set.
+ */
+template<const auto& Expression, std::size_t RuleIndex, typename C>
+bool TrySpecializedRule(
+	const Time& referenced_time,
+	const Time& formatted_time,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer,
+	FormatError& format_error,
+	bool& is_succeeded) {
+
+	bool is_matched = false;
+	if (! MatchSpecializedRule<Expression, RuleIndex>(referenced_time, formatted_time, is_matched)) {
+		format_error.status = FormatError::Status::TimeError;
+		is_succeeded = false;
+		return true;
+	}
+
+	if (! is_matched) {
+		return false;
+	}
+
+	constexpr std::size_t instruction_count = Expression.rules[RuleIndex].instruction_count;
+
+	is_succeeded = GenerateSpecializedRule<Expression, RuleIndex>(
+		std::make_index_sequence<instruction_count>(),
+		referenced_time,
+		formatted_time,
+		locale,
+		writer);
+
+	if (! is_succeeded) {
+		format_error.status = FormatError::Status::TimeError;
+	}
+	return true;
+}
+
+
+template<const auto& Expression, typename C, std::size_t... RuleIndexes>
+bool FormatSpecialized(
+	std::index_sequence<RuleIndexes...>,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer,
+	FormatError& format_error) {
+
+	Time referenced(referenced_time, time_zone);
+	Time formatted(formatted_time, time_zone);
+
+	bool is_succeeded = false;
+	bool is_done = (TrySpecializedRule<Expression, RuleIndexes>(
+		referenced,
+		formatted,
+		locale,
+		writer,
+		format_error,
+		is_succeeded) || ...);
+
+	if (! is_done) {
+		format_error.status = FormatError::Status::NoMatchedRule;
+		return false;
+	}
+
+	return is_succeeded;
+}
+
+}
+
+/**
+ A specialized formatter formats times with a static expression that is
+ known at compile time, by a format function that is fully specialized for
+ the expression.
+
+ Comparing to BasicStaticFormatter, which interprets the tables of the
+ expression, the rule checks of a specialized formatter are unrolled, and
+ the units of boundaries and %~ specifiers are resolved at compile time.
+ The expression must be a variable with static storage duration:
+
+ static constexpr auto expression = TIEX_EXPR("[-1~min,0]{Just now}[*,0]{%H:%M}");
+ tiex::SpecializedFormatter<expression> formatter;
+
+ A specialized formatter has no state, so it can be used by multiple
+ threads simultaneously.
+ */
+template<const auto& Expression>
+class SpecializedFormatter {
+public:
+	using Char = typename std::decay_t<decltype(Expression)>::Char;
+	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
+	using Locale = BasicLocale<Char>;
+
+public:
+	/**
+	 Get the count of rules in the expression.
+	 */
+	static constexpr std::size_t GetRuleCount() {
+		return Expression.rules.size();
+	}
+
+	/**
+	 Format times in a time zone with locale information and catch format error.
+
+	 See BasicFormatter::Format for details.
+	 */
+	String Format(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		String text;
+		internal::StringWriter<Char> writer(text);
+		if (! Write(referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return {};
+		}
+		return text;
+	}
+
+	/**
+	 Format times and catch format error.
+	 */
+	String Format(std::time_t referenced_time, std::time_t formatted_time, FormatError& format_error) const {
+		return Format(referenced_time, formatted_time, TimeZone(), Locale(), format_error);
+	}
+
+	/**
+	 Format times.
+	 */
+	String Format(std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = Format(referenced_time, formatted_time, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a buffer, and
+	 catch format error.
+
+	 See BasicFormatter::FormatTo for details.
+	 */
+	std::size_t FormatTo(
+		Char* buffer,
+		std::size_t capacity,
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		internal::BufferWriter<Char> writer(buffer, capacity);
+		if (! Write(referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return 0;
+		}
+		return writer.GetSize();
+	}
+
+	/**
+	 Format times to a buffer.
+	 */
+	std::size_t FormatTo(Char* buffer, std::size_t capacity, std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatTo(buffer, capacity, referenced_time, formatted_time, TimeZone(), Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a string view,
+	 and catch format error.
+
+	 See BasicFormatter::FormatView for details. Views of pure literal
+	 results refer to the static expression.
+	 */
+	StringView FormatView(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		String& buffer,
+		FormatError& format_error) const {
+
+		buffer.clear();
+		internal::ViewWriter<Char> writer(buffer);
+		if (! Write(referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return {};
+		}
+		return writer.GetView();
+	}
+
+	/**
+	 Format times to a string view.
+	 */
+	StringView FormatView(std::time_t referenced_time, std::time_t formatted_time, String& buffer) const {
+		FormatError error;
+		auto result = FormatView(referenced_time, formatted_time, TimeZone(), Locale(), buffer, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+private:
+	bool Write(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		internal::Writer<Char>& writer,
+		FormatError& format_error) const {
+
+		return internal::FormatSpecialized<Expression>(
+			std::make_index_sequence<GetRuleCount()>(),
+			referenced_time,
+			formatted_time,
+			time_zone,
+			locale,
+			writer,
+			format_error);
+	}
+};
+
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include "tiex_error.h"
+#include "tiex_expression.h"
+#include "tiex_parser.h"
+#include "tiex_scanner.h"
+
+namespace tiex {
+
+/**
+ A rule of a static expression, whose result is a range of instructions in
+ the instruction table of the expression.
+ */
+class StaticRule {
+public:
+	Condition condition;
+	std::size_t instruction_offset = 0;
+	std::size_t instruction_count = 0;
+	bool has_standard_specifiers = false;
+};
+
+
+/**
+ A static expression is a format expression that is parsed at compile
+ time, see TIEX_EXPR.
+
+ Rules, instructions and literals are stored in fixed-size tables, whose
+ sizes are exactly what the expression needs. Offsets of literal
+ instructions refer to the literal table of the whole expression, rather
+ than the literals of each result.
+ */
+template<typename C, std::size_t RuleCount, std::size_t InstructionCount, std::size_t LiteralLength>
+class StaticExpression {
+public:
+	using Char = C;
+
+public:
+	std::array<StaticRule, RuleCount> rules{};
+	std::array<Instruction, InstructionCount> instructions{};
+	std::array<Char, LiteralLength> literals{};
+};
+
+namespace internal {
+
+/**
+ A view of the tables of a static expression, whose sizes are erased.
+ */
+template<typename C>
+class StaticExpressionView {
+public:
+	const StaticRule* rules = nullptr;
+	std::size_t rule_count = 0;
+	const Instruction* instructions = nullptr;
+	const C* literals = nullptr;
+};
+
+
+/**
+ Sizes of the tables of a static expression, and the error of parsing it.
+ */
+class StaticExpressionSize {
+public:
+	std::size_t rule_count = 0;
+	std::size_t instruction_count = 0;
+	std::size_t literal_length = 0;
+	ParseError parse_error;
+};
+
+
+/**
+ A sink of Parser that can be evaluated at compile time, which writes rules,
+ instructions and literals to the tables of a static expression.
+
+ The parser runs twice on an expression, the first pass measures the sizes
+ of the tables without a table, and the second pass fills the tables.
+ */
+template<typename C, typename Table>
+class StaticTableSink {
+public:
+	using Char = C;
+	using Rule = StaticRule;
+	using Result = StaticRule;
+
+	/**
+	 Rules are written to the table directly, nothing is left in the
+	 expression.
+	 */
+	class Expression { };
+
+public:
+	constexpr explicit StaticTableSink(Table* table) : table_(table) {
+
+	}
+
+	constexpr void AddRule(Expression& expression, Rule&& rule) {
+
+		if (table_ != nullptr) {
+			table_->rules[size_.rule_count] = rule;
+		}
+		++size_.rule_count;
+	}
+
+	constexpr void MakeRule(const Condition& condition, Result&& result, Rule& rule) {
+		rule = result;
+		rule.condition = condition;
+	}
+
+	constexpr void BeginResult(Result& result) {
+		result.instruction_offset = size_.instruction_count;
+		is_last_literal_ = false;
+	}
+
+	constexpr void EndResult(Result& result) {
+		result.instruction_count = size_.instruction_count - result.instruction_offset;
+	}
+
+	constexpr void AppendLiteral(Result& result, const Char* chars, std::size_t length) {
+
+		if (! is_last_literal_) {
+			Instruction instruction;
+			instruction.code = Instruction::Code::Literal;
+			instruction.offset = size_.literal_length;
+			AppendInstruction(result, instruction);
+		}
+
+		if (table_ != nullptr) {
+			for (std::size_t index = 0; index < length; ++index) {
+				table_->literals[size_.literal_length + index] = chars[index];
+			}
+			table_->instructions[size_.instruction_count - 1].length += length;
+		}
+
+		size_.literal_length += length;
+	}
+
+	constexpr void AppendInstruction(Result& result, const Instruction& instruction) {
+
+		if (table_ != nullptr) {
+			table_->instructions[size_.instruction_count] = instruction;
+		}
+
+		++size_.instruction_count;
+		is_last_literal_ = (instruction.code == Instruction::Code::Literal);
+
+		if (instruction.code == Instruction::Code::Field) {
+			result.has_standard_specifiers = true;
+		}
+	}
+
+	/**
+	 Get the sizes of the tables, the parse error is not set.
+	 */
+	constexpr const StaticExpressionSize& GetSize() const {
+		return size_;
+	}
+
+private:
+	Table* table_;
+	bool is_last_literal_ = false;
+	StaticExpressionSize size_;
+};
+
+
+/**
+ Parse an expression at compile time, and fill the tables if there is a
+ table.
+ */
+template<typename C, typename Table>
+constexpr StaticExpressionSize ParseStaticExpression(std::basic_string_view<C> string, Table* table) {
+
+	Scanner<C> scanner(string);
+	Parser<C, StaticTableSink<C, Table>> parser(scanner, StaticTableSink<C, Table>(table));
+	parser.Parse();
+
+	auto size = parser.GetSink().GetSize();
+	size.parse_error = parser.GetParseError();
+	return size;
+}
+
+
+/**
+ Measure the sizes of the tables of an expression, and check whether it is
+ valid.
+ */
+template<typename C>
+constexpr StaticExpressionSize MeasureStaticExpression(std::basic_string_view<C> string) {
+	return ParseStaticExpression<C, StaticExpression<C, 0, 0, 0>>(string, nullptr);
+}
+
+
+template<typename C, std::size_t RuleCount, std::size_t InstructionCount, std::size_t LiteralLength>
+constexpr StaticExpression<C, RuleCount, InstructionCount, LiteralLength> CompileStaticExpression(
+	std::basic_string_view<C> string) {
+
+	StaticExpression<C, RuleCount, InstructionCount, LiteralLength> expression;
+	ParseStaticExpression<C>(string, &expression);
+	return expression;
+}
+
+
+template<typename C, std::size_t N>
+constexpr std::basic_string_view<C> MakeStringView(const C (&string)[N]) {
+	return std::basic_string_view<C>(string, N - 1);
+}
+
+
+/**
+ Make a static expression from a string that is returned by a constexpr
+ lambda, so that the string can be used as a constant expression to
+ determine the sizes of the tables.
+ */
+template<typename StringProvider>
+constexpr auto MakeStaticExpression(StringProvider provider) {
+
+	constexpr auto string = provider();
+	using Char = typename std::decay_t<decltype(string)>::value_type;
+
+	constexpr auto size = MeasureStaticExpression<Char>(string);
+	static_assert(size.parse_error.status == ParseError::Status::None, "The tiex expression is malformed.");
+
+	return CompileStaticExpression<Char, size.rule_count, size.instruction_count, size.literal_length>(string);
+}
+
+}
+}
+
+/**
+ Parse a format expression string literal at compile time, and get a
+ static expression, which is used to construct a static formatter.
+ Malformed expressions fail the build.
+
+ For example:
+
+ static constexpr auto expression = TIEX_EXPR("[-1~min,0]{Just now}[*,0]{%H:%M}");
+ static constexpr tiex::StaticFormatter formatter(expression);
+ */
+#define TIEX_EXPR(string) \
+	(::tiex::internal::MakeStaticExpression([] { return ::tiex::internal::MakeStringView(string); }))
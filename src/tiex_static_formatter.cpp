@@ -0,0 +1,63 @@
+#include "tiex_static_formatter.h"
+#include "tiex_generate.h"
+#include "tiex_match.h"
+
+namespace tiex {
+namespace internal {
+
+template<typename C>
+bool Format(
+	const StaticExpressionView<C>& expression,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer,
+	FormatError& format_error) {
+
+	internal::Time referenced(referenced_time, time_zone);
+	internal::Time formatted(formatted_time, time_zone);
+
+	return internal::FormatFirstMatchedRule(
+		expression.rule_count,
+		[&expression](std::size_t index) -> const Condition& {
+			return expression.rules[index].condition;
+		},
+		referenced,
+		formatted,
+		[&](std::size_t index) {
+			const auto& rule = expression.rules[index];
+			return GenerateInstructions(
+				expression.literals,
+				expression.instructions + rule.instruction_offset,
+				rule.instruction_count,
+				referenced,
+				formatted,
+				locale,
+				writer);
+		},
+		format_error);
+}
+
+template
+bool Format(
+	const StaticExpressionView<char>& expression,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<char>& locale,
+	Writer<char>& writer,
+	FormatError& format_error);
+
+template
+bool Format(
+	const StaticExpressionView<wchar_t>& expression,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<wchar_t>& locale,
+	Writer<wchar_t>& writer,
+	FormatError& format_error);
+
+}
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cassert>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include "tiex_error.h"
+#include "tiex_locale.h"
+#include "tiex_static_expression.h"
+#include "tiex_time_zone.h"
+#include "tiex_writer.h"
+
+namespace tiex {
+namespace internal {
+
+template<typename C>
+bool Format(
+	const StaticExpressionView<C>& expression,
+	std::time_t referenced_time,
+	std::time_t formatted_time,
+	const TimeZone& time_zone,
+	const BasicLocale<C>& locale,
+	Writer<C>& writer,
+	FormatError& format_error);
+
+}
+
+/**
+ A static formatter formats times with a static expression, which is parsed
+ at compile time by TIEX_EXPR, so creating it does no parsing and no
+ allocation.
+
+ A static formatter refers to the tables of the static expression, which
+ must outlive the formatter. Typically, both of them are declared as
+ static constexpr variables:
+
+ static constexpr auto expression = TIEX_EXPR("[-1~min,0]{Just now}[*,0]{%H:%M}");
+ static constexpr tiex::StaticFormatter formatter(expression);
+
+ Formatting is the same as BasicFormatter, and a static formatter is
+ immutable as well, so it can be used by multiple threads simultaneously.
+ */
+template<typename C>
+class BasicStaticFormatter {
+public:
+	using Char = C;
+	using String = std::basic_string<Char>;
+	using StringView = std::basic_string_view<Char>;
+	using Locale = BasicLocale<Char>;
+
+public:
+	/**
+	 Construct a static formatter with a static expression.
+	 */
+	template<std::size_t RuleCount, std::size_t InstructionCount, std::size_t LiteralLength>
+	constexpr explicit BasicStaticFormatter(
+		const StaticExpression<Char, RuleCount, InstructionCount, LiteralLength>& expression) :
+
+		expression_{
+			expression.rules.data(),
+			RuleCount,
+			expression.instructions.data(),
+			expression.literals.data(),
+		} {
+
+	}
+
+	/**
+	 Get the count of rules in the expression.
+	 */
+	constexpr std::size_t GetRuleCount() const {
+		return expression_.rule_count;
+	}
+
+	/**
+	 Format times in a time zone with locale information and catch format error.
+
+	 See BasicFormatter::Format for details.
+	 */
+	String Format(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		String text;
+		internal::StringWriter<Char> writer(text);
+		if (! internal::Format(expression_, referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return {};
+		}
+		return text;
+	}
+
+	/**
+	 Format times and catch format error.
+	 */
+	String Format(std::time_t referenced_time, std::time_t formatted_time, FormatError& format_error) const {
+		return Format(referenced_time, formatted_time, TimeZone(), Locale(), format_error);
+	}
+
+	/**
+	 Format times.
+	 */
+	String Format(std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = Format(referenced_time, formatted_time, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a buffer, and
+	 catch format error.
+
+	 See BasicFormatter::FormatTo for details.
+	 */
+	std::size_t FormatTo(
+		Char* buffer,
+		std::size_t capacity,
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		FormatError& format_error) const {
+
+		internal::BufferWriter<Char> writer(buffer, capacity);
+		if (! internal::Format(expression_, referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return 0;
+		}
+		return writer.GetSize();
+	}
+
+	/**
+	 Format times to a buffer.
+	 */
+	std::size_t FormatTo(Char* buffer, std::size_t capacity, std::time_t referenced_time, std::time_t formatted_time) const {
+		FormatError error;
+		auto result = FormatTo(buffer, capacity, referenced_time, formatted_time, TimeZone(), Locale(), error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+	/**
+	 Format times in a time zone with locale information to a string view,
+	 and catch format error.
+
+	 See BasicFormatter::FormatView for details. Views of pure literal
+	 results refer to the static expression.
+	 */
+	StringView FormatView(
+		std::time_t referenced_time,
+		std::time_t formatted_time,
+		const TimeZone& time_zone,
+		const Locale& locale,
+		String& buffer,
+		FormatError& format_error) const {
+
+		buffer.clear();
+		internal::ViewWriter<Char> writer(buffer);
+		if (! internal::Format(expression_, referenced_time, formatted_time, time_zone, locale, writer, format_error)) {
+			return {};
+		}
+		return writer.GetView();
+	}
+
+	/**
+	 Format times to a string view.
+	 */
+	StringView FormatView(std::time_t referenced_time, std::time_t formatted_time, String& buffer) const {
+		FormatError error;
+		auto result = FormatView(referenced_time, formatted_time, TimeZone(), Locale(), buffer, error);
+		assert(error.status == FormatError::Status::None);
+		return result;
+	}
+
+private:
+	internal::StaticExpressionView<Char> expression_;
+};
+
+using StaticFormatter = BasicStaticFormatter<char>;
+using WideStaticFormatter = BasicStaticFormatter<wchar_t>;
+
+}
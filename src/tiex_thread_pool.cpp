@@ -0,0 +1,130 @@
+#include "tiex_thread_pool.h"
+#include <atomic>
+#include <memory>
+
+namespace tiex {
+
+ThreadPool::ThreadPool(std::size_t thread_count) {
+
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+        if (thread_count == 0) {
+            thread_count = 1;
+        }
+    }
+
+    threads_.reserve(thread_count);
+    for (std::size_t index = 0; index < thread_count; ++index) {
+        threads_.emplace_back([this]() {
+            RunWorker();
+        });
+    }
+}
+
+
+ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopped_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto& each_thread : threads_) {
+        each_thread.join();
+    }
+}
+
+
+void ThreadPool::Run(std::size_t task_count, const std::function<void(std::size_t)>& task) {
+
+    if (task_count == 0) {
+        return;
+    }
+
+    //Indexes are claimed by whichever thread is free, and the calling
+    //thread takes part as well, so tasks complete even if all workers are
+    //busy. The state is shared with helpers, since a helper may be
+    //dequeued after all indexes have been claimed and this call returns;
+    //such a helper finds no index and never touches the task.
+    struct State {
+        const std::function<void(std::size_t)>* task = nullptr;
+        std::size_t task_count = 0;
+        std::atomic<std::size_t> next_index{ 0 };
+        std::atomic<std::size_t> completed_count{ 0 };
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+
+    auto state = std::make_shared<State>();
+    state->task = &task;
+    state->task_count = task_count;
+
+    auto run_tasks = [](State& state) {
+
+        std::size_t run_count = 0;
+        while (true) {
+
+            auto index = state.next_index.fetch_add(1);
+            if (index >= state.task_count) {
+                break;
+            }
+
+            (*state.task)(index);
+            ++run_count;
+        }
+
+        if ((run_count != 0) &&
+            (state.completed_count.fetch_add(run_count) + run_count == state.task_count)) {
+
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.condition.notify_all();
+        }
+    };
+
+    std::size_t helper_count = (task_count - 1 < threads_.size()) ? (task_count - 1) : threads_.size();
+    if (helper_count != 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::size_t index = 0; index < helper_count; ++index) {
+                tasks_.push_back([run_tasks, state]() {
+                    run_tasks(*state);
+                });
+            }
+        }
+        condition_.notify_all();
+    }
+
+    run_tasks(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state]() {
+        return state->completed_count.load() == state->task_count;
+    });
+}
+
+
+void ThreadPool::RunWorker() {
+
+    while (true) {
+
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() {
+                return is_stopped_ || ! tasks_.empty();
+            });
+
+            if (tasks_.empty()) {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
+
+}
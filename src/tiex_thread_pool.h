@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tiex {
+
+/**
+ A thread pool runs tasks on a fixed number of worker threads.
+
+ It is used to format huge batches of times in parallel, see
+ BasicBoundFormatter::FormatBatch. Create one thread pool and reuse it for
+ multiple batches, to avoid creating threads for each batch.
+ */
+class ThreadPool {
+public:
+	/**
+	 Construct a thread pool.
+
+	 @param thread_count
+	   Count of worker threads. If it is 0, the number of concurrent threads
+	   supported by the hardware is used.
+	 */
+	explicit ThreadPool(std::size_t thread_count = 0);
+
+	/**
+	 Destruct the thread pool, waiting for all worker threads to exit.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 Get the count of worker threads.
+	 */
+	std::size_t GetThreadCount() const {
+		return threads_.size();
+	}
+
+	/**
+	 Run a task for each index in [0, task_count), and wait for all of them
+	 to complete.
+
+	 Tasks are run on the worker threads as well as the calling thread, in
+	 an unspecified order.
+	 */
+	void Run(std::size_t task_count, const std::function<void(std::size_t)>& task);
+
+private:
+	void RunWorker();
+
+private:
+	std::vector<std::thread> threads_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::deque<std::function<void()>> tasks_;
+	bool is_stopped_ = false;
+};
+
+}
@@ -1,19 +1,55 @@
 #pragma once
 
 #include <ctime>
+#include "tiex_time_zone.h"
 
 namespace tiex {
 namespace internal {
 
+inline const TimeZone& GetLocalTimeZone() {
+    static const TimeZone time_zone;
+    return time_zone;
+}
+
+
 class Time {
 public:
-    Time(std::time_t timet) : timet_(timet), has_tm_(false) {
+    Time(std::time_t timet) : Time(timet, GetLocalTimeZone()) {
+
+    }
+    
+    Time(std::time_t timet, const TimeZone& time_zone) : 
+        timet_(timet), 
+        time_zone_(&time_zone),
+        has_tm_(false) {
+
         tm_ = { 0 };
     }
+
+    /**
+     Construct with a tm that has been converted from timet in the time zone.
+     */
+    Time(std::time_t timet, const std::tm& tm, const TimeZone& time_zone) :
+        timet_(timet),
+        time_zone_(&time_zone),
+        has_tm_(true),
+        tm_(tm) {
+
+    }
+
+    /**
+     The time zone is referred, so a temporary one is not allowed.
+     */
+    Time(std::time_t timet, TimeZone&& time_zone) = delete;
+    Time(std::time_t timet, const std::tm& tm, TimeZone&& time_zone) = delete;
     
     std::time_t GetTimet() const {
         return timet_;
     }
+
+    const TimeZone& GetTimeZone() const {
+        return *time_zone_;
+    }
     
     const std::tm* GetTm() const {
         
@@ -21,10 +57,7 @@ public:
             return &tm_;
         }
         
-        auto tm = std::localtime(&timet_);
-        if (tm != nullptr) {
-            
-            tm_ = *tm;
+        if (time_zone_->ToTm(timet_, tm_)) {
             has_tm_ = true;
             return &tm_;
         }
@@ -34,6 +67,7 @@ public:
 
 private:
     std::time_t timet_;
+    const TimeZone* time_zone_;
     mutable bool has_tm_;
     mutable std::tm tm_;
 };
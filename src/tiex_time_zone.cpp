@@ -0,0 +1,911 @@
+#include "tiex_time_zone.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <vector>
+#include "tiex_civil.h"
+
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+#define TIEX_TM_HAS_ZONE_FIELDS 1
+#endif
+
+namespace tiex {
+namespace internal {
+
+/**
+ A type of local time, defined by TZif.
+ */
+class LocalTimeType {
+public:
+    std::int32_t offset = 0;
+    bool is_dst = false;
+    std::string abbreviation;
+};
+
+
+/**
+ A transition of POSIX TZ string, such as "M3.2.0/2".
+ */
+class PosixTransition {
+public:
+    enum class Kind {
+        //Jn, 1 <= n <= 365, February 29 is never counted.
+        Julian,
+        //n, 0 <= n <= 365, February 29 is counted in leap years.
+        ZeroBasedJulian,
+        //Mm.w.d, the d'th day of week w of month m.
+        MonthWeekDay,
+    };
+
+public:
+    Kind kind = Kind::MonthWeekDay;
+    int day = 0;
+    int month = 0;
+    int week = 0;
+    int weekday = 0;
+
+    /**
+     Seconds since the local midnight, may be negative or greater than 24
+     hours.
+     */
+    std::int32_t time = 2 * 60 * 60;
+};
+
+
+/**
+ The rule in footer of TZif, which is a POSIX TZ string, is used for
+ times after the last transition.
+ */
+class PosixRule {
+public:
+    LocalTimeType standard;
+    LocalTimeType daylight;
+    bool has_dst = false;
+    PosixTransition start;
+    PosixTransition end;
+};
+
+
+class TimeZoneData {
+public:
+    std::vector<std::int64_t> transition_times;
+    std::vector<std::uint8_t> transition_types;
+    std::vector<LocalTimeType> types;
+    bool has_rule = false;
+    PosixRule rule;
+
+    /**
+     Index of the transition found lastly. Times to look up are usually
+     close to each other, so they are likely in the same period.
+     */
+    mutable std::atomic<std::size_t> cached_index{ 0 };
+};
+
+namespace {
+
+constexpr std::int64_t SecondsPerDay = 24 * 60 * 60;
+constexpr const char* ZoneInfoDirectory = "/usr/share/zoneinfo/";
+
+
+bool ToTime(std::int64_t seconds, std::time_t& time) {
+
+    if ((seconds < std::numeric_limits<std::time_t>::min()) ||
+        (seconds > std::numeric_limits<std::time_t>::max())) {
+        return false;
+    }
+
+    time = static_cast<std::time_t>(seconds);
+    return true;
+}
+
+
+bool GetLocalTm(std::time_t time, std::tm& tm) {
+#ifdef _WIN32
+    return localtime_s(&tm, &time) == 0;
+#else
+    return localtime_r(&time, &tm) != nullptr;
+#endif
+}
+
+
+bool IsLeapYear(std::int64_t year) {
+    return ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+}
+
+
+std::int64_t GetYear(std::int64_t civil_seconds) {
+
+    std::int64_t days = civil_seconds / SecondsPerDay;
+    if ((civil_seconds % SecondsPerDay) < 0) {
+        --days;
+    }
+
+    std::int64_t year = 0;
+    int month = 0;
+    int day = 0;
+    CivilFromDays(days, year, month, day);
+    return year;
+}
+
+
+/**
+ Get the civil seconds that a transition occurs in a year.
+ */
+std::int64_t GetTransitionCivilSeconds(const PosixTransition& transition, std::int64_t year) {
+
+    std::int64_t days = 0;
+
+    switch (transition.kind) {
+
+        case PosixTransition::Kind::Julian:
+            days = DaysFromCivil(year, 1, 1) + transition.day - 1;
+            if (IsLeapYear(year) && (transition.day >= 60)) {
+                ++days;
+            }
+            break;
+
+        case PosixTransition::Kind::ZeroBasedJulian:
+            days = DaysFromCivil(year, 1, 1) + transition.day;
+            break;
+
+        case PosixTransition::Kind::MonthWeekDay: {
+
+            std::int64_t first_day = DaysFromCivil(year, transition.month, 1);
+            std::int64_t next_month_first_day =
+                (transition.month == 12) ?
+                DaysFromCivil(year + 1, 1, 1) :
+                DaysFromCivil(year, transition.month + 1, 1);
+
+            days = first_day + (transition.weekday - GetWeekday(first_day) + 7) % 7;
+            days += (transition.week - 1) * 7;
+
+            //Week 5 means the last one in the month.
+            while (days >= next_month_first_day) {
+                days -= 7;
+            }
+            break;
+        }
+    }
+
+    return days * SecondsPerDay + transition.time;
+}
+
+
+const LocalTimeType& FindRuleType(const PosixRule& rule, std::int64_t time) {
+
+    if (! rule.has_dst) {
+        return rule.standard;
+    }
+
+    std::int64_t year = GetYear(time + rule.standard.offset);
+    std::int64_t start_time = GetTransitionCivilSeconds(rule.start, year) - rule.standard.offset;
+    std::int64_t end_time = GetTransitionCivilSeconds(rule.end, year) - rule.daylight.offset;
+
+    bool is_dst = false;
+    if (start_time < end_time) {
+        is_dst = (start_time <= time) && (time < end_time);
+    }
+    else {
+        //DST spans the new year, which is usual in southern hemisphere.
+        is_dst = !((end_time <= time) && (time < start_time));
+    }
+
+    return is_dst ? rule.daylight : rule.standard;
+}
+
+
+const LocalTimeType& FindType(const TimeZoneData& data, std::int64_t time) {
+
+    const auto& times = data.transition_times;
+
+    if (times.empty() || (time >= times.back())) {
+        if (data.has_rule) {
+            return FindRuleType(data.rule, time);
+        }
+        return times.empty() ? data.types.front() : data.types[data.transition_types.back()];
+    }
+
+    //Times before the first transition use the first type.
+    if (time < times.front()) {
+        return data.types.front();
+    }
+
+    std::size_t index = data.cached_index.load(std::memory_order_relaxed);
+    bool is_hit =
+        (index + 1 < times.size()) &&
+        (times[index] <= time) &&
+        (time < times[index + 1]);
+
+    if (! is_hit) {
+        index = std::upper_bound(times.begin(), times.end(), time) - times.begin() - 1;
+        data.cached_index.store(index, std::memory_order_relaxed);
+    }
+
+    return data.types[data.transition_types[index]];
+}
+
+
+class TzifReader {
+public:
+    TzifReader(const unsigned char* data, std::size_t size) : cursor_(data), end_(data + size) {
+
+    }
+
+    bool Skip(std::size_t size) {
+        if (static_cast<std::size_t>(end_ - cursor_) < size) {
+            return false;
+        }
+        cursor_ += size;
+        return true;
+    }
+
+    bool ReadBytes(std::size_t size, const unsigned char*& bytes) {
+        bytes = cursor_;
+        return Skip(size);
+    }
+
+    bool ReadInteger(std::size_t size, std::int64_t& value) {
+
+        const unsigned char* bytes = nullptr;
+        if (! ReadBytes(size, bytes)) {
+            return false;
+        }
+
+        std::uint64_t unsigned_value = 0;
+        for (std::size_t index = 0; index < size; ++index) {
+            unsigned_value = (unsigned_value << 8) | bytes[index];
+        }
+
+        //Sign extend.
+        if ((size < 8) && (bytes[0] & 0x80)) {
+            unsigned_value |= ~((std::uint64_t(1) << (size * 8)) - 1);
+        }
+
+        value = static_cast<std::int64_t>(unsigned_value);
+        return true;
+    }
+
+    bool IsEnd() const {
+        return cursor_ == end_;
+    }
+
+    const unsigned char* GetCursor() const {
+        return cursor_;
+    }
+
+    const unsigned char* GetEnd() const {
+        return end_;
+    }
+
+private:
+    const unsigned char* cursor_;
+    const unsigned char* end_;
+};
+
+
+class TzifHeader {
+public:
+    char version = 0;
+    std::int64_t utc_indicator_count = 0;
+    std::int64_t standard_indicator_count = 0;
+    std::int64_t leap_count = 0;
+    std::int64_t transition_count = 0;
+    std::int64_t type_count = 0;
+    std::int64_t char_count = 0;
+};
+
+
+bool ReadTzifHeader(TzifReader& reader, TzifHeader& header) {
+
+    const unsigned char* magic = nullptr;
+    if (! reader.ReadBytes(4, magic)) {
+        return false;
+    }
+
+    if ((magic[0] != 'T') || (magic[1] != 'Z') || (magic[2] != 'i') || (magic[3] != 'f')) {
+        return false;
+    }
+
+    const unsigned char* version = nullptr;
+    if (! reader.ReadBytes(1, version) || ! reader.Skip(15)) {
+        return false;
+    }
+    header.version = static_cast<char>(version[0]);
+
+    for (auto count : {
+        &header.utc_indicator_count,
+        &header.standard_indicator_count,
+        &header.leap_count,
+        &header.transition_count,
+        &header.type_count,
+        &header.char_count }) {
+
+        if (! reader.ReadInteger(4, *count) || (*count < 0)) {
+            return false;
+        }
+    }
+
+    return header.type_count > 0;
+}
+
+
+std::size_t GetTzifDataSize(const TzifHeader& header, std::size_t time_size) {
+    return static_cast<std::size_t>(
+        header.transition_count * time_size +
+        header.transition_count +
+        header.type_count * 6 +
+        header.char_count +
+        header.leap_count * (time_size + 4) +
+        header.standard_indicator_count +
+        header.utc_indicator_count);
+}
+
+
+bool ReadTzifData(TzifReader& reader, const TzifHeader& header, std::size_t time_size, TimeZoneData& data) {
+
+    data.transition_times.resize(static_cast<std::size_t>(header.transition_count));
+    for (auto& each_time : data.transition_times) {
+        if (! reader.ReadInteger(time_size, each_time)) {
+            return false;
+        }
+    }
+
+    if (! std::is_sorted(data.transition_times.begin(), data.transition_times.end())) {
+        return false;
+    }
+
+    data.transition_types.resize(static_cast<std::size_t>(header.transition_count));
+    for (auto& each_type : data.transition_types) {
+        std::int64_t type = 0;
+        if (! reader.ReadInteger(1, type)) {
+            return false;
+        }
+        each_type = static_cast<std::uint8_t>(type);
+        if (each_type >= header.type_count) {
+            return false;
+        }
+    }
+
+    std::vector<std::int64_t> abbreviation_indexes;
+    data.types.resize(static_cast<std::size_t>(header.type_count));
+    for (auto& each_type : data.types) {
+
+        std::int64_t offset = 0;
+        std::int64_t is_dst = 0;
+        std::int64_t abbreviation_index = 0;
+        if (! reader.ReadInteger(4, offset) ||
+            ! reader.ReadInteger(1, is_dst) ||
+            ! reader.ReadInteger(1, abbreviation_index)) {
+            return false;
+        }
+
+        each_type.offset = static_cast<std::int32_t>(offset);
+        each_type.is_dst = (is_dst & 0xff) != 0;
+        abbreviation_indexes.push_back(abbreviation_index & 0xff);
+    }
+
+    const unsigned char* chars = nullptr;
+    if (! reader.ReadBytes(static_cast<std::size_t>(header.char_count), chars)) {
+        return false;
+    }
+
+    for (std::size_t index = 0; index < data.types.size(); ++index) {
+
+        auto begin = abbreviation_indexes[index];
+        if (begin >= header.char_count) {
+            return false;
+        }
+
+        auto end = begin;
+        while ((end < header.char_count) && (chars[end] != 0)) {
+            ++end;
+        }
+
+        data.types[index].abbreviation.assign(chars + begin, chars + end);
+    }
+
+    //Leap seconds and indicators are not used.
+    return reader.Skip(static_cast<std::size_t>(
+        header.leap_count * (time_size + 4) +
+        header.standard_indicator_count +
+        header.utc_indicator_count));
+}
+
+
+class PosixRuleParser {
+public:
+    PosixRuleParser(const char* begin, const char* end) : cursor_(begin), end_(end) {
+
+    }
+
+    bool Parse(PosixRule& rule) {
+
+        std::int32_t offset = 0;
+        if (! ParseAbbreviation(rule.standard.abbreviation) || ! ParseOffset(24, offset)) {
+            return false;
+        }
+
+        //Offsets in POSIX TZ strings are positive at west of Greenwich.
+        rule.standard.offset = -offset;
+
+        if (cursor_ == end_) {
+            return true;
+        }
+
+        rule.has_dst = true;
+        rule.daylight.is_dst = true;
+        if (! ParseAbbreviation(rule.daylight.abbreviation)) {
+            return false;
+        }
+
+        rule.daylight.offset = rule.standard.offset + 60 * 60;
+        if ((cursor_ != end_) && (*cursor_ != ',')) {
+            if (! ParseOffset(24, offset)) {
+                return false;
+            }
+            rule.daylight.offset = -offset;
+        }
+
+        if (cursor_ == end_) {
+            //Rules of United States are the default.
+            rule.start.month = 3;
+            rule.start.week = 2;
+            rule.end.month = 11;
+            rule.end.week = 1;
+            return true;
+        }
+
+        return
+            ParseChar(',') && ParseTransition(rule.start) &&
+            ParseChar(',') && ParseTransition(rule.end) &&
+            (cursor_ == end_);
+    }
+
+private:
+    bool ParseChar(char ch) {
+        if ((cursor_ == end_) || (*cursor_ != ch)) {
+            return false;
+        }
+        ++cursor_;
+        return true;
+    }
+
+    bool ParseAbbreviation(std::string& abbreviation) {
+
+        if (ParseChar('<')) {
+            auto begin = cursor_;
+            while ((cursor_ != end_) && (*cursor_ != '>')) {
+                ++cursor_;
+            }
+            abbreviation.assign(begin, cursor_);
+            return ParseChar('>') && ! abbreviation.empty();
+        }
+
+        auto begin = cursor_;
+        while ((cursor_ != end_) &&
+            ((('a' <= *cursor_) && (*cursor_ <= 'z')) || (('A' <= *cursor_) && (*cursor_ <= 'Z')))) {
+            ++cursor_;
+        }
+        abbreviation.assign(begin, cursor_);
+        return ! abbreviation.empty();
+    }
+
+    bool ParseNumber(int max_value, int& value) {
+
+        if ((cursor_ == end_) || (*cursor_ < '0') || (*cursor_ > '9')) {
+            return false;
+        }
+
+        value = 0;
+        while ((cursor_ != end_) && ('0' <= *cursor_) && (*cursor_ <= '9')) {
+            value = value * 10 + (*cursor_ - '0');
+            if (value > max_value) {
+                return false;
+            }
+            ++cursor_;
+        }
+        return true;
+    }
+
+    bool ParseOffset(int max_hours, std::int32_t& offset) {
+
+        int sign = 1;
+        if (ParseChar('-')) {
+            sign = -1;
+        }
+        else {
+            ParseChar('+');
+        }
+
+        int hours = 0;
+        int minutes = 0;
+        int seconds = 0;
+        if (! ParseNumber(max_hours, hours)) {
+            return false;
+        }
+
+        if (ParseChar(':')) {
+            if (! ParseNumber(59, minutes)) {
+                return false;
+            }
+            if (ParseChar(':') && ! ParseNumber(59, seconds)) {
+                return false;
+            }
+        }
+
+        offset = sign * (hours * 60 * 60 + minutes * 60 + seconds);
+        return true;
+    }
+
+    bool ParseTransition(PosixTransition& transition) {
+
+        if (ParseChar('M')) {
+            transition.kind = PosixTransition::Kind::MonthWeekDay;
+            if (! ParseNumber(12, transition.month) || (transition.month < 1) ||
+                ! ParseChar('.') || ! ParseNumber(5, transition.week) || (transition.week < 1) ||
+                ! ParseChar('.') || ! ParseNumber(6, transition.weekday)) {
+                return false;
+            }
+        }
+        else if (ParseChar('J')) {
+            transition.kind = PosixTransition::Kind::Julian;
+            if (! ParseNumber(365, transition.day) || (transition.day < 1)) {
+                return false;
+            }
+        }
+        else {
+            transition.kind = PosixTransition::Kind::ZeroBasedJulian;
+            if (! ParseNumber(365, transition.day)) {
+                return false;
+            }
+        }
+
+        if (ParseChar('/')) {
+            //RFC 8536 extends the time to [-167, 167] hours.
+            return ParseOffset(167, transition.time);
+        }
+        return true;
+    }
+
+private:
+    const char* cursor_;
+    const char* end_;
+};
+
+
+bool ParseTzif(const unsigned char* bytes, std::size_t size, TimeZoneData& data) {
+
+    TzifReader reader(bytes, size);
+
+    TzifHeader header;
+    if (! ReadTzifHeader(reader, header)) {
+        return false;
+    }
+
+    if (header.version == 0) {
+        return ReadTzifData(reader, header, 4, data) && reader.IsEnd();
+    }
+
+    //Version 2 and above duplicate the data with 64-bit times, which
+    //are used instead, and are followed by a footer.
+    if (! reader.Skip(GetTzifDataSize(header, 4)) ||
+        ! ReadTzifHeader(reader, header) ||
+        ! ReadTzifData(reader, header, 8, data)) {
+        return false;
+    }
+
+    const unsigned char* newline = nullptr;
+    if (! reader.ReadBytes(1, newline) || (*newline != '\n')) {
+        return false;
+    }
+
+    auto footer_begin = reinterpret_cast<const char*>(reader.GetCursor());
+    auto footer_end = std::find(footer_begin, reinterpret_cast<const char*>(reader.GetEnd()), '\n');
+    if (footer_end == reinterpret_cast<const char*>(reader.GetEnd())) {
+        return false;
+    }
+
+    if (footer_begin != footer_end) {
+        PosixRuleParser parser(footer_begin, footer_end);
+        if (! parser.Parse(data.rule)) {
+            return false;
+        }
+        data.has_rule = true;
+    }
+
+    return true;
+}
+
+
+std::shared_ptr<const TimeZoneData> MakeUtcData() {
+
+    auto data = std::make_shared<TimeZoneData>();
+    data->types.resize(1);
+    data->types.front().abbreviation = "UTC";
+    return data;
+}
+
+
+std::shared_ptr<const TimeZoneData> LoadTzifFile(const std::string& path) {
+
+    std::ifstream stream(path, std::ios::binary);
+    if (! stream) {
+        return nullptr;
+    }
+
+    std::vector<char> content{ std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+    if (stream.bad()) {
+        return nullptr;
+    }
+
+    auto data = std::make_shared<TimeZoneData>();
+    if (! ParseTzif(reinterpret_cast<const unsigned char*>(content.data()), content.size(), *data)) {
+        return nullptr;
+    }
+    return data;
+}
+
+
+/**
+ Load the local time zone of the process as TZif data, see TimeZone::Local.
+
+ @return
+   nullptr if the time zone can't be loaded.
+ */
+std::shared_ptr<const TimeZoneData> LoadLocalTimeZoneData() {
+
+#ifdef _WIN32
+    return nullptr;
+#else
+    const char* tz = std::getenv("TZ");
+    if (tz == nullptr) {
+        return LoadTzifFile("/etc/localtime");
+    }
+
+    std::string name = tz;
+    if (! name.empty() && (name.front() == ':')) {
+        name.erase(0, 1);
+    }
+
+    //An empty TZ means UTC.
+    if (name.empty()) {
+        return MakeUtcData();
+    }
+
+    if (name.find("..") == std::string::npos) {
+        auto data = LoadTzifFile((name.front() == '/') ? name : (ZoneInfoDirectory + name));
+        if (data != nullptr) {
+            return data;
+        }
+    }
+
+    auto data = std::make_shared<TimeZoneData>();
+    PosixRuleParser parser(name.data(), name.data() + name.length());
+    if (! parser.Parse(data->rule)) {
+        return nullptr;
+    }
+
+    data->has_rule = true;
+    data->types.push_back(data->rule.standard);
+    return data;
+#endif
+}
+
+
+bool GetOffsetAt(const TimeZone& time_zone, std::int64_t seconds, std::int64_t& offset, bool& is_dst) {
+
+    std::time_t time = 0;
+    if (! ToTime(seconds, time)) {
+        return false;
+    }
+
+    std::int32_t offset32 = 0;
+    if (! time_zone.GetOffset(time, offset32, is_dst)) {
+        return false;
+    }
+
+    offset = offset32;
+    return true;
+}
+
+}
+}
+
+
+TimeZone TimeZone::UTC() {
+
+    static const auto data = internal::MakeUtcData();
+
+    return TimeZone(data);
+}
+
+
+TimeZone TimeZone::Load(const std::string& name) {
+
+    if (name.empty() || (name.find("..") != std::string::npos)) {
+        return TimeZone(nullptr);
+    }
+
+    auto path = (name.front() == '/') ? name : (internal::ZoneInfoDirectory + name);
+    return TimeZone(internal::LoadTzifFile(path));
+}
+
+
+TimeZone TimeZone::LoadFromTzif(const void* data, std::size_t size) {
+
+    if (data == nullptr) {
+        return TimeZone(nullptr);
+    }
+
+    auto zone_data = std::make_shared<internal::TimeZoneData>();
+    if (! internal::ParseTzif(static_cast<const unsigned char*>(data), size, *zone_data)) {
+        return TimeZone(nullptr);
+    }
+
+    return TimeZone(zone_data);
+}
+
+
+TimeZone TimeZone::Local() {
+
+    auto data = internal::LoadLocalTimeZoneData();
+    if (data == nullptr) {
+        return TimeZone();
+    }
+
+    return TimeZone(data);
+}
+
+
+TimeZone::TimeZone(std::shared_ptr<const internal::TimeZoneData> data) :
+    data_(std::move(data)),
+    is_valid_(data_ != nullptr) {
+
+}
+
+
+bool TimeZone::ToTm(std::time_t time, std::tm& tm) const {
+
+    if (! is_valid_) {
+        return false;
+    }
+
+    if (data_ == nullptr) {
+        return internal::GetLocalTm(time, tm);
+    }
+
+    const auto& type = internal::FindType(*data_, time);
+    if (! internal::CivilFromSeconds(static_cast<std::int64_t>(time) + type.offset, tm)) {
+        return false;
+    }
+
+    tm.tm_isdst = type.is_dst ? 1 : 0;
+#ifdef TIEX_TM_HAS_ZONE_FIELDS
+    tm.tm_gmtoff = type.offset;
+    tm.tm_zone = type.abbreviation.c_str();
+#endif
+    return true;
+}
+
+
+bool TimeZone::GetOffset(std::time_t time, std::int32_t& offset, bool& is_dst) const {
+
+    if (! is_valid_) {
+        return false;
+    }
+
+    if (data_ == nullptr) {
+
+        std::tm tm = { 0 };
+        if (! internal::GetLocalTm(time, tm)) {
+            return false;
+        }
+
+        offset = static_cast<std::int32_t>(internal::CivilToSeconds(tm) - time);
+        is_dst = tm.tm_isdst > 0;
+        return true;
+    }
+
+    const auto& type = internal::FindType(*data_, time);
+    offset = type.offset;
+    is_dst = type.is_dst;
+    return true;
+}
+
+
+bool TimeZone::GetAbbreviation(std::time_t time, std::string& abbreviation) const {
+
+    if (! is_valid_) {
+        return false;
+    }
+
+    if (data_ == nullptr) {
+
+        std::tm tm = { 0 };
+        if (! internal::GetLocalTm(time, tm)) {
+            return false;
+        }
+
+        char buffer[64] = { 0 };
+        auto length = std::strftime(buffer, sizeof(buffer), "%Z", &tm);
+        abbreviation.assign(buffer, length);
+        return true;
+    }
+
+    abbreviation = internal::FindType(*data_, time).abbreviation;
+    return true;
+}
+
+
+bool TimeZone::MakeTime(const std::tm& tm, std::time_t& time) const {
+
+    std::int64_t local_seconds = internal::CivilToSeconds(tm);
+
+    //The offset at the local seconds, as if they were epoch seconds, is a
+    //good guess, which is exact unless a transition is nearby.
+    std::int64_t guessed_offset = 0;
+    bool is_dst = false;
+    if (! internal::GetOffsetAt(*this, local_seconds, guessed_offset, is_dst)) {
+        return false;
+    }
+
+    std::int64_t first_seconds = local_seconds - guessed_offset;
+    std::int64_t first_offset = 0;
+    if (! internal::GetOffsetAt(*this, first_seconds, first_offset, is_dst)) {
+        return false;
+    }
+
+    std::int64_t seconds = first_seconds;
+
+    if (first_offset != guessed_offset) {
+
+        std::int64_t second_seconds = local_seconds - first_offset;
+        std::int64_t second_offset = 0;
+        if (! internal::GetOffsetAt(*this, second_seconds, second_offset, is_dst)) {
+            return false;
+        }
+
+        if (second_offset != first_offset) {
+            //The local time is skipped, the offset before the transition
+            //is used, which leads to the later time.
+            return internal::ToTime(std::max(first_seconds, second_seconds), time);
+        }
+
+        seconds = second_seconds;
+    }
+
+    //The local time may be repeated by a transition, prefer the one that
+    //has the same DST flag as tm.
+    if ((tm.tm_isdst >= 0) && ((tm.tm_isdst > 0) != is_dst)) {
+
+        std::int64_t offset = local_seconds - seconds;
+        for (auto probe_distance : { -internal::SecondsPerDay / 2, internal::SecondsPerDay / 2 }) {
+
+            std::int64_t probe_offset = 0;
+            bool probe_is_dst = false;
+            if (! internal::GetOffsetAt(*this, seconds + probe_distance, probe_offset, probe_is_dst)) {
+                continue;
+            }
+
+            if ((probe_offset == offset) || ((tm.tm_isdst > 0) != probe_is_dst)) {
+                continue;
+            }
+
+            std::int64_t alternative_seconds = local_seconds - probe_offset;
+            std::int64_t alternative_offset = 0;
+            if (internal::GetOffsetAt(*this, alternative_seconds, alternative_offset, probe_is_dst) &&
+                (alternative_offset == probe_offset)) {
+                seconds = alternative_seconds;
+                break;
+            }
+        }
+    }
+
+    return internal::ToTime(seconds, time);
+}
+
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+
+namespace tiex {
+namespace internal {
+class TimeZoneData;
+}
+
+/**
+ A time zone determinates how times are converted to local times, which
+ affects matching rules and generating results.
+
+ A default constructed time zone represents the local time zone of the
+ process, whose information is read from the C library, so it follows
+ changes of the TZ environment variable. TimeZone::Local() loads the same
+ time zone as TZif data instead, which is faster to convert. Other time zones
+ are loaded from TZif files, such as those in /usr/share/zoneinfo, and are
+ independent from the TZ environment variable, so formatting times for
+ different time zones in one process doesn't need to change the global
+ state.
+
+ Time zones are immutable, copying one is cheap, and a time zone can be
+ used by multiple threads simultaneously.
+ */
+class TimeZone {
+public:
+	/**
+	 Get the UTC time zone.
+	 */
+	static TimeZone UTC();
+
+	/**
+	 Load a time zone by its name.
+
+	 @param name
+	   A name in the time zone database, such as "Asia/Shanghai", which is
+	   loaded from /usr/share/zoneinfo. An absolute path to a TZif file is
+	   accepted as well.
+
+	 @return
+	   An invalid time zone if fail to load.
+	 */
+	static TimeZone Load(const std::string& name);
+
+	/**
+	 Load a time zone from TZif data in memory.
+
+	 @param data
+	   The TZif data, it is not referred after the function returns.
+
+	 @param size
+	   Length of the data in bytes.
+
+	 @return
+	   An invalid time zone if fail to parse the data.
+	 */
+	static TimeZone LoadFromTzif(const void* data, std::size_t size);
+
+	/**
+	 Load the local time zone of the process as TZif data, in the way the C
+	 library finds it, that is by the TZ environment variable, which is
+	 either a name in the time zone database, a path or a POSIX TZ string,
+	 or else by /etc/localtime.
+
+	 The returned time zone is converted without the C library, it doesn't
+	 follow later changes of the TZ environment variable; call this function
+	 again to reload.
+
+	 @return
+	   The time zone that reads from the C library, as a default constructed
+	   one, if fail to load.
+	 */
+	static TimeZone Local();
+
+public:
+	/**
+	 Construct the local time zone of the process.
+	 */
+	TimeZone() = default;
+
+	/**
+	 Determinate whether the time zone is valid.
+
+	 Converting times with an invalid time zone always fails.
+	 */
+	bool IsValid() const {
+		return is_valid_;
+	}
+
+	/**
+	 Determinate whether the time zone is the local time zone of the process
+	 that is read from the C library.
+	 */
+	bool IsLocal() const {
+		return is_valid_ && (data_ == nullptr);
+	}
+
+	/**
+	 Convert a time to local time in this time zone.
+	 */
+	bool ToTm(std::time_t time, std::tm& tm) const;
+
+	/**
+	 Convert a local time in this time zone to time.
+
+	 Fields of tm are not required to be in their normal ranges, as what
+	 std::mktime accepts. If the local time is skipped by a transition, it is
+	 shifted forward by the length of the skipped period; if it is repeated,
+	 the one whose DST flag equals to tm_isdst is preferred.
+	 */
+	bool MakeTime(const std::tm& tm, std::time_t& time) const;
+
+	/**
+	 Get the offset from UTC in seconds of a time, and whether it is in DST.
+	 */
+	bool GetOffset(std::time_t time, std::int32_t& offset, bool& is_dst) const;
+
+	/**
+	 Get the abbreviation of the time zone at a time, such as "CST".
+	 */
+	bool GetAbbreviation(std::time_t time, std::string& abbreviation) const;
+
+private:
+	explicit TimeZone(std::shared_ptr<const internal::TimeZoneData> data);
+
+private:
+	std::shared_ptr<const internal::TimeZoneData> data_;
+	bool is_valid_ = true;
+};
+
+}
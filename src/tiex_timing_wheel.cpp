@@ -0,0 +1,212 @@
+#include "tiex_timing_wheel.h"
+
+namespace tiex {
+namespace internal {
+namespace {
+
+/**
+ Times are mapped to slots by their bits, unsigned values are used so that
+ negative times are mapped in the same way.
+ */
+inline std::uint64_t ToTick(std::time_t time) {
+    return static_cast<std::uint64_t>(static_cast<std::int64_t>(time));
+}
+
+}
+
+
+constexpr int TimingWheel::LevelBits;
+constexpr std::size_t TimingWheel::SlotCount;
+constexpr int TimingWheel::LevelCount;
+
+
+TimingWheel::TimingWheel(std::time_t current_time) : current_time_(current_time) {
+
+}
+
+
+void TimingWheel::Schedule(Id id, std::time_t expire_time) {
+
+    if (expire_time <= current_time_) {
+        expire_time = current_time_ + 1;
+    }
+
+    auto& timer = timers_[id];
+    if (timer.generation != 0) {
+        --live_counts_[timer.level];
+    }
+
+    timer.expire_time = expire_time;
+    timer.generation = ++next_generation_;
+
+    Item item;
+    item.id = id;
+    item.generation = timer.generation;
+    Place(item, timer);
+}
+
+
+void TimingWheel::Cancel(Id id) {
+
+    auto iterator = timers_.find(id);
+    if (iterator == timers_.end()) {
+        return;
+    }
+
+    //Items in slots become stale, and are dropped when their slots are
+    //reached.
+    --live_counts_[iterator->second.level];
+    timers_.erase(iterator);
+}
+
+
+void TimingWheel::Advance(std::time_t current_time, std::vector<Id>& expired_ids) {
+
+    while (current_time_ < current_time) {
+
+        //Skip to the tick before the next cascade, if no timer is in the
+        //levels below it.
+        int empty_level_count = 0;
+        while ((empty_level_count < LevelCount) && (live_counts_[empty_level_count] == 0)) {
+            ++empty_level_count;
+        }
+
+        if (empty_level_count == LevelCount) {
+
+            if (live_counts_[LevelCount] == 0) {
+                current_time_ = current_time;
+                break;
+            }
+
+            //Overflowed timers are re-placed when the top level cascades.
+            empty_level_count = LevelCount - 1;
+        }
+
+        if (empty_level_count > 0) {
+
+            int shift = LevelBits * empty_level_count;
+            auto boundary_tick = ((ToTick(current_time_) >> shift) + 1) << shift;
+            auto skipped_time = static_cast<std::time_t>(static_cast<std::int64_t>(boundary_tick - 1));
+
+            if (skipped_time > current_time_) {
+                current_time_ = (skipped_time < current_time) ? skipped_time : current_time;
+                continue;
+            }
+        }
+
+        Tick(expired_ids);
+    }
+}
+
+
+void TimingWheel::Place(const Item& item, Timer& timer) {
+
+    auto delta = ToTick(timer.expire_time) - ToTick(current_time_);
+
+    int level = 0;
+    while ((level < LevelCount) && (delta >= (std::uint64_t(1) << (LevelBits * (level + 1))))) {
+        ++level;
+    }
+
+    timer.level = level;
+    ++live_counts_[level];
+
+    if (level == LevelCount) {
+        overflow_items_.push_back(item);
+        return;
+    }
+
+    auto slot_index = (ToTick(timer.expire_time) >> (LevelBits * level)) & (SlotCount - 1);
+    slots_[level][slot_index].push_back(item);
+}
+
+
+void TimingWheel::Tick(std::vector<Id>& expired_ids) {
+
+    ++current_time_;
+
+    //Timers in higher levels are moved down before expiring the current
+    //slot, since some of them may expire at the current time.
+    auto current_tick = ToTick(current_time_);
+    int cascade_level = 1;
+    while ((cascade_level < LevelCount) &&
+           (((current_tick >> (LevelBits * (cascade_level - 1))) & (SlotCount - 1)) == 0)) {
+        ++cascade_level;
+    }
+
+    for (int level = cascade_level - 1; level >= 1; --level) {
+        Cascade(level);
+    }
+
+    auto& slot = slots_[0][current_tick & (SlotCount - 1)];
+    if (! slot.empty()) {
+        std::vector<Item> items;
+        items.swap(slot);
+        Expire(items, expired_ids);
+    }
+}
+
+
+void TimingWheel::Cascade(int level) {
+
+    std::vector<Item> items;
+
+    if (level == LevelCount - 1) {
+        //Overflowed timers are re-placed each time the top level turns.
+        items.swap(overflow_items_);
+        for (const auto& each_item : items) {
+            Timer* timer = nullptr;
+            if (IsLive(each_item, timer)) {
+                --live_counts_[timer->level];
+                Place(each_item, *timer);
+            }
+        }
+        items.clear();
+    }
+
+    auto slot_index = (ToTick(current_time_) >> (LevelBits * level)) & (SlotCount - 1);
+    items.swap(slots_[level][slot_index]);
+
+    for (const auto& each_item : items) {
+        Timer* timer = nullptr;
+        if (IsLive(each_item, timer)) {
+            --live_counts_[timer->level];
+            Place(each_item, *timer);
+        }
+    }
+}
+
+
+void TimingWheel::Expire(std::vector<Item>& items, std::vector<Id>& expired_ids) {
+
+    for (const auto& each_item : items) {
+
+        Timer* timer = nullptr;
+        if (! IsLive(each_item, timer)) {
+            continue;
+        }
+
+        --live_counts_[timer->level];
+        timers_.erase(each_item.id);
+        expired_ids.push_back(each_item.id);
+    }
+}
+
+
+bool TimingWheel::IsLive(const Item& item, Timer*& timer) {
+
+    auto iterator = timers_.find(item.id);
+    if (iterator == timers_.end()) {
+        return false;
+    }
+
+    if (iterator->second.generation != item.generation) {
+        return false;
+    }
+
+    timer = &iterator->second;
+    return true;
+}
+
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <unordered_map>
+#include <vector>
+
+namespace tiex {
+namespace internal {
+
+/**
+ A hierarchical timing wheel, which schedules ids to expire at times with
+ the precision of seconds.
+
+ Each level has 64 slots, a slot of level 0 spans one second, and a slot of
+ a higher level spans all slots of the level below. A timer is placed in
+ the lowest level whose range covers it, and moves down a level each time
+ its slot is reached, so scheduling and cancelling take O(1), and
+ advancing takes O(expired timers) plus the count of non-empty slots that
+ are passed.
+ */
+class TimingWheel {
+public:
+	using Id = std::uint64_t;
+
+public:
+	explicit TimingWheel(std::time_t current_time);
+
+	TimingWheel(const TimingWheel&) = delete;
+	TimingWheel& operator=(const TimingWheel&) = delete;
+
+	std::time_t GetCurrentTime() const {
+		return current_time_;
+	}
+
+	/**
+	 Schedule an id to expire at a time, which replaces the previous
+	 schedule of the id.
+
+	 A time that is not later than the current time expires at the next
+	 second.
+	 */
+	void Schedule(Id id, std::time_t expire_time);
+
+	/**
+	 Cancel the schedule of an id.
+	 */
+	void Cancel(Id id);
+
+	/**
+	 Advance the current time, and append ids that expire in the period to
+	 expired_ids, in the order of their expire times. The current time never
+	 goes back.
+	 */
+	void Advance(std::time_t current_time, std::vector<Id>& expired_ids);
+
+private:
+	static constexpr int LevelBits = 6;
+	static constexpr std::size_t SlotCount = std::size_t(1) << LevelBits;
+	static constexpr int LevelCount = 6;
+
+	/**
+	 An item in a slot. It is stale if its generation differs from the one
+	 of the timer, which means the timer has been rescheduled or cancelled.
+	 */
+	class Item {
+	public:
+		Id id;
+		std::uint64_t generation;
+	};
+
+	class Timer {
+	public:
+		std::time_t expire_time = 0;
+		std::uint64_t generation = 0;
+
+		/**
+		 The level the timer is placed in, LevelCount means the overflow list.
+		 */
+		int level = 0;
+	};
+
+private:
+	void Place(const Item& item, Timer& timer);
+	void Tick(std::vector<Id>& expired_ids);
+	void Cascade(int level);
+	void Expire(std::vector<Item>& items, std::vector<Id>& expired_ids);
+	bool IsLive(const Item& item, Timer*& timer);
+
+private:
+	std::time_t current_time_;
+	std::unordered_map<Id, Timer> timers_;
+	std::vector<Item> slots_[LevelCount][SlotCount];
+	std::vector<Item> overflow_items_;
+	std::size_t live_counts_[LevelCount + 1] = { 0 };
+	std::uint64_t next_generation_ = 0;
+};
+
+}
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace tiex {
+namespace internal {
+
+/**
+ A writer is the destination of generated result text.
+
+ Formatting writes text through this interface, so that results can be
+ written to caller storage directly without temporary strings.
+ */
+template<typename C>
+class Writer {
+public:
+	Writer() = default;
+	virtual ~Writer() = default;
+
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+
+	virtual void Write(const C* chars, std::size_t length) = 0;
+
+	/**
+	 Write characters that outlive the writer, such as literals of the
+	 expression, so that a writer can refer to them instead of copying.
+	 */
+	virtual void WritePersistent(const C* chars, std::size_t length) {
+		Write(chars, length);
+	}
+
+	void Write(C ch) {
+		Write(&ch, 1);
+	}
+
+	void Write(const std::basic_string<C>& string) {
+		Write(string.data(), string.length());
+	}
+};
+
+
+template<typename C>
+class StringWriter : public Writer<C> {
+public:
+	using Writer<C>::Write;
+
+public:
+	explicit StringWriter(std::basic_string<C>& string) : string_(string) {
+
+	}
+
+	void Write(const C* chars, std::size_t length) override {
+		string_.append(chars, length);
+	}
+
+private:
+	std::basic_string<C>& string_;
+};
+
+
+/**
+ Refers to the written characters as a view, if they are persistent and
+ written at once. Otherwise, the characters are copied to a string, and the
+ view refers to the string.
+ */
+template<typename C>
+class ViewWriter : public Writer<C> {
+public:
+	using Writer<C>::Write;
+
+public:
+	explicit ViewWriter(std::basic_string<C>& string) : string_(string) {
+
+	}
+
+	void Write(const C* chars, std::size_t length) override {
+		Materialize();
+		string_.append(chars, length);
+	}
+
+	void WritePersistent(const C* chars, std::size_t length) override {
+
+		if (! is_materialized_ && view_.empty()) {
+			view_ = std::basic_string_view<C>(chars, length);
+			return;
+		}
+
+		Write(chars, length);
+	}
+
+	std::basic_string_view<C> GetView() const {
+		if (is_materialized_) {
+			return std::basic_string_view<C>(string_.data(), string_.length());
+		}
+		return view_;
+	}
+
+private:
+	void Materialize() {
+
+		if (is_materialized_) {
+			return;
+		}
+
+		string_.assign(view_.data(), view_.length());
+		is_materialized_ = true;
+	}
+
+private:
+	std::basic_string<C>& string_;
+	std::basic_string_view<C> view_;
+	bool is_materialized_ = false;
+};
+
+
+/**
+ Writes to a buffer with fixed capacity, the overflowed part is discarded
+ but still counted.
+ */
+template<typename C>
+class BufferWriter : public Writer<C> {
+public:
+	using Writer<C>::Write;
+
+public:
+	BufferWriter(C* buffer, std::size_t capacity) : buffer_(buffer), capacity_(capacity) {
+
+	}
+
+	void Write(const C* chars, std::size_t length) override {
+
+		if (size_ < capacity_) {
+			std::size_t copy_length = (capacity_ - size_ < length) ? (capacity_ - size_) : length;
+			std::char_traits<C>::copy(buffer_ + size_, chars, copy_length);
+		}
+		size_ += length;
+	}
+
+	std::size_t GetSize() const {
+		return size_;
+	}
+
+private:
+	C* buffer_;
+	std::size_t capacity_;
+	std::size_t size_ = 0;
+};
+
+
+template<typename C, typename OutputIt>
+class OutputIteratorWriter : public Writer<C> {
+public:
+	using Writer<C>::Write;
+
+public:
+	explicit OutputIteratorWriter(OutputIt output) : output_(output) {
+
+	}
+
+	void Write(const C* chars, std::size_t length) override {
+		for (std::size_t index = 0; index < length; ++index) {
+			*output_ = chars[index];
+			++output_;
+		}
+	}
+
+	OutputIt GetOutput() const {
+		return output_;
+	}
+
+private:
+	OutputIt output_;
+};
+
+
+/**
+ Write the decimal text of a non-negative number.
+
+ @param width
+   The minimum count of characters, the text is padded at front with
+   the padding character if it is shorter.
+ */
+template<typename C>
+void WriteNumber(unsigned long long number, std::size_t width, C padding, Writer<C>& writer) {
+
+	C buffer[24];
+	C* end = buffer + sizeof(buffer) / sizeof(C);
+	C* begin = end;
+
+	do {
+		--begin;
+		*begin = static_cast<C>('0' + number % 10);
+		number /= 10;
+	}
+	while (number != 0);
+
+	while ((static_cast<std::size_t>(end - begin) < width) && (begin != buffer)) {
+		--begin;
+		*begin = padding;
+	}
+
+	writer.Write(begin, end - begin);
+}
+
+
+template<typename C>
+void WriteNumber(unsigned long long number, Writer<C>& writer) {
+	WriteNumber<C>(number, 0, '0', writer);
+}
+
+
+/**
+ Write ASCII characters, which are widened if C is not char.
+ */
+template<typename C>
+void WriteAscii(const char* chars, std::size_t length, Writer<C>& writer) {
+
+	C buffer[32];
+	while (length != 0) {
+
+		std::size_t count = (length < 32) ? length : 32;
+		for (std::size_t index = 0; index < count; ++index) {
+			buffer[index] = static_cast<C>(chars[index]);
+		}
+
+		writer.Write(buffer, count);
+		chars += count;
+		length -= count;
+	}
+}
+
+template<>
+inline void WriteAscii<char>(const char* chars, std::size_t length, Writer<char>& writer) {
+	writer.Write(chars, length);
+}
+
+}
+}
@@ -1,4 +1,6 @@
 ﻿#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 #include "test_utility.h"
 #include "tiex.h"
 
@@ -26,4 +28,559 @@ TEST(Case, Example) {
     ASSERT_EQ(formatter.Format(referenced_time, MakeTime(2018, 2, 2, 0, 0, 0)), "Friday");
     ASSERT_EQ(formatter.Format(referenced_time, MakeTime(2018, 1, 21, 0, 0, 0)), "01-21");
     ASSERT_EQ(formatter.Format(referenced_time, MakeTime(2017, 6, 27, 0, 0, 0)), "2017-06-27");
-}
\ No newline at end of file
+}
+
+TEST(Case, Bind) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[0,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+        "[-2.d,0]{Yesterday}"
+        "[-1.y,0]{%m-%d}"
+    );
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    auto bound_formatter = formatter.Bind(referenced_time);
+    ASSERT_EQ(bound_formatter.GetReferencedTime(), referenced_time);
+
+    auto test = [&](std::time_t formatted_time) {
+        tiex::FormatError expected_error;
+        auto expected = formatter.Format(referenced_time, formatted_time, expected_error);
+        tiex::FormatError actual_error;
+        auto actual = bound_formatter.Format(formatted_time, actual_error);
+        return (actual == expected) && (actual_error.status == expected_error.status);
+    };
+
+    ASSERT_TRUE(test(MakeTime(2018, 2, 7, 0, 0, 0)));
+    ASSERT_TRUE(test(MakeTime(2018, 2, 6, 13, 43, 32)));
+    ASSERT_TRUE(test(MakeTime(2018, 2, 6, 13, 43, 23)));
+    ASSERT_TRUE(test(MakeTime(2018, 2, 6, 12, 53, 0)));
+    ASSERT_TRUE(test(MakeTime(2018, 2, 6, 1, 2, 3)));
+    ASSERT_TRUE(test(MakeTime(2018, 2, 5, 22, 10, 2)));
+    ASSERT_TRUE(test(MakeTime(2018, 1, 21, 0, 0, 0)));
+    ASSERT_TRUE(test(MakeTime(2016, 6, 27, 0, 0, 0)));
+
+    tiex::FormatError error;
+    bound_formatter.Format(MakeTime(2016, 6, 27, 0, 0, 0), error);
+    ASSERT_EQ(error.status, tiex::FormatError::Status::NoMatchedRule);
+}
+
+
+TEST(Case, FormatTo) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+    );
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    auto bound_formatter = formatter.Bind(referenced_time);
+
+    auto test = [&](std::time_t formatted_time, const std::string& expected) {
+
+        std::string output;
+        formatter.FormatTo(std::back_inserter(output), referenced_time, formatted_time);
+        if (output != expected) {
+            return false;
+        }
+
+        output.clear();
+        bound_formatter.FormatTo(std::back_inserter(output), formatted_time);
+        if (output != expected) {
+            return false;
+        }
+
+        if (formatter.FormattedSize(referenced_time, formatted_time) != expected.length()) {
+            return false;
+        }
+
+        char buffer[32] = { 0 };
+        auto size = formatter.FormatTo(buffer, sizeof(buffer), referenced_time, formatted_time);
+        if (std::string(buffer, size) != expected) {
+            return false;
+        }
+
+        //Truncated.
+        char small_buffer[4] = { 0 };
+        size = bound_formatter.FormatTo(small_buffer, sizeof(small_buffer), formatted_time);
+        return (size == expected.length()) && (std::string(small_buffer, 4) == expected.substr(0, 4));
+    };
+
+    ASSERT_TRUE(test(MakeTime(2018, 2, 6, 13, 43, 23), "Just now"));
+    ASSERT_TRUE(test(MakeTime(2018, 2, 6, 12, 53, 0), "50 minute(s) ago"));
+    ASSERT_TRUE(test(MakeTime(2018, 2, 6, 1, 2, 3), "01:02"));
+
+    tiex::FormatError error;
+    char buffer[32] = { 0 };
+    auto size = formatter.FormatTo(
+        buffer, 
+        sizeof(buffer), 
+        referenced_time, 
+        MakeTime(2018, 2, 1, 0, 0, 0), 
+        tiex::TimeZone(), 
+        tiex::Locale(), 
+        error);
+    ASSERT_EQ(size, 0u);
+    ASSERT_EQ(error.status, tiex::FormatError::Status::NoMatchedRule);
+}
+
+
+TEST(Case, FormatBatch) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+    );
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+
+    std::vector<std::time_t> formatted_times = {
+        MakeTime(2018, 2, 6, 13, 43, 23),
+        MakeTime(2018, 2, 1, 0, 0, 0),
+        MakeTime(2018, 2, 6, 12, 53, 0),
+        MakeTime(2018, 2, 6, 1, 2, 3),
+    };
+
+    tiex::BatchResult batch_result;
+    formatter.FormatBatch(referenced_time, formatted_times.data(), formatted_times.size(), batch_result);
+
+    ASSERT_EQ(batch_result.GetCount(), 4u);
+    ASSERT_EQ(batch_result.texts, "Just now50 minute(s) ago01:02");
+    ASSERT_EQ(batch_result.GetText(0), "Just now");
+    ASSERT_EQ(batch_result.entries[1].length, 0u);
+    ASSERT_EQ(batch_result.entries[1].status, tiex::FormatError::Status::NoMatchedRule);
+    ASSERT_EQ(batch_result.GetText(2), "50 minute(s) ago");
+    ASSERT_EQ(batch_result.GetText(3), "01:02");
+
+    for (std::size_t index = 0; index < formatted_times.size(); ++index) {
+        tiex::FormatError error;
+        auto expected = formatter.Format(referenced_time, formatted_times[index], error);
+        ASSERT_EQ(batch_result.GetText(index), expected);
+        ASSERT_EQ(batch_result.entries[index].status, error.status);
+    }
+
+    //Results are cleared when reused.
+    formatter.FormatBatch(referenced_time, formatted_times.data(), 1, batch_result);
+    ASSERT_EQ(batch_result.GetCount(), 1u);
+    ASSERT_EQ(batch_result.texts, "Just now");
+}
+
+
+TEST(Case, FormatBatch_Parallel) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[0,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+        "[-2.d,0]{Yesterday %H:%M}"
+        "[-1.y,0]{%m-%d}"
+    );
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+
+    std::vector<std::time_t> formatted_times;
+    for (std::time_t time = referenced_time - 3 * 365 * 24 * 3600; time < referenced_time + 3600; time += 3571) {
+        formatted_times.push_back(time);
+    }
+
+    tiex::BatchResult expected_result;
+    formatter.FormatBatch(referenced_time, formatted_times.data(), formatted_times.size(), expected_result);
+
+    tiex::ThreadPool thread_pool(4);
+    ASSERT_EQ(thread_pool.GetThreadCount(), 4u);
+
+    tiex::BatchResult batch_result;
+    formatter.FormatBatch(
+        referenced_time,
+        formatted_times.data(),
+        formatted_times.size(),
+        tiex::TimeZone(),
+        tiex::Locale(),
+        thread_pool,
+        batch_result);
+
+    ASSERT_EQ(batch_result.texts, expected_result.texts);
+    ASSERT_EQ(batch_result.GetCount(), expected_result.GetCount());
+    for (std::size_t index = 0; index < batch_result.GetCount(); ++index) {
+        ASSERT_EQ(batch_result.entries[index].offset, expected_result.entries[index].offset);
+        ASSERT_EQ(batch_result.entries[index].length, expected_result.entries[index].length);
+        ASSERT_EQ(batch_result.entries[index].status, expected_result.entries[index].status);
+    }
+}
+
+
+TEST(Case, FormatBatch_Locale) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[-1.d,0]{%p %I:%M:%S}"
+        "[-1.y,0]{%a %b %d %H}"
+        "[*,0]{%A %B %m}"
+    );
+
+    int call_count = 0;
+    tiex::Locale locale;
+    locale.get_am_pm = [&call_count](bool is_pm) {
+        ++call_count;
+        return std::string(is_pm ? "PM" : "AM");
+    };
+    locale.get_weekday = [&call_count](int weekday, const tiex::Locale::WeekdayOptions& options) {
+        ++call_count;
+        return std::string(options.is_abbreviated ? "wd" : "weekday") + std::to_string(weekday);
+    };
+    locale.get_month = [&call_count](int month, const tiex::Locale::MonthOptions& options) {
+        ++call_count;
+        return std::string(options.is_number ? "#" : (options.is_abbreviated ? "mon" : "month")) + std::to_string(month);
+    };
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+
+    std::vector<std::time_t> formatted_times;
+    for (std::time_t time = referenced_time - 3 * 365 * 24 * 3600; time <= referenced_time; time += 7919) {
+        formatted_times.push_back(time);
+    }
+    ASSERT_GE(formatted_times.size(), 1000u);
+
+    tiex::BatchResult batch_result;
+    formatter.FormatBatch(
+        referenced_time,
+        formatted_times.data(),
+        formatted_times.size(),
+        tiex::TimeZone(),
+        locale,
+        batch_result);
+
+    //Each callback is called once per value for the whole batch.
+    ASSERT_EQ(call_count, 2 + 7 * 2 + 12 * 3);
+
+    ASSERT_EQ(batch_result.GetCount(), formatted_times.size());
+    for (std::size_t index = 0; index < formatted_times.size(); ++index) {
+        auto expected = formatter.Format(referenced_time, formatted_times[index], locale);
+        ASSERT_EQ(batch_result.GetText(index), expected);
+    }
+}
+
+
+TEST(Case, SharedFormatter) {
+
+    std::vector<std::time_t> formatted_times;
+    std::vector<std::string> expected_results;
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+
+    tiex::BoundFormatter bound_formatter = [&]() {
+
+        const auto formatter = tiex::Formatter::Create(
+            "[-1~min,0]{Just now}"
+            "[-1~h,0]{%~min minute(s) ago}"
+            "[-1.d,0]{%H:%M}"
+            "[*,0]{%Y-%m-%d}"
+        );
+
+        for (std::time_t time = referenced_time - 30 * 24 * 3600; time <= referenced_time; time += 600) {
+            formatted_times.push_back(time);
+            expected_results.push_back(formatter.Format(referenced_time, time));
+        }
+
+        std::vector<std::thread> threads;
+        std::vector<int> results(4);
+        for (std::size_t index = 0; index < results.size(); ++index) {
+            threads.emplace_back([&, index]() {
+                bool is_same = true;
+                for (std::size_t time_index = 0; time_index < formatted_times.size(); ++time_index) {
+                    auto text = formatter.Format(referenced_time, formatted_times[time_index]);
+                    is_same = is_same && (text == expected_results[time_index]);
+                }
+                results[index] = is_same ? 1 : 0;
+            });
+        }
+
+        for (auto& each_thread : threads) {
+            each_thread.join();
+        }
+
+        for (auto each_result : results) {
+            EXPECT_TRUE(each_result);
+        }
+
+        //The bound formatter shares the expression, and outlives the formatter.
+        return formatter.Bind(referenced_time);
+    }();
+
+    for (std::size_t index = 0; index < formatted_times.size(); ++index) {
+        ASSERT_EQ(bound_formatter.Format(formatted_times[index]), expected_results[index]);
+    }
+
+    tiex::Formatter empty_formatter;
+    tiex::FormatError error;
+    ASSERT_EQ(empty_formatter.Format(referenced_time, referenced_time, error), "");
+    ASSERT_EQ(error.status, tiex::FormatError::Status::NoMatchedRule);
+}
+
+
+TEST(Case, NextChangeTime) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[0,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%~h hour(s) ago}"
+        "[-2.d,0]{Yesterday}"
+        "[*,0]{%Y-%m-%d}"
+    );
+
+    auto formatted_time = MakeTime(2018, 2, 6, 22, 43, 32);
+
+    //The next change time is exactly the first time the result changes.
+    auto referenced_time = formatted_time - 10;
+    auto end_time = formatted_time + 3 * 3600;
+    while (referenced_time < end_time) {
+
+        auto result = formatter.Format(referenced_time, formatted_time);
+        auto next_change_time = formatter.NextChangeTime(referenced_time, formatted_time);
+        ASSERT_GT(next_change_time, referenced_time);
+
+        auto actual_change_time = referenced_time + 1;
+        while (formatter.Format(actual_change_time, formatted_time) == result) {
+            ++actual_change_time;
+        }
+
+        ASSERT_EQ(next_change_time, actual_change_time) << referenced_time;
+        referenced_time = next_change_time;
+    }
+
+    //Changes at boundaries of days.
+    ASSERT_EQ(formatter.Format(MakeTime(2018, 2, 6, 23, 50, 0), formatted_time), "1 hour(s) ago");
+    ASSERT_EQ(
+        formatter.NextChangeTime(MakeTime(2018, 2, 6, 23, 50, 0), formatted_time),
+        MakeTime(2018, 2, 7, 0, 0, 0));
+    ASSERT_EQ(
+        formatter.NextChangeTime(MakeTime(2018, 2, 7, 12, 0, 0), formatted_time),
+        MakeTime(2018, 2, 8, 0, 0, 0));
+    ASSERT_EQ(
+        formatter.NextChangeTime(MakeTime(2018, 2, 8, 12, 0, 0), formatted_time),
+        std::numeric_limits<std::time_t>::max());
+
+    auto bound_formatter = formatter.Bind(MakeTime(2018, 2, 6, 23, 50, 0));
+    ASSERT_EQ(bound_formatter.NextChangeTime(formatted_time), MakeTime(2018, 2, 7, 0, 0, 0));
+}
+
+
+TEST(Case, NextChangeTime_Units) {
+
+    const char* expressions[] = {
+        "[0,*]{Future}"
+        "[-1~w,0]{%~d day(s) ago}"
+        "[-1.w,0]{This week}"
+        "[-3.mth,0]{%~w week(s) ago}"
+        "[-1.y,0]{%~mth month(s) ago}"
+        "[-5~y,0]{%~y year(s) ago}"
+        "[*,0]{Long ago}",
+
+        "[*,-2.d]{Before}"
+        "[-1~d,1~h]{Near %~h}"
+        "[-1.mth,2.mth]{Around}"
+        "[*,*]{After}",
+
+        "[0,*]{Future}"
+        "[-1~mth,0]{Within month}"
+        "[-1~y,-2~mth]{Within year}"
+        "[*,0]{Older}",
+    };
+
+    for (auto each_expression : expressions) {
+
+        auto formatter = tiex::Formatter::Create(each_expression);
+
+        for (auto formatted_time : {
+            MakeTime(2018, 2, 6, 22, 43, 32),
+            MakeTime(2016, 1, 31, 0, 0, 0),
+            MakeTime(2017, 12, 31, 23, 59, 59),
+            MakeTime(2018, 3, 1, 12, 0, 0),
+            MakeTime(2016, 2, 29, 12, 0, 0) }) {
+
+            //At each next change time, the result has changed, and it stays
+            //the same from the referenced time until then, which is checked
+            //every hour.
+            auto referenced_time = formatted_time - 400 * 86400;
+            auto end_time = formatted_time + 7 * 366 * 86400;
+            while (referenced_time < end_time) {
+
+                auto result = formatter.Format(referenced_time, formatted_time);
+                auto next_change_time = formatter.NextChangeTime(referenced_time, formatted_time);
+                ASSERT_GT(next_change_time, referenced_time);
+                if (next_change_time == std::numeric_limits<std::time_t>::max()) {
+                    break;
+                }
+
+                for (auto time = referenced_time + 1; time < next_change_time; time += 3600) {
+                    ASSERT_EQ(formatter.Format(time, formatted_time), result) << each_expression << " " << referenced_time << " " << time;
+                }
+                ASSERT_EQ(formatter.Format(next_change_time - 1, formatted_time), result) << each_expression << " " << referenced_time;
+                ASSERT_NE(formatter.Format(next_change_time, formatted_time), result) << each_expression << " " << referenced_time;
+                referenced_time = next_change_time;
+            }
+        }
+    }
+}
+
+
+TEST(Case, NextChangeTime_MonthEnd) {
+
+    //Mar 30 - 1 month is normalized to Mar 2, while Apr 1 - 1 month is
+    //Mar 1, so the backward boundary moves back at the start of April.
+    auto formatter = tiex::Formatter::Create("[-1~mth,0]{Within month}[*,*]{Older}");
+    auto time_zone = tiex::TimeZone::UTC();
+
+    std::time_t referenced_time = 1522411200;   //2018-03-30 12:00:00 UTC
+    std::time_t formatted_time = 1519905600;    //2018-03-01 12:00:00 UTC
+    std::time_t april_time = 1522540800;        //2018-04-01 00:00:00 UTC
+
+    ASSERT_EQ(formatter.Format(referenced_time, formatted_time, time_zone), "Older");
+    ASSERT_EQ(formatter.NextChangeTime(referenced_time, formatted_time, time_zone), april_time);
+
+    ASSERT_EQ(formatter.Format(april_time, formatted_time, time_zone), "Within month");
+    ASSERT_EQ(formatter.NextChangeTime(april_time, formatted_time, time_zone), april_time + 12 * 3600 + 1);
+    ASSERT_EQ(formatter.Format(april_time + 12 * 3600 + 1, formatted_time, time_zone), "Older");
+}
+
+
+TEST(Case, ResultCache) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[0,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+        "[*,0]{%Y-%m-%d}"
+    );
+
+    auto cached_formatter = formatter.WithResultCache(64);
+    ASSERT_EQ(formatter.GetCachedResultCount(), 0u);
+    ASSERT_EQ(cached_formatter.GetCachedResultCount(), 0u);
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    for (std::time_t formatted_time = referenced_time - 7200; formatted_time < referenced_time + 10; formatted_time += 7) {
+        ASSERT_EQ(
+            cached_formatter.Format(referenced_time, formatted_time),
+            formatter.Format(referenced_time, formatted_time));
+    }
+
+    //Results of minutes, while literal results and results with standard
+    //specifiers are not cached.
+    ASSERT_EQ(cached_formatter.GetCachedResultCount(), 59u);
+
+    //Cached results are shared.
+    auto text1 = cached_formatter.FormatShared(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0));
+    auto text2 = cached_formatter.FormatShared(referenced_time, MakeTime(2018, 2, 6, 12, 52, 40));
+    ASSERT_EQ(*text1, "50 minute(s) ago");
+    ASSERT_EQ(text1, text2);
+
+    auto bound_formatter = cached_formatter.Bind(referenced_time);
+    ASSERT_EQ(bound_formatter.FormatShared(MakeTime(2018, 2, 6, 12, 53, 10)), text1);
+    ASSERT_EQ(*bound_formatter.FormatShared(MakeTime(2018, 2, 6, 1, 2, 3)), "01:02");
+    ASSERT_NE(
+        formatter.FormatShared(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0)),
+        formatter.FormatShared(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0)));
+
+    char buffer[32]{};
+    ASSERT_EQ(cached_formatter.FormatTo(buffer, sizeof(buffer), referenced_time, referenced_time - 5), 8u);
+    ASSERT_EQ(std::string(buffer), "Just now");
+
+    //The cache is dropped when it is full.
+    cached_formatter = formatter.WithResultCache(8);
+    for (int minute = 1; minute < 30; ++minute) {
+        cached_formatter.Format(referenced_time, referenced_time - minute * 60 - 1);
+        ASSERT_LE(cached_formatter.GetCachedResultCount(), 8u);
+    }
+}
+
+
+TEST(Case, ResultCache_EscapedPercent) {
+
+    //An escaped '%' doesn't depend on the formatted time, so the result is
+    //still cached by difference.
+    auto formatter = tiex::Formatter::Create("[*,*]{%~min%% done}");
+    auto cached_formatter = formatter.WithResultCache(64);
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    auto text1 = cached_formatter.FormatShared(referenced_time, referenced_time - 3 * 60);
+    auto text2 = cached_formatter.FormatShared(referenced_time, referenced_time - 3 * 60 - 30);
+    ASSERT_EQ(*text1, "3% done");
+    ASSERT_EQ(text1, text2);
+    ASSERT_EQ(cached_formatter.GetCachedResultCount(), 1u);
+}
+
+
+TEST(Case, FormatView) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[0,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+    );
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+
+    //Pure literal results refer to the formatter.
+    std::string buffer = "previous";
+    auto view = formatter.FormatView(referenced_time, referenced_time - 5, buffer);
+    ASSERT_EQ(view, "Just now");
+    ASSERT_TRUE(buffer.empty());
+
+    auto copied_formatter = formatter;
+    auto view2 = copied_formatter.FormatView(referenced_time, referenced_time - 10, buffer);
+    ASSERT_EQ(view2.data(), view.data());
+
+    view = formatter.FormatView(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0), buffer);
+    ASSERT_EQ(view, "50 minute(s) ago");
+    ASSERT_EQ(view.data(), buffer.data());
+
+    view = formatter.FormatView(referenced_time, MakeTime(2018, 2, 6, 1, 2, 3), buffer);
+    ASSERT_EQ(view, "01:02");
+
+    tiex::FormatError error;
+    view = formatter.FormatView(referenced_time, MakeTime(2016, 6, 27, 0, 0, 0), tiex::TimeZone(), tiex::Locale(), buffer, error);
+    ASSERT_TRUE(view.empty());
+    ASSERT_EQ(error.status, tiex::FormatError::Status::NoMatchedRule);
+
+    auto bound_formatter = formatter.Bind(referenced_time);
+    ASSERT_EQ(bound_formatter.FormatView(referenced_time + 10, buffer), "Future");
+    ASSERT_TRUE(buffer.empty());
+    ASSERT_EQ(bound_formatter.FormatView(MakeTime(2018, 2, 6, 12, 53, 0), buffer), "50 minute(s) ago");
+
+    //Cached results are copied to the buffer.
+    auto cached_formatter = formatter.WithResultCache();
+    view = cached_formatter.FormatView(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0), buffer);
+    ASSERT_EQ(view, "50 minute(s) ago");
+    ASSERT_EQ(view.data(), buffer.data());
+    ASSERT_EQ(cached_formatter.FormatView(referenced_time, referenced_time, buffer), "Future");
+}
+
+
+TEST(Case, DifferenceBatch) {
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+
+    std::vector<std::time_t> times1;
+    std::vector<std::time_t> times2;
+    for (std::time_t offset = -400 * 86400; offset <= 400 * 86400; offset += 86400 / 3 + 7) {
+        times1.push_back(referenced_time);
+        times2.push_back(referenced_time + offset);
+    }
+
+    for (int unit = static_cast<int>(tiex::Unit::Second); unit <= static_cast<int>(tiex::Unit::Year); ++unit) {
+
+        std::vector<int> differences(times1.size());
+        tiex::DifferenceBatch(times1.data(), times2.data(), times1.size(), static_cast<tiex::Unit>(unit), differences.data());
+
+        for (std::size_t index = 0; index < times1.size(); ++index) {
+            auto expected = tiex::Difference(times1[index], times2[index], static_cast<tiex::Unit>(unit));
+            ASSERT_EQ(differences[index], expected) << unit << ' ' << index;
+        }
+    }
+}
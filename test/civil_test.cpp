@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "tiex_civil.h"
+
+using namespace tiex::internal;
+
+TEST(Civil, DaysFromCivil) {
+
+    ASSERT_EQ(DaysFromCivil(1970, 1, 1), 0);
+    ASSERT_EQ(DaysFromCivil(1970, 1, 2), 1);
+    ASSERT_EQ(DaysFromCivil(1969, 12, 31), -1);
+    ASSERT_EQ(DaysFromCivil(2000, 2, 29), 11016);
+    ASSERT_EQ(DaysFromCivil(2000, 3, 1), 11017);
+    ASSERT_EQ(DaysFromCivil(2018, 2, 6), 17568);
+    ASSERT_EQ(DaysFromCivil(1900, 3, 1), -25508);
+    ASSERT_EQ(DaysFromCivil(1, 1, 1), -719162);
+}
+
+
+TEST(Civil, CivilFromDays) {
+
+    for (std::int64_t days = -800000; days < 800000; days += 7) {
+
+        std::int64_t year = 0;
+        int month = 0;
+        int day = 0;
+        CivilFromDays(days, year, month, day);
+
+        ASSERT_GE(month, 1);
+        ASSERT_LE(month, 12);
+        ASSERT_GE(day, 1);
+        ASSERT_LE(day, 31);
+        ASSERT_EQ(DaysFromCivil(year, month, day), days);
+    }
+}
+
+
+TEST(Civil, GetWeekday) {
+
+    ASSERT_EQ(GetWeekday(DaysFromCivil(1970, 1, 1)), 4);
+    ASSERT_EQ(GetWeekday(DaysFromCivil(1969, 12, 28)), 0);
+    ASSERT_EQ(GetWeekday(DaysFromCivil(2018, 2, 6)), 2);
+    ASSERT_EQ(GetWeekday(DaysFromCivil(1900, 1, 1)), 1);
+}
+
+
+TEST(Civil, NormalizeTm) {
+
+    auto test = [](std::tm tm, const std::tm& expected, int expected_wday, int expected_yday) {
+        if (! NormalizeTm(tm)) {
+            return false;
+        }
+        return
+            (tm.tm_year == expected.tm_year) &&
+            (tm.tm_mon == expected.tm_mon) &&
+            (tm.tm_mday == expected.tm_mday) &&
+            (tm.tm_hour == expected.tm_hour) &&
+            (tm.tm_min == expected.tm_min) &&
+            (tm.tm_sec == expected.tm_sec) &&
+            (tm.tm_wday == expected_wday) &&
+            (tm.tm_yday == expected_yday);
+    };
+
+    auto make_tm = [](int year, int month, int day, int hour, int minute, int second) {
+        std::tm tm = { 0 };
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        return tm;
+    };
+
+    ASSERT_TRUE(test(make_tm(2018, 2, 6, 13, 43, 32), make_tm(2018, 2, 6, 13, 43, 32), 2, 36));
+    ASSERT_TRUE(test(make_tm(2018, 1, 31, 24, 0, 0), make_tm(2018, 2, 1, 0, 0, 0), 4, 31));
+    ASSERT_TRUE(test(make_tm(2018, 2, 29, 0, 0, 0), make_tm(2018, 3, 1, 0, 0, 0), 4, 59));
+    ASSERT_TRUE(test(make_tm(2018, 13, 1, 0, 0, -1), make_tm(2018, 12, 31, 23, 59, 59), 1, 364));
+    ASSERT_TRUE(test(make_tm(2018, 0, 0, 0, -61, 0), make_tm(2017, 11, 29, 22, 59, 0), 3, 332));
+    ASSERT_TRUE(test(make_tm(2016, -11, 15, 0, 0, 0), make_tm(2015, 1, 15, 0, 0, 0), 4, 14));
+    ASSERT_TRUE(test(make_tm(2016, 12, 31, 0, 0, 0), make_tm(2016, 12, 31, 0, 0, 0), 6, 365));
+}
\ No newline at end of file
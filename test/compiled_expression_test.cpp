@@ -0,0 +1,63 @@
+#include <string>
+#include <gtest/gtest.h>
+#include "tiex.h"
+
+using namespace tiex;
+using namespace tiex::internal;
+
+TEST(CompiledExpression, Layout) {
+
+    ParseError error;
+    auto expression = Parse<char>("[-1~min,0]{Just now}[-1~h,0]{%~min minutes ago}[*,*]{%H:%M}", error);
+    ASSERT_EQ(error.status, ParseError::Status::None);
+
+    CompiledExpression<char> compiled(expression);
+    ASSERT_EQ(compiled.GetRuleCount(), 3u);
+
+    for (std::size_t index = 0; index < compiled.GetRuleCount(); ++index) {
+
+        const auto& condition = compiled.GetConditions()[index];
+        ASSERT_EQ(condition.backward.value, expression.rules[index].condition.backward.value);
+        ASSERT_EQ(condition.backward.unit, expression.rules[index].condition.backward.unit);
+        ASSERT_EQ(condition.forward.value, expression.rules[index].condition.forward.value);
+
+        const auto& result = compiled.GetResult(index);
+        ASSERT_EQ(result.instruction_count, expression.rules[index].result.instructions.size());
+        ASSERT_EQ(result.has_standard_specifiers, expression.rules[index].result.has_standard_specifiers);
+    }
+
+    //Literals of all results are pooled.
+    ASSERT_EQ(std::string(compiled.GetLiterals(), 8 + 12 + 1), "Just now minutes ago:");
+
+    const auto* instructions = compiled.GetInstructions(1);
+    ASSERT_EQ(instructions[0].code, Instruction::Code::Difference);
+    ASSERT_EQ(instructions[1].code, Instruction::Code::Literal);
+    ASSERT_EQ(instructions[1].offset, 8u);
+    ASSERT_EQ(instructions[1].length, 12u);
+
+    instructions = compiled.GetInstructions(2);
+    ASSERT_EQ(instructions[1].offset, 20u);
+
+    //Converting back gives the original expression.
+    auto converted = compiled.ToExpression();
+    ASSERT_EQ(converted.rules.size(), expression.rules.size());
+    for (std::size_t index = 0; index < converted.rules.size(); ++index) {
+
+        const auto& result = converted.rules[index].result;
+        const auto& expected_result = expression.rules[index].result;
+        ASSERT_EQ(result.literals, expected_result.literals);
+        ASSERT_EQ(result.instructions.size(), expected_result.instructions.size());
+
+        for (std::size_t instruction_index = 0; instruction_index < result.instructions.size(); ++instruction_index) {
+            ASSERT_EQ(result.instructions[instruction_index].offset, expected_result.instructions[instruction_index].offset);
+            ASSERT_EQ(result.instructions[instruction_index].length, expected_result.instructions[instruction_index].length);
+        }
+    }
+}
+
+
+TEST(CompiledExpression, Empty) {
+    CompiledExpression<wchar_t> compiled{ WideExpression() };
+    ASSERT_EQ(compiled.GetRuleCount(), 0u);
+    ASSERT_TRUE(compiled.ToExpression().rules.empty());
+}
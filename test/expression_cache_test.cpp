@@ -0,0 +1,104 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "test_utility.h"
+#include "tiex.h"
+
+using namespace tiex;
+using namespace tiex::internal;
+
+TEST(ExpressionCache, FindAndInsert) {
+
+    ExpressionCache<char> cache(64);
+    ASSERT_EQ(cache.Find("[*,*]{a}"), nullptr);
+
+    auto expression = std::make_shared<const CompiledExpression<char>>(Expression());
+    auto inserted = cache.Insert("[*,*]{a}", expression);
+    ASSERT_EQ(inserted, expression);
+    ASSERT_EQ(cache.Find("[*,*]{a}"), expression);
+    ASSERT_EQ(cache.GetSize(), 1u);
+
+    //The expression that has been inserted is kept.
+    inserted = cache.Insert("[*,*]{a}", std::make_shared<const CompiledExpression<char>>(Expression()));
+    ASSERT_EQ(inserted, expression);
+    ASSERT_EQ(cache.GetSize(), 1u);
+
+    cache.Clear();
+    ASSERT_EQ(cache.Find("[*,*]{a}"), nullptr);
+    ASSERT_EQ(cache.GetSize(), 0u);
+}
+
+
+TEST(ExpressionCache, Capacity) {
+
+    ExpressionCache<char> cache(64);
+    for (int index = 0; index < 10000; ++index) {
+        cache.Insert("[*,*]{" + std::to_string(index) + "}", std::make_shared<const CompiledExpression<char>>(Expression()));
+        ASSERT_LE(cache.GetSize(), 64u);
+    }
+}
+
+
+TEST(ExpressionCache, CreateShared) {
+
+    const std::string string = "[-1~min,0]{Just now}[*,*]{%H:%M}";
+
+    auto formatter = Formatter::CreateShared(string);
+    auto cached_expression = GetSharedExpressionCache<char>().Find(string);
+    ASSERT_NE(cached_expression, nullptr);
+
+    auto other_formatter = Formatter::CreateShared(string);
+    ASSERT_EQ(GetSharedExpressionCache<char>().Find(string), cached_expression);
+
+    auto referenced_time = MakeTime(2016, 6, 15, 12, 30, 30);
+    ASSERT_EQ(formatter.Format(referenced_time, referenced_time - 5), "Just now");
+    ASSERT_EQ(other_formatter.Format(referenced_time, referenced_time - 3601), "11:30");
+
+    //Expressions that fail to parse are not cached.
+    ParseError error;
+    auto invalid_formatter = Formatter::CreateShared("[*,*", error);
+    ASSERT_NE(error.status, ParseError::Status::None);
+    ASSERT_EQ(GetSharedExpressionCache<char>().Find("[*,*"), nullptr);
+
+    FormatError format_error;
+    invalid_formatter.Format(referenced_time, referenced_time, format_error);
+    ASSERT_EQ(format_error.status, FormatError::Status::NoMatchedRule);
+
+    //A cached expression resets the parse error.
+    Formatter::CreateShared(string, error);
+    ASSERT_EQ(error.status, ParseError::Status::None);
+
+    auto wide_formatter = WideFormatter::CreateShared(L"[*,*]{%~s}");
+    ASSERT_EQ(wide_formatter.Format(referenced_time, referenced_time - 5), L"5");
+}
+
+
+TEST(ExpressionCache, Concurrency) {
+
+    auto referenced_time = MakeTime(2016, 6, 15, 12, 30, 30);
+
+    std::vector<std::thread> threads;
+    for (int thread_index = 0; thread_index < 8; ++thread_index) {
+
+        threads.emplace_back([referenced_time]() {
+
+            for (int index = 0; index < 1000; ++index) {
+
+                auto string = "[*,*]{" + std::to_string(index % 50) + " %~s}";
+                auto formatter = Formatter::CreateShared(string);
+                auto text = formatter.Format(referenced_time, referenced_time - 5);
+                EXPECT_EQ(text, std::to_string(index % 50) + " 5");
+            }
+        });
+    }
+
+    for (auto& each_thread : threads) {
+        each_thread.join();
+    }
+
+    for (int index = 0; index < 50; ++index) {
+        auto string = "[*,*]{" + std::to_string(index) + " %~s}";
+        ASSERT_NE(GetSharedExpressionCache<char>().Find(string), nullptr);
+    }
+}
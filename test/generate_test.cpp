@@ -1,6 +1,8 @@
+#include <set>
 #include <gtest/gtest.h>
 #include "test_utility.h"
 #include "tiex_generate.h"
+#include "tiex_parser.h"
 
 using namespace tiex;
 using namespace tiex::internal;
@@ -561,52 +563,64 @@ TEST(Generate, GetLocaleText_UnsupportedSpecifier) {
 }
 
 
-TEST(Generate, OverrideStandardSpecifiers_Normal) {
+static std::string GenerateText(const std::string& result_string, std::time_t formatted_time, const Locale& locale) {
+
+    Scanner<char> scanner(result_string.c_str(), result_string.length());
+    Parser<char> parser(scanner);
+
+    Result result;
+    if (! parser.ParseResult(result)) {
+        return "<parse error>";
+    }
+
+    std::string text;
+    Time time(formatted_time);
+    if (! GenerateResultText(result, time, time, locale, text)) {
+        return "<generate error>";
+    }
+    return text;
+}
+
+
+TEST(Generate, GenerateResult_OverrideLocale) {
         
-    auto tm = MakeTm(2018, 3, 18, 22, 23, 49);
+    auto time = MakeTime(2018, 3, 18, 22, 23, 49);
     auto locale = GetFullLocale();
     
-    std::string result_text = "Override locale %A%a%p%b%h%B%m ";
-    bool overrode_all = OverrideStandardSpecifiers(tm, locale, result_text);
-    ASSERT_TRUE(overrode_all);
-    ASSERT_EQ(result_text, "Override locale weekdayweekdayampmmonthmonthmonthmonth ");
+    ASSERT_EQ(
+        GenerateText("{Override locale %A%a%p%b%h%B%m }", time, locale), 
+        "Override locale weekdayweekdayampmmonthmonthmonthmonth ");
     
-    result_text = "Override %Z locale %A%a%p%b%h%B%m ";
-    overrode_all = OverrideStandardSpecifiers(tm, locale, result_text);
-    ASSERT_FALSE(overrode_all);
-    ASSERT_EQ(result_text, "Override %Z locale weekdayweekdayampmmonthmonthmonthmonth ");
+    ASSERT_EQ(
+        GenerateText("{Override %Y locale %A%a%p%b%h%B%m }", time, locale), 
+        "Override 2018 locale weekdayweekdayampmmonthmonthmonthmonth ");
+
+    ASSERT_EQ(
+        GenerateText("{%H:%M:%S %I %T}", time, locale),
+        "hour:minute:second hour 22:23:49");
 }
 
 
-TEST(Generate, OverrideStandardSpecifiers_EscapePercent) {
+TEST(Generate, GenerateResult_EscapePercent) {
     
-    auto tm = MakeTm(2018, 3, 18, 22, 30, 1);
+    auto time = MakeTime(2018, 3, 18, 22, 30, 1);
     auto locale = GetFullLocale();
 
-    std::string result_text = "Escape%% %%p %%M %a";
-    bool overrode_all = OverrideStandardSpecifiers(tm, locale, result_text);
-    ASSERT_TRUE(overrode_all);
-    ASSERT_EQ(result_text, "Escape%% %%p %%M weekday");
+    ASSERT_EQ(GenerateText("{Escape%% %%p %%M %a}", time, locale), "Escape% %p %M weekday");
 }
 
 
-TEST(Generate, OverrideStandardSpecifiers_NoLocale) {
+TEST(Generate, GenerateResult_NoLocale) {
     
-    auto tm = MakeTm(2018, 3, 18, 21, 58, 44);
-	std::string result_text = "%p %a %A %b %h %B %m";
-    bool overrode_all = OverrideStandardSpecifiers(tm, Locale(), result_text);
-    ASSERT_FALSE(overrode_all);
-    ASSERT_EQ(result_text, "%p %a %A %b %h %B %m");
+    auto time = MakeTime(2018, 3, 18, 21, 58, 44);
+    ASSERT_EQ(
+        GenerateText("{%p %a %A %b %h %B %m}", time, Locale()), 
+        "PM Sun Sunday Mar Mar March 03");
 }
 
 
-TEST(Generate, OverrideStandardSpecifiers_PercentAtTail) {
-    
-    auto tm = MakeTm(2018, 3, 18, 22, 20, 0);
-    auto locale = GetFullLocale();
-    
-	std::string result_text = "Result text %";
-    bool overrode_all = OverrideStandardSpecifiers(tm, locale, result_text);
-    ASSERT_TRUE(overrode_all);
-    ASSERT_EQ(result_text, "Result text %");
+TEST(Generate, GenerateResult_UnsupportedSpecifier) {
+
+    auto time = MakeTime(2018, 3, 18, 21, 58, 44);
+    ASSERT_EQ(GenerateText("{%q %Eq %EY %OM}", time, Locale()), "%q %Eq 2018 58");
 }
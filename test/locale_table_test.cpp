@@ -0,0 +1,104 @@
+#include <string>
+#include <gtest/gtest.h>
+#include "test_utility.h"
+#include "tiex_generate.h"
+#include "tiex_locale_table.h"
+
+using namespace tiex;
+using namespace tiex::internal;
+
+
+static Locale MakeLocale(int& call_count) {
+
+    Locale locale;
+    locale.get_minute = [&call_count](int minute) {
+        ++call_count;
+        return "min" + std::to_string(minute);
+    };
+    locale.get_second = [&call_count](int second) {
+        ++call_count;
+        return "sec" + std::to_string(second);
+    };
+    locale.get_hour = [&call_count](int hour, const Locale::HourOptions& options) {
+        ++call_count;
+        return (options.is_12_hour_clock ? "h12-" : "h24-") + std::to_string(hour);
+    };
+    locale.get_am_pm = [&call_count](bool is_pm) {
+        ++call_count;
+        return std::string(is_pm ? "pm" : "am");
+    };
+    locale.get_weekday = [&call_count](int weekday, const Locale::WeekdayOptions& options) {
+        ++call_count;
+        return (options.is_abbreviated ? "wd-" : "weekday-") + std::to_string(weekday);
+    };
+    locale.get_month = [&call_count](int month, const Locale::MonthOptions& options) {
+        ++call_count;
+        std::string prefix = options.is_number ? "n" : (options.is_abbreviated ? "mon-" : "month-");
+        return prefix + std::to_string(month);
+    };
+    return locale;
+}
+
+
+TEST(LocaleTable, Find) {
+
+    int call_count = 0;
+    auto locale = MakeLocale(call_count);
+
+    LocaleTable<char> table(locale);
+    ASSERT_EQ(call_count, 60 + 60 + 24 + 12 + 2 + 7 * 2 + 12 * 3);
+
+    call_count = 0;
+
+    const std::string specifier_chars = "MSHIpaAbhBm";
+    for (int day = 0; day < 400; day += 3) {
+        for (int hour = 0; hour < 24; ++hour) {
+
+            auto tm = MakeTm(2018, 1, 1 + day, hour, (day + hour) % 60, (day * hour) % 60);
+            for (auto each_char : specifier_chars) {
+
+                std::string expected;
+                ASSERT_TRUE(GetLocaleText(each_char, tm, locale, expected));
+
+                std::string_view text;
+                ASSERT_TRUE(table.Find(each_char, tm, text));
+                ASSERT_EQ(text, expected);
+            }
+        }
+    }
+
+    //Only GetLocaleText calls the callbacks.
+    ASSERT_EQ(call_count, 134 * 24 * static_cast<int>(specifier_chars.length()));
+}
+
+
+TEST(LocaleTable, OutOfDomain) {
+
+    int call_count = 0;
+    auto locale = MakeLocale(call_count);
+    LocaleTable<char> table(locale);
+
+    auto tm = MakeTm(2018, 3, 16, 10, 20, 30);
+    tm.tm_sec = 60;
+
+    std::string_view text;
+    ASSERT_FALSE(table.Find('S', tm, text));
+
+    std::string result;
+    StringWriter<char> writer(result);
+    ASSERT_TRUE(WriteLocaleText('S', tm, table, writer));
+    ASSERT_EQ(result, "sec60");
+}
+
+
+TEST(LocaleTable, NoLocale) {
+
+    Locale locale;
+    LocaleTable<char> table(locale);
+
+    auto tm = MakeTm(2018, 3, 16, 10, 20, 30);
+    for (auto each_char : std::string("MSHIpaAbhBmYd")) {
+        std::string_view text;
+        ASSERT_FALSE(table.Find(each_char, tm, text));
+    }
+}
@@ -1,9 +1,47 @@
+#include <map>
 #include <gtest/gtest.h>
 #include "tiex_parser.h"
 
 using namespace tiex;
 using namespace tiex::internal;
 
+
+/**
+ Get texts of instructions of a result, which are empty for non-literal
+ instructions.
+ */
+template<typename C>
+static std::vector<std::basic_string<C>> GetTexts(const BasicResult<C>& result) {
+
+    std::vector<std::basic_string<C>> texts;
+    for (const auto& each_instruction : result.instructions) {
+        if (each_instruction.code == Instruction::Code::Literal) {
+            texts.push_back(result.literals.substr(each_instruction.offset, each_instruction.length));
+        }
+        else {
+            texts.push_back({});
+        }
+    }
+    return texts;
+}
+
+
+/**
+ Get non-literal instructions of a result, keyed by their indexes.
+ */
+template<typename C>
+static std::map<std::size_t, Instruction> GetSpecifiers(const BasicResult<C>& result) {
+
+    std::map<std::size_t, Instruction> specifiers;
+    for (std::size_t index = 0; index < result.instructions.size(); ++index) {
+        if (result.instructions[index].code != Instruction::Code::Literal) {
+            specifiers[index] = result.instructions[index];
+        }
+    }
+    return specifiers;
+}
+
+
 TEST(Parser, ParseChar) {
     
     std::string string = "71";
@@ -43,12 +81,12 @@ TEST(Parser, ParseWord) {
     Scanner<char> scanner(string.c_str(), string.length());
     Parser<char> parser(scanner);
     
-    std::string word;
+    std::string_view word;
     bool is_succeeded = parser.ParseWord(word);
     ASSERT_TRUE(is_succeeded);
     ASSERT_EQ(word, "Macbook");
     
-    word.clear();
+    word = {};
     is_succeeded = parser.ParseWord(word);
     ASSERT_FALSE(is_succeeded);
     ASSERT_TRUE(word.empty());
@@ -57,7 +95,7 @@ TEST(Parser, ParseWord) {
     
     parser.ParseChar('8');
     
-    word.clear();
+    word = {};
     is_succeeded = parser.ParseWord(word);
     ASSERT_FALSE(is_succeeded);
     ASSERT_TRUE(word.empty());
@@ -70,7 +108,7 @@ TEST(Parser, ParseWord_WideChar) {
 	std::wstring string = L"word";
 	Scanner<wchar_t> scanner(string.c_str(), string.length());
 	Parser<wchar_t> parser(scanner);
-	std::wstring word;
+	std::wstring_view word;
 	bool is_succeeded = parser.ParseWord(word);
 	ASSERT_TRUE(is_succeeded);
 	ASSERT_EQ(word, L"word");
@@ -395,18 +433,18 @@ TEST(Parser, ParseCondition_WideChar) {
 
 TEST(Parser, ParseResult_NoSpecifier) {
     
+    //Escaped and unsupported specifiers are literals, not fields.
     struct {
         std::string string;
-        bool has_standard_specifier;
+        std::string text;
     } result_items[] = {
         
-        { "{ }", false },
-        { "{today}", false },
-        { "{ [today] }", false },
-        { "{ [  today  ] }", false },
-        { "{%h o'clock}", true },
-        { "{Now %s seconds}", true },
-        { "{Week %OW }", true },
+        { "{ }", " " },
+        { "{today}", "today" },
+        { "{ [today] }", " [today] " },
+        { "{ [  today  ] }", " [  today  ] " },
+        { "{100%% sure}", "100% sure" },
+        { "{Unsupported %q}", "Unsupported %q" },
     };
     
     for (const auto& each_item : result_items) {
@@ -417,10 +455,10 @@ TEST(Parser, ParseResult_NoSpecifier) {
         Result result;
         bool is_succeeded = parser.ParseResult(result);
         ASSERT_TRUE(is_succeeded);
-        ASSERT_TRUE(result.specifiers.empty());
-        ASSERT_EQ(result.has_standard_specifiers, each_item.has_standard_specifier);
-        ASSERT_EQ(result.texts.size(), 1);
-        ASSERT_EQ(result.texts[0], each_item.string.substr(1, each_item.string.length() - 2));
+        ASSERT_TRUE(GetSpecifiers(result).empty());
+        ASSERT_FALSE(result.has_standard_specifiers);
+        ASSERT_EQ(GetTexts(result).size(), 1);
+        ASSERT_EQ(GetTexts(result)[0], each_item.text);
     }
     
     //Empty result
@@ -431,8 +469,8 @@ TEST(Parser, ParseResult_NoSpecifier) {
     Result result;
     bool is_succeeded = parser.ParseResult(result);
     ASSERT_TRUE(is_succeeded);
-    ASSERT_TRUE(result.specifiers.empty());
-    ASSERT_TRUE(result.texts.empty());
+    ASSERT_TRUE(GetSpecifiers(result).empty());
+    ASSERT_TRUE(GetTexts(result).empty());
     ASSERT_FALSE(result.has_standard_specifiers);
 }
 
@@ -457,24 +495,23 @@ TEST(Parser, ParseResult_HasSpecifier) {
             return false;
         }
         
-        if (result.texts.size() != expected_texts.size()) {
+        if (GetTexts(result) != expected_texts) {
             return false;
         }
-        for (std::size_t index = 0; index < result.texts.size(); ++index) {
-            if (result.texts[index] != expected_texts[index]) {
-                return false;
-            }
-        }
         
-        if (result.specifiers.size() != expected_specifer_units.size()) {
+        auto specifiers = GetSpecifiers(result);
+        if (specifiers.size() != expected_specifer_units.size()) {
             return false;
         }
-        for (const auto& each_specifier : result.specifiers) {
+        for (const auto& each_specifier : specifiers) {
             auto iterator = expected_specifer_units.find(each_specifier.first);
             if (iterator == expected_specifer_units.end()) {
                 return false;
             }
-            if (iterator->second != each_specifier.second.unit) {
+            if (each_specifier.second.code != Instruction::Code::Difference) {
+                return false;
+            }
+            if (iterator->second != each_specifier.second.specifier.unit) {
                 return false;
             }
         }
@@ -507,6 +544,90 @@ TEST(Parser, ParseResult_HasSpecifier) {
 }
 
 
+TEST(Parser, ParseResult_StandardSpecifier) {
+
+    auto test = [](
+        const std::string& string,
+        const std::vector<std::string>& expected_texts,
+        const std::map<std::size_t, char>& expected_standard_chars) {
+
+        Scanner<char> scanner(string.c_str(), string.length());
+        Parser<char> parser(scanner);
+
+        Result result;
+        bool is_succeeded = parser.ParseResult(result);
+        if (! is_succeeded) {
+            return false;
+        }
+
+        if (! result.has_standard_specifiers) {
+            return false;
+        }
+
+        if (GetTexts(result) != expected_texts) {
+            return false;
+        }
+
+        auto specifiers = GetSpecifiers(result);
+        if (specifiers.size() != expected_standard_chars.size()) {
+            return false;
+        }
+        for (const auto& each_specifier : specifiers) {
+            auto iterator = expected_standard_chars.find(each_specifier.first);
+            if (iterator == expected_standard_chars.end()) {
+                return false;
+            }
+            auto expected_code = (iterator->second == 0) ? Instruction::Code::Difference : Instruction::Code::Field;
+            if (each_specifier.second.code != expected_code) {
+                return false;
+            }
+            if (iterator->second != each_specifier.second.specifier.standard_char) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    ASSERT_TRUE(test("{%h o'clock}", { "", " o'clock" }, { { 0, 'h' } }));
+    ASSERT_TRUE(test("{Now %s seconds}", { "Now ", "", " seconds" }, { { 1, 's' } }));
+    ASSERT_TRUE(test("{Week %OW }", { "Week ", "", " " }, { { 1, 'W' } }));
+    ASSERT_TRUE(test("{%H:%M}", { "", ":", "" }, { { 0, 'H' }, { 2, 'M' } }));
+    ASSERT_TRUE(test("{%% %Ex %Eq}", { "% ", "", " %Eq" }, { { 1, 'x' } }));
+    ASSERT_TRUE(test("{%~d days %Y}", { "", " days ", "" }, { { 0, 0 }, { 2, 'Y' } }));
+}
+
+
+TEST(Parser, ParseResult_Program) {
+
+    std::string string = "{Posted %~h hours ago, at %H:%M}";
+    Scanner<char> scanner(string.c_str(), string.length());
+    Parser<char> parser(scanner);
+
+    Result result;
+    ASSERT_TRUE(parser.ParseResult(result));
+    ASSERT_EQ(result.literals, "Posted  hours ago, at :");
+    ASSERT_EQ(result.instructions.size(), 6);
+
+    const auto& instructions = result.instructions;
+    ASSERT_EQ(instructions[0].code, Instruction::Code::Literal);
+    ASSERT_EQ(instructions[0].offset, 0);
+    ASSERT_EQ(instructions[0].length, 7);
+    ASSERT_EQ(instructions[1].code, Instruction::Code::Difference);
+    ASSERT_EQ(instructions[1].specifier.unit, Unit::Hour);
+    ASSERT_EQ(instructions[2].code, Instruction::Code::Literal);
+    ASSERT_EQ(instructions[2].offset, 7);
+    ASSERT_EQ(instructions[2].length, 15);
+    ASSERT_EQ(instructions[3].code, Instruction::Code::Field);
+    ASSERT_EQ(instructions[3].specifier.standard_char, 'H');
+    ASSERT_EQ(instructions[4].code, Instruction::Code::Literal);
+    ASSERT_EQ(instructions[4].offset, 22);
+    ASSERT_EQ(instructions[4].length, 1);
+    ASSERT_EQ(instructions[5].code, Instruction::Code::Field);
+    ASSERT_EQ(instructions[5].specifier.standard_char, 'M');
+}
+
+
 TEST(Parser, ParseResult_Failure) {
     
     auto test = [](const std::string& string, ParseError::Status status, std::size_t index, const std::string& token) {
@@ -535,9 +656,9 @@ TEST(Parser, ParseResult_WideChar) {
 	bool is_succeeded = parser.ParseResult(result);
 	ASSERT_TRUE(is_succeeded);
 	ASSERT_EQ(result.has_standard_specifiers, false);
-	ASSERT_TRUE(result.specifiers.empty());
-	ASSERT_FALSE(result.texts.empty());
-	ASSERT_EQ(result.texts[0], L"hello");
+	ASSERT_TRUE(GetSpecifiers(result).empty());
+	ASSERT_FALSE(GetTexts(result).empty());
+	ASSERT_EQ(GetTexts(result)[0], L"hello");
 }
 
 
@@ -560,9 +681,9 @@ TEST(Parser, ParseRule_Normal) {
         ASSERT_EQ(rule.condition.forward.value, -1);
         ASSERT_EQ(rule.condition.forward.round, true);
         ASSERT_EQ(rule.condition.forward.unit, Unit::Day);
-        ASSERT_EQ(rule.result.texts.size(), 1);
-        ASSERT_EQ(rule.result.texts[0], "yesterday");
-        ASSERT_EQ(rule.result.specifiers.size(), 0);
+        ASSERT_EQ(GetTexts(rule.result).size(), 1);
+        ASSERT_EQ(GetTexts(rule.result)[0], "yesterday");
+        ASSERT_EQ(GetSpecifiers(rule.result).size(), 0);
         ASSERT_EQ(rule.result.has_standard_specifiers, false);
     }
 }
@@ -599,9 +720,9 @@ TEST(Parser, ParseRule_WideChar) {
 	ASSERT_EQ(rule.condition.forward.value, -1);
 	ASSERT_EQ(rule.condition.forward.round, true);
 	ASSERT_EQ(rule.condition.forward.unit, Unit::Day);
-	ASSERT_EQ(rule.result.texts.size(), 1);
-	ASSERT_EQ(rule.result.texts[0], L"yesterday");
-	ASSERT_EQ(rule.result.specifiers.size(), 0);
+	ASSERT_EQ(GetTexts(rule.result).size(), 1);
+	ASSERT_EQ(GetTexts(rule.result)[0], L"yesterday");
+	ASSERT_EQ(GetSpecifiers(rule.result).size(), 0);
 	ASSERT_EQ(rule.result.has_standard_specifiers, false);
 }
 
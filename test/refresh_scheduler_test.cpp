@@ -0,0 +1,84 @@
+#include <map>
+#include <gtest/gtest.h>
+#include "test_utility.h"
+#include "tiex.h"
+
+
+TEST(RefreshScheduler, Advance) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[1~s,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%~h hour(s) ago}"
+        "[*,0]{%Y-%m-%d}"
+    );
+
+    auto current_time = MakeTime(2018, 2, 6, 13, 0, 0);
+    tiex::RefreshScheduler scheduler(formatter, current_time);
+
+    ASSERT_EQ(scheduler.Add(1, current_time), "Just now");
+    ASSERT_EQ(scheduler.Add(2, current_time - 100), "1 minute(s) ago");
+    ASSERT_EQ(scheduler.Add(3, MakeTime(2018, 2, 1, 0, 0, 0)), "2018-02-01");
+    ASSERT_EQ(scheduler.Add(4, current_time + 30), "Future");
+    ASSERT_EQ(scheduler.GetCount(), 4u);
+
+    auto changes = scheduler.Advance(current_time + 29);
+    ASSERT_EQ(changes.size(), 1u);
+    ASSERT_EQ(changes[0].id, 2u);
+    ASSERT_EQ(changes[0].text, "2 minute(s) ago");
+
+    changes = scheduler.Advance(current_time + 61);
+    ASSERT_EQ(changes.size(), 2u);
+    ASSERT_EQ(changes[0].id, 4u);
+    ASSERT_EQ(changes[0].text, "Just now");
+    ASSERT_EQ(changes[1].id, 1u);
+    ASSERT_EQ(changes[1].text, "1 minute(s) ago");
+
+    ASSERT_TRUE(scheduler.Remove(1));
+    ASSERT_FALSE(scheduler.Remove(1));
+
+    changes = scheduler.Advance(current_time + 120);
+    ASSERT_EQ(changes.size(), 2u);
+    ASSERT_EQ(changes[0].id, 2u);
+    ASSERT_EQ(changes[1].id, 4u);
+    ASSERT_EQ(changes[1].text, "1 minute(s) ago");
+    ASSERT_EQ(scheduler.GetText(2), "3 minute(s) ago");
+    ASSERT_EQ(scheduler.GetText(3), "2018-02-01");
+}
+
+
+TEST(RefreshScheduler, SameAsFormat) {
+
+    auto formatter = tiex::Formatter::Create(
+        "[1~s,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%~h hour(s) ago}"
+        "[-2.d,0]{Yesterday %H:%M}"
+        "[*,0]{%Y-%m-%d}"
+    );
+
+    auto current_time = MakeTime(2018, 2, 6, 13, 0, 0);
+    tiex::RefreshScheduler scheduler(formatter, current_time);
+
+    std::map<tiex::RefreshScheduler::Id, std::time_t> formatted_times;
+    std::map<tiex::RefreshScheduler::Id, std::string> texts;
+    for (tiex::RefreshScheduler::Id id = 0; id < 200; ++id) {
+        auto formatted_time = current_time + 600 - static_cast<std::time_t>(id * id * 97);
+        formatted_times[id] = formatted_time;
+        texts[id] = scheduler.Add(id, formatted_time);
+    }
+
+    for (int step = 0; step < 300; ++step) {
+
+        current_time += 37 + step * 13;
+        for (const auto& each_change : scheduler.Advance(current_time)) {
+            texts[each_change.id] = each_change.text;
+        }
+
+        for (const auto& each_time : formatted_times) {
+            ASSERT_EQ(texts[each_time.first], formatter.Format(current_time, each_time.second)) << step;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "test_utility.h"
+#include "tiex_render.h"
+
+using namespace tiex;
+using namespace tiex::internal;
+
+
+template<typename C>
+static std::basic_string<C> Render(char specifier_char, const Time& time) {
+
+    std::basic_string<C> text;
+    StringWriter<C> writer(text);
+    if (! RenderStandardSpecifier(specifier_char, *time.GetTm(), time, writer)) {
+        return {};
+    }
+    return text;
+}
+
+
+TEST(Render, SameAsStrftime) {
+
+    const char* specifier_chars = "aAbBcCdDeFgGhHIjklmMnpPrRsStTuUVwWxXyYzZ";
+
+    auto test = [specifier_chars](std::time_t time_t) {
+
+        Time time(time_t);
+        for (auto iterator = specifier_chars; *iterator != 0; ++iterator) {
+
+            char format[] = { '%', *iterator, 0 };
+            char buffer[128] = { 0 };
+            std::strftime(buffer, sizeof(buffer), format, time.GetTm());
+
+            if (Render<char>(*iterator, time) != buffer) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (int year = 1971; year <= 2037; ++year) {
+
+        //Days around the start and the end of years exercise ISO weeks.
+        for (int day = -4; day <= 4; ++day) {
+            ASSERT_TRUE(test(MakeTime(year, 1, 1 + day, 0, 0, 0))) << year << " " << day;
+            ASSERT_TRUE(test(MakeTime(year, 1, 1 + day, 13, 5, 9))) << year << " " << day;
+        }
+
+        for (int month = 1; month <= 12; ++month) {
+            ASSERT_TRUE(test(MakeTime(year, month, 7 + month, month * 2 - 1, 59, 30))) << year << " " << month;
+        }
+    }
+}
+
+
+TEST(Render, TimeZone) {
+
+    auto time_zone = TimeZone::UTC();
+    Time time(1520751600, time_zone);
+
+    ASSERT_EQ(Render<char>('z', time), "+0000");
+    ASSERT_EQ(Render<char>('Z', time), "UTC");
+    ASSERT_EQ(Render<char>('c', time), "Sun Mar 11 07:00:00 2018");
+}
+
+
+TEST(Render, WideChar) {
+
+    auto time_zone = TimeZone::UTC();
+    Time time(1520751600, time_zone);
+    ASSERT_EQ(Render<wchar_t>('A', time), L"Sunday");
+    ASSERT_EQ(Render<wchar_t>('F', time), L"2018-03-11");
+    ASSERT_EQ(Render<wchar_t>('e', time), L"11");
+    ASSERT_EQ(Render<wchar_t>('Z', time), L"UTC");
+}
+
+
+TEST(Render, Unsupported) {
+
+    auto time_zone = TimeZone::UTC();
+    Time time(0, time_zone);
+    ASSERT_TRUE(Render<char>('q', time).empty());
+    ASSERT_FALSE(IsStandardSpecifierChar('q'));
+    ASSERT_FALSE(IsStandardSpecifierChar('%'));
+    ASSERT_TRUE(IsStandardSpecifierChar('H'));
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include "tiex_rule_index.h"
+
+using namespace tiex::internal;
+
+static ResolvedCondition MakeCondition(std::time_t backward_time, std::time_t forward_time) {
+    ResolvedCondition condition;
+    condition.backward_time = backward_time;
+    condition.forward_time = forward_time;
+    condition.is_valid = true;
+    return condition;
+}
+
+
+static int FindLinearly(const std::vector<ResolvedCondition>& conditions, std::time_t time) {
+    for (std::size_t index = 0; index < conditions.size(); ++index) {
+        if (! conditions[index].is_valid) {
+            return RuleIndex::InvalidCondition;
+        }
+        if ((conditions[index].backward_time <= time) && (time <= conditions[index].forward_time)) {
+            return static_cast<int>(index);
+        }
+    }
+    return RuleIndex::NoMatchedRule;
+}
+
+
+TEST(RuleIndex, Empty) {
+
+    RuleIndex index(std::vector<ResolvedCondition>{});
+    ASSERT_EQ(index.Find(0), RuleIndex::NoMatchedRule);
+    ASSERT_EQ(index.Find(std::numeric_limits<std::time_t>::min()), RuleIndex::NoMatchedRule);
+    ASSERT_EQ(index.Find(std::numeric_limits<std::time_t>::max()), RuleIndex::NoMatchedRule);
+}
+
+
+TEST(RuleIndex, FirstMatch) {
+
+    std::vector<ResolvedCondition> conditions = {
+        MakeCondition(0, std::numeric_limits<std::time_t>::max()),
+        MakeCondition(-60, 0),
+        MakeCondition(-3600, 0),
+        MakeCondition(-7200, -1800),
+        MakeCondition(10, 5),
+    };
+
+    RuleIndex index(conditions);
+    ASSERT_EQ(index.GetSegmentCount(), 5u);
+
+    for (std::time_t time = -8000; time < 100; ++time) {
+        ASSERT_EQ(index.Find(time), FindLinearly(conditions, time));
+    }
+
+    ASSERT_EQ(index.Find(std::numeric_limits<std::time_t>::max()), 0);
+    ASSERT_EQ(index.Find(std::numeric_limits<std::time_t>::min()), RuleIndex::NoMatchedRule);
+}
+
+
+TEST(RuleIndex, InvalidCondition) {
+
+    std::vector<ResolvedCondition> conditions = {
+        MakeCondition(-60, 0),
+        ResolvedCondition(),
+        MakeCondition(-3600, 0),
+    };
+
+    RuleIndex index(conditions);
+    ASSERT_EQ(index.Find(-30), 0);
+    ASSERT_EQ(index.Find(-61), RuleIndex::InvalidCondition);
+    ASSERT_EQ(index.Find(1), RuleIndex::InvalidCondition);
+}
+
+
+TEST(RuleIndex, ManyRules) {
+
+    std::vector<ResolvedCondition> conditions;
+    for (int index = 0; index < 40; ++index) {
+        conditions.push_back(MakeCondition(-(index + 1) * 100, -index * 50));
+    }
+
+    RuleIndex index(conditions);
+    ASSERT_GT(index.GetSegmentCount(), 16u);
+
+    for (std::time_t time = -5000; time < 100; ++time) {
+        ASSERT_EQ(index.Find(time), FindLinearly(conditions, time));
+    }
+}
@@ -1,3 +1,5 @@
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 #include "tiex_scanner.h"
 
@@ -21,7 +23,7 @@ TEST(Scanner, SkipWhiteSpaces_WideChar) {
 	std::wstring string(L"  2");
 	Scanner<wchar_t> scanner(string.c_str(), string.length());
 	scanner.SkipWhiteSpaces();
-	ASSERT_EQ(scanner.GetCurrentIndex(), 2);
+	ASSERT_EQ(scanner.GetCurrentIndex(), 2u);
 }
 
 
@@ -71,7 +73,7 @@ TEST(Scanner, ReadWord) {
     
     auto test_succeess = [](const std::string& string, const std::string& expected) {
         Scanner<char> scanner(string.c_str(), string.length());
-        std::string word;
+        std::string_view word;
         bool is_succeeded = scanner.ReadWord(word);
         if (! is_succeeded) {
             return false;
@@ -87,7 +89,7 @@ TEST(Scanner, ReadWord) {
     
     auto test_failure = [](const std::string& string) {
         Scanner<char> scanner(string.c_str(), string.length());
-        std::string word;
+        std::string_view word;
         bool is_succeeded = scanner.ReadWord(word);
         if (is_succeeded) {
             return false;
@@ -107,7 +109,7 @@ TEST(Scanner, ReadWord) {
 TEST(Scanner, ReadWord_WideChar) {
 	std::wstring string(L"word");
 	Scanner<wchar_t> scanner(string.c_str(), string.length());
-	std::wstring word;
+	std::wstring_view word;
 	bool is_succeeded = scanner.ReadWord(word);
 	ASSERT_TRUE(is_succeeded);
 	ASSERT_EQ(word, L"word");
@@ -118,7 +120,7 @@ TEST(Scanner, ReadNumber) {
     
     auto test_success = [](const std::string& string, const std::string& expected) {
         Scanner<char> scanner(string.c_str(), string.length());
-        std::string number;
+        std::string_view number;
         bool is_succeeded = scanner.ReadNumber(number);
         if (! is_succeeded) {
             return false;
@@ -137,7 +139,7 @@ TEST(Scanner, ReadNumber) {
     
     auto test_failure = [](const std::string& string, std::size_t expected_index) {
         Scanner<char> scanner(string.c_str(), string.length());
-        std::string number;
+        std::string_view number;
         bool is_succeeded = scanner.ReadNumber(number);
         if (is_succeeded) {
             return false;
@@ -163,8 +165,130 @@ TEST(Scanner, ReadNumber) {
 TEST(Scanner, ReadNumber_WideChar) {
 	std::wstring string(L"87");
 	Scanner<wchar_t> scanner(string.c_str(), string.length());
-	std::wstring number;
+	std::wstring_view number;
 	bool is_succeeded = scanner.ReadNumber(number);
 	ASSERT_TRUE(is_succeeded);
 	ASSERT_EQ(number, L"87");
-}
\ No newline at end of file
+}
+
+TEST(Scanner, ReadWord_View) {
+    std::string string("min}");
+    Scanner<char> scanner(string.c_str(), string.length());
+    std::string_view word;
+    ASSERT_TRUE(scanner.ReadWord(word));
+    ASSERT_EQ(word.data(), string.data());
+    ASSERT_EQ(word.length(), 3u);
+}
+
+
+TEST(Scanner, ConvertNumber) {
+
+    auto test = [](std::string_view number, bool expected_result, int expected_value) {
+        int value = 0;
+        bool is_succeeded = ConvertNumber(number, value);
+        if (is_succeeded != expected_result) {
+            return false;
+        }
+        return !is_succeeded || (value == expected_value);
+    };
+
+    ASSERT_TRUE(test("0", true, 0));
+    ASSERT_TRUE(test("+45", true, 45));
+    ASSERT_TRUE(test("-45", true, -45));
+    ASSERT_TRUE(test("2147483647", true, 2147483647));
+    ASSERT_TRUE(test("-2147483648", true, -2147483647 - 1));
+    ASSERT_TRUE(test("2147483648", false, 0));
+    ASSERT_TRUE(test("-2147483649", false, 0));
+    ASSERT_TRUE(test("98723245243545354234", false, 0));
+    ASSERT_TRUE(test("", false, 0));
+    ASSERT_TRUE(test("-", false, 0));
+
+    int value = 0;
+    ASSERT_TRUE(ConvertNumber(std::wstring_view(L"-87"), value));
+    ASSERT_EQ(value, -87);
+}
+
+
+TEST(Scanner, ReadUntil) {
+
+    auto test = [](const std::string& string, const std::string& expected) {
+        Scanner<char> scanner(string.c_str(), string.length());
+        std::string_view text;
+        bool is_succeeded = scanner.ReadUntil('%', '}', text);
+        if (is_succeeded != !expected.empty()) {
+            return false;
+        }
+        if (is_succeeded && (text != expected || text.data() != string.data())) {
+            return false;
+        }
+        return scanner.GetCurrentIndex() == expected.length();
+    };
+
+    ASSERT_TRUE(test("Just now}", "Just now"));
+    ASSERT_TRUE(test("minutes % ago}", "minutes "));
+    ASSERT_TRUE(test("a}b%", "a"));
+    ASSERT_TRUE(test("no delimiters", "no delimiters"));
+    ASSERT_TRUE(test("%H}", ""));
+    ASSERT_TRUE(test("}", ""));
+    ASSERT_TRUE(test("", ""));
+}
+
+
+TEST(Scanner, ReadUntil_DelimiterAfterClosing) {
+
+    //'%' only appears in a later result, after the closing '}'.
+    std::string string("Yesterday}[*,*]{%Y-%m-%d}");
+    Scanner<char> scanner(string.c_str(), string.length());
+
+    std::string_view text;
+    ASSERT_TRUE(scanner.ReadUntil('%', '}', text));
+    ASSERT_EQ(text, "Yesterday");
+    ASSERT_EQ(scanner.GetCurrentIndex(), 9u);
+
+    ASSERT_FALSE(scanner.ReadUntil('%', '}', text));
+    ASSERT_EQ(scanner.GetCurrentIndex(), 9u);
+
+    char ch = 0;
+    ASSERT_TRUE(scanner.ReadChar(ch));
+    ASSERT_TRUE(scanner.ReadUntil('%', '}', text));
+    ASSERT_EQ(text, "[*,*]{");
+    ASSERT_EQ(scanner.GetCurrentIndex(), 16u);
+}
+
+
+TEST(Scanner, ReadUntil_Specifiers) {
+
+    //Texts between specifiers are read in order, then the ones after the
+    //closing '}'.
+    std::string string("at %H:%M, %d}, }later");
+    Scanner<char> scanner(string.c_str(), string.length());
+
+    std::vector<std::string> texts;
+    while (! scanner.IsEnd()) {
+
+        std::string_view text;
+        if (scanner.ReadUntil('%', '}', text)) {
+            texts.emplace_back(text);
+        }
+
+        char ch = 0;
+        scanner.ReadChar(ch);
+        if (ch == '%') {
+            scanner.ReadChar(ch);
+        }
+    }
+
+    std::vector<std::string> expected{ "at ", ":", ", ", ", ", "later" };
+    ASSERT_EQ(texts, expected);
+}
+
+
+TEST(Scanner, ReadUntil_WideChar) {
+	std::wstring string(L"刚刚%H}");
+	Scanner<wchar_t> scanner(string.c_str(), string.length());
+	std::wstring_view text;
+	bool is_succeeded = scanner.ReadUntil(L'%', L'}', text);
+	ASSERT_TRUE(is_succeeded);
+	ASSERT_EQ(text, L"刚刚");
+	ASSERT_EQ(scanner.GetCurrentIndex(), 2u);
+}
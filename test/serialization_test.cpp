@@ -0,0 +1,261 @@
+#include <string>
+#include <gtest/gtest.h>
+#include "test_utility.h"
+#include "tiex.h"
+
+using namespace tiex;
+
+namespace {
+
+const std::string Expressions[] = {
+    "[*,*]{Always}",
+    "[-1~min,0]{Just now}[-1~h,0]{%~min minutes ago}[*,0]{%Y-%m-%d %H:%M}[1~s,*]{Future}",
+    "[-1.d,-1.d]{Yesterday %H:%M}[-6.d,0]{%a %%}[-1.y,0]{%~w weeks, %~mth months}[*,*]{%c}",
+    "[-2147483647~s,2147483647~s]{Large}[*,*]{}",
+};
+
+
+template<typename C>
+void CheckSameExpression(const BasicExpression<C>& expression, const BasicExpression<C>& other) {
+
+    ASSERT_EQ(expression.rules.size(), other.rules.size());
+
+    for (std::size_t index = 0; index < expression.rules.size(); ++index) {
+
+        const auto& rule = expression.rules[index];
+        const auto& other_rule = other.rules[index];
+
+        ASSERT_EQ(rule.condition.backward.value, other_rule.condition.backward.value);
+        ASSERT_EQ(rule.condition.backward.round, other_rule.condition.backward.round);
+        ASSERT_EQ(rule.condition.backward.unit, other_rule.condition.backward.unit);
+        ASSERT_EQ(rule.condition.forward.value, other_rule.condition.forward.value);
+        ASSERT_EQ(rule.condition.forward.round, other_rule.condition.forward.round);
+        ASSERT_EQ(rule.condition.forward.unit, other_rule.condition.forward.unit);
+
+        ASSERT_EQ(rule.result.literals, other_rule.result.literals);
+        ASSERT_EQ(rule.result.has_standard_specifiers, other_rule.result.has_standard_specifiers);
+        ASSERT_EQ(rule.result.instructions.size(), other_rule.result.instructions.size());
+
+        for (std::size_t instruction_index = 0; instruction_index < rule.result.instructions.size(); ++instruction_index) {
+
+            const auto& instruction = rule.result.instructions[instruction_index];
+            const auto& other_instruction = other_rule.result.instructions[instruction_index];
+
+            ASSERT_EQ(instruction.code, other_instruction.code);
+            ASSERT_EQ(instruction.specifier.standard_char, other_instruction.specifier.standard_char);
+            ASSERT_EQ(instruction.specifier.unit, other_instruction.specifier.unit);
+
+            if (instruction.code == Instruction::Code::Literal) {
+                ASSERT_EQ(instruction.offset, other_instruction.offset);
+                ASSERT_EQ(instruction.length, other_instruction.length);
+            }
+        }
+    }
+}
+
+}
+
+
+TEST(Serialization, RoundTrip) {
+
+    for (const auto& each_string : Expressions) {
+
+        ParseError error;
+        auto expression = internal::Parse<char>(each_string, error);
+        ASSERT_EQ(error.status, ParseError::Status::None) << each_string;
+
+        auto blob = Serialize(expression);
+
+        Expression deserialized;
+        ASSERT_TRUE(Deserialize(blob.data(), blob.size(), deserialized)) << each_string;
+        CheckSameExpression(expression, deserialized);
+
+        //Serializing is deterministic.
+        ASSERT_EQ(Serialize(deserialized), blob) << each_string;
+    }
+}
+
+
+TEST(Serialization, BlobFormatter) {
+
+    auto referenced_time = MakeTime(2016, 6, 15, 12, 30, 30);
+    const std::time_t offsets[] = {
+        0, 1, -1, -59, -60, -3599, -3600, -43200, -86400, -100000, -604800,
+        -2592000, -40000000, -400000000, 59, 3600, 400000000,
+    };
+
+    for (const auto& each_string : Expressions) {
+
+        ParseError parse_error;
+        auto expression = internal::Parse<char>(each_string, parse_error);
+        ASSERT_EQ(parse_error.status, ParseError::Status::None) << each_string;
+
+        auto blob = Serialize(expression);
+
+        ExpressionBlob expression_blob;
+        ASSERT_TRUE(ExpressionBlob::Open(blob.data(), blob.size(), expression_blob)) << each_string;
+        ASSERT_EQ(expression_blob.GetRuleCount(), expression.rules.size()) << each_string;
+
+        Formatter formatter(expression);
+
+        BlobFormatter blob_formatter(expression_blob);
+
+        for (auto each_offset : offsets) {
+
+            auto formatted_time = referenced_time + each_offset;
+
+            FormatError error;
+            auto expected = formatter.Format(referenced_time, formatted_time, error);
+            auto expected_status = error.status;
+
+            error = FormatError();
+            auto text = blob_formatter.Format(referenced_time, formatted_time, error);
+            ASSERT_EQ(error.status, expected_status) << each_string << ' ' << each_offset;
+            ASSERT_EQ(text, expected) << each_string << ' ' << each_offset;
+        }
+    }
+}
+
+
+TEST(Serialization, FormatView) {
+
+    auto formatter = Formatter::Create("[-1~min,0]{Just now}[*,*]{%H:%M}");
+    auto blob = formatter.Serialize();
+
+    ExpressionBlob expression_blob;
+    ASSERT_TRUE(ExpressionBlob::Open(blob.data(), blob.size(), expression_blob));
+    BlobFormatter blob_formatter(expression_blob);
+
+    auto referenced_time = MakeTime(2016, 6, 15, 12, 30, 30);
+
+    //A pure literal result refers to the blob.
+    std::string buffer;
+    auto view = blob_formatter.FormatView(referenced_time, referenced_time - 5, buffer);
+    ASSERT_EQ(view, "Just now");
+    ASSERT_GE(view.data(), blob.data());
+    ASSERT_LT(view.data(), blob.data() + blob.size());
+
+    view = blob_formatter.FormatView(referenced_time, referenced_time - 3600, buffer);
+    ASSERT_EQ(view, "11:30");
+
+    char text[16]{};
+    auto length = blob_formatter.FormatTo(text, sizeof(text), referenced_time, referenced_time - 3600);
+    ASSERT_EQ(std::string(text, length), "11:30");
+}
+
+
+TEST(Serialization, Formatter) {
+
+    auto formatter = Formatter::Create("[-1~h,0]{%~min minutes ago}[*,*]{%Y-%m-%d}");
+    auto blob = formatter.Serialize();
+
+    Formatter deserialized;
+    ASSERT_TRUE(Formatter::Deserialize(blob.data(), blob.size(), deserialized));
+
+    auto referenced_time = MakeTime(2016, 6, 15, 12, 30, 30);
+    ASSERT_EQ(deserialized.Format(referenced_time, referenced_time - 600), "10 minutes ago");
+    ASSERT_EQ(deserialized.Format(referenced_time, referenced_time - 86400), "2016-06-14");
+
+    //The formatter is not changed if the blob is invalid.
+    ASSERT_FALSE(Formatter::Deserialize(blob.data(), blob.size() - 1, deserialized));
+    ASSERT_EQ(deserialized.Format(referenced_time, referenced_time - 600), "10 minutes ago");
+}
+
+
+TEST(Serialization, CachedFormatter) {
+
+    auto blob = Formatter::Create("[-1~h,0]{%~min minutes ago}[*,*]{%H:%M}").Serialize();
+
+    Formatter deserialized;
+    ASSERT_TRUE(Formatter::Deserialize(blob.data(), blob.size(), deserialized));
+    auto formatter = deserialized.WithResultCache();
+
+    //Results with standard specifiers are not cached, though they have the
+    //same differences.
+    auto referenced_time = MakeTime(2016, 6, 15, 12, 30, 30);
+    ASSERT_EQ(formatter.Format(referenced_time, referenced_time - 7200), "10:30");
+    ASSERT_EQ(formatter.Format(referenced_time, referenced_time - 7260), "10:29");
+    ASSERT_EQ(formatter.Format(referenced_time, referenced_time - 600), "10 minutes ago");
+    ASSERT_EQ(formatter.Format(referenced_time, referenced_time - 600), "10 minutes ago");
+}
+
+
+TEST(Serialization, InvalidBlob) {
+
+    auto blob = Formatter::Create("[-1~min,0]{Just now}[-1~h,0]{%~min minutes ago}[*,*]{%H:%M}").Serialize();
+
+    Expression expression;
+    ExpressionBlob expression_blob;
+
+    ASSERT_FALSE(Deserialize(nullptr, 0, expression));
+    ASSERT_FALSE(ExpressionBlob::Open(nullptr, 0, expression_blob));
+
+    //Truncated.
+    for (std::size_t size = 0; size < blob.size(); ++size) {
+        ASSERT_FALSE(Deserialize(blob.data(), size, expression)) << size;
+        ASSERT_FALSE(ExpressionBlob::Open(blob.data(), size, expression_blob)) << size;
+    }
+
+    auto check_corrupted = [&blob](std::size_t index, char value) {
+        auto corrupted = blob;
+        corrupted[index] = value;
+        Expression expression;
+        ExpressionBlob expression_blob;
+        EXPECT_FALSE(Deserialize(corrupted.data(), corrupted.size(), expression)) << index;
+        EXPECT_FALSE(ExpressionBlob::Open(corrupted.data(), corrupted.size(), expression_blob)) << index;
+    };
+
+    //Magic.
+    check_corrupted(0, 'X');
+    //Version.
+    check_corrupted(4, 2);
+    //Character size.
+    check_corrupted(6, 4);
+    //Rule count.
+    check_corrupted(8, 100);
+    //Unit of the backward boundary of the first rule.
+    check_corrupted(24 + 8, 100);
+    //Instruction count of the first rule.
+    check_corrupted(24 + 20, 100);
+    //Code of the first instruction.
+    check_corrupted(24 + 24 * 3, 100);
+    //Length of the first instruction.
+    check_corrupted(24 + 24 * 3 + 8, 100);
+    //The third rule has standard specifiers, but its flag is cleared.
+    check_corrupted(24 + 24 * 2 + 12, 0);
+    //The first rule has no standard specifiers, but its flag is set.
+    check_corrupted(24 + 12, 1);
+
+    //A blob of a different character type.
+    WideExpression wide_expression;
+    ASSERT_FALSE(Deserialize(blob.data(), blob.size(), wide_expression));
+
+    //The unmodified blob is valid.
+    ASSERT_TRUE(Deserialize(blob.data(), blob.size(), expression));
+    ASSERT_TRUE(ExpressionBlob::Open(blob.data(), blob.size(), expression_blob));
+}
+
+
+TEST(Serialization, WideChar) {
+
+    auto formatter = WideFormatter::Create(L"[-1~min,0]{刚刚}[-1~h,0]{%~min分钟前}[*,*]{%H:%M}");
+    auto blob = formatter.Serialize();
+
+    WideExpression expression;
+    ASSERT_TRUE(Deserialize(blob.data(), blob.size(), expression));
+    ASSERT_EQ(expression.rules.size(), 3u);
+    ASSERT_EQ(expression.rules[0].result.literals, L"刚刚");
+
+    WideExpressionBlob expression_blob;
+    ASSERT_TRUE(WideExpressionBlob::Open(blob.data(), blob.size(), expression_blob));
+    WideBlobFormatter blob_formatter(expression_blob);
+
+    auto referenced_time = MakeTime(2016, 6, 15, 12, 30, 30);
+    ASSERT_EQ(blob_formatter.Format(referenced_time, referenced_time - 5), L"刚刚");
+    ASSERT_EQ(blob_formatter.Format(referenced_time, referenced_time - 600), L"10分钟前");
+    ASSERT_EQ(blob_formatter.Format(referenced_time, referenced_time - 7200), L"10:30");
+
+    //A blob of a different character type.
+    Expression narrow_expression;
+    ASSERT_FALSE(Deserialize(blob.data(), blob.size(), narrow_expression));
+}
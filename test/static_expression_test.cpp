@@ -0,0 +1,306 @@
+#include <vector>
+#include <gtest/gtest.h>
+#include "test_utility.h"
+#include "tiex.h"
+#include "tiex_parser.h"
+
+using namespace tiex;
+using namespace tiex::internal;
+
+namespace {
+
+/**
+ A table whose sizes are determined at runtime, so that expressions that
+ are not constant can be parsed by ParseStaticExpression for comparison.
+ */
+template<typename C>
+class DynamicTable {
+public:
+    std::vector<StaticRule> rules;
+    std::vector<Instruction> instructions;
+    std::vector<C> literals;
+};
+
+
+void CheckSameAsParser(const std::string& string) {
+
+    Scanner<char> scanner(string.c_str(), string.length());
+    Parser<char> parser(scanner);
+    auto expression = parser.Parse();
+    const auto& parse_error = parser.GetParseError();
+
+    auto size = MeasureStaticExpression<char>(string);
+    ASSERT_EQ(size.parse_error.status, parse_error.status) << string;
+    ASSERT_EQ(size.parse_error.index, parse_error.index) << string;
+
+    if (parse_error.status != ParseError::Status::None) {
+        return;
+    }
+
+    DynamicTable<char> table;
+    table.rules.resize(size.rule_count);
+    table.instructions.resize(size.instruction_count);
+    table.literals.resize(size.literal_length);
+    ParseStaticExpression<char>(string, &table);
+
+    ASSERT_EQ(table.rules.size(), expression.rules.size()) << string;
+
+    for (std::size_t rule_index = 0; rule_index < table.rules.size(); ++rule_index) {
+
+        const auto& static_rule = table.rules[rule_index];
+        const auto& rule = expression.rules[rule_index];
+
+        ASSERT_EQ(static_rule.condition.backward.value, rule.condition.backward.value);
+        ASSERT_EQ(static_rule.condition.backward.round, rule.condition.backward.round);
+        ASSERT_EQ(static_rule.condition.backward.unit, rule.condition.backward.unit);
+        ASSERT_EQ(static_rule.condition.forward.value, rule.condition.forward.value);
+        ASSERT_EQ(static_rule.condition.forward.round, rule.condition.forward.round);
+        ASSERT_EQ(static_rule.condition.forward.unit, rule.condition.forward.unit);
+        ASSERT_EQ(static_rule.has_standard_specifiers, rule.result.has_standard_specifiers);
+        ASSERT_EQ(static_rule.instruction_count, rule.result.instructions.size());
+
+        for (std::size_t index = 0; index < static_rule.instruction_count; ++index) {
+
+            const auto& static_instruction = table.instructions[static_rule.instruction_offset + index];
+            const auto& instruction = rule.result.instructions[index];
+
+            ASSERT_EQ(static_instruction.code, instruction.code);
+            ASSERT_EQ(static_instruction.specifier.standard_char, instruction.specifier.standard_char);
+            ASSERT_EQ(static_instruction.specifier.unit, instruction.specifier.unit);
+            ASSERT_EQ(
+                std::string(table.literals.data() + static_instruction.offset, static_instruction.length),
+                rule.result.literals.substr(instruction.offset, instruction.length));
+        }
+    }
+}
+
+}
+
+
+TEST(StaticExpression, Compile) {
+
+    constexpr auto expression = TIEX_EXPR("[-1~min, 0]{Just now} [-1.d,0]{%~h hours %H:%M}");
+
+    static_assert(expression.rules.size() == 2, "");
+    static_assert(expression.instructions.size() == 6, "");
+    static_assert(expression.literals.size() == 16, "");
+
+    static_assert(expression.rules[0].condition.backward.value == -1, "");
+    static_assert(expression.rules[0].condition.backward.unit == Unit::Minute, "");
+    static_assert(! expression.rules[0].condition.backward.round, "");
+    static_assert(expression.rules[0].condition.forward.value == 0, "");
+    static_assert(! expression.rules[0].has_standard_specifiers, "");
+
+    static_assert(expression.rules[1].condition.backward.round, "");
+    static_assert(expression.rules[1].condition.backward.unit == Unit::Day, "");
+    static_assert(expression.rules[1].has_standard_specifiers, "");
+    static_assert(expression.rules[1].instruction_offset == 1, "");
+    static_assert(expression.rules[1].instruction_count == 5, "");
+    static_assert(expression.instructions[1].code == Instruction::Code::Difference, "");
+    static_assert(expression.instructions[3].specifier.standard_char == 'H', "");
+
+    ASSERT_EQ(std::string(expression.literals.data(), expression.literals.size()), "Just now hours :");
+
+    constexpr auto wide_expression = TIEX_EXPR(L"[*,*]{%~min}");
+    static_assert(wide_expression.rules.size() == 1, "");
+    static_assert(wide_expression.literals.empty(), "");
+
+    //An escaped '%' is a literal, not a standard specifier.
+    constexpr auto escaped_expression = TIEX_EXPR("[*,*]{%~min%% done}");
+    static_assert(! escaped_expression.rules[0].has_standard_specifiers, "");
+}
+
+
+TEST(StaticExpression, Error) {
+
+    static_assert(MeasureStaticExpression<char>("").parse_error.status == ParseError::Status::UnexpectedEnd, "");
+    static_assert(MeasureStaticExpression<char>("[*,*]{").parse_error.status == ParseError::Status::UnexpectedEnd, "");
+    static_assert(MeasureStaticExpression<char>("[1.x,0]{}").parse_error.status == ParseError::Status::UnexpectedToken, "");
+    static_assert(MeasureStaticExpression<char>("[1.x,0]{}").parse_error.index == 3, "");
+    static_assert(MeasureStaticExpression<char>("[2147483648~s,0]{}").parse_error.status == ParseError::Status::ConversionFailed, "");
+}
+
+
+TEST(StaticExpression, SameAsParser) {
+
+    std::string strings[] = {
+        "",
+        " ",
+        "[",
+        "[*",
+        "[*,*",
+        "[*,*]",
+        "[*,*]{",
+        "[*,*]{all",
+        "[*,*]{%",
+        "[*,*]{%~}",
+        "[*,*]{%~x}",
+        "[*,*][*,*]{all}",
+        "[*,*]{all}{all}",
+        "[*,*]{all}0[*,*]{all}",
+        "[-",
+        "[+~s,0]{}",
+        "[-1",
+        "[-1 ",
+        "[-1x",
+        "[-1~",
+        "[-1~mon,0]{}",
+        "[1.x,0]{}",
+        "[2147483647~s,0]{}",
+        "[2147483648~s,0]{}",
+        "[-2147483648~s,0]{}",
+        "[-2147483649~s,0]{}",
+        "[99999999999999999999999~s,0]{}",
+        "[-0~s,+0~s]{}",
+        "[*,*]{}",
+        "[*,*]{all}",
+        " [ -1 ~ min , 1 . min ] { just now }  [*,0]{%Y-%m-%d} ",
+        "[-1.d,0]{%~h hours %H:%M}[-1~y,0]{%~mth months}[*,*]{%~d %~w %~s}",
+        "[*,*]{%Ey %Od %EQ %% %q %%%H}",
+        "[*,*]{100%}",
+    };
+
+    for (const auto& each_string : strings) {
+        CheckSameAsParser(each_string);
+    }
+}
+
+
+TEST(StaticFormatter, Format) {
+
+    static constexpr auto expression = TIEX_EXPR(
+        "[0,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+        "[-2.d,0]{Yesterday}"
+        "[-3.d,0]{The day before yesterday}"
+        "[-1~w,0]{%A}"
+        "[-1.y,0]{%m-%d}"
+    );
+
+    static constexpr StaticFormatter static_formatter(expression);
+    static_assert(static_formatter.GetRuleCount() == 8, "");
+
+    auto formatter = Formatter::Create(
+        "[0,*]{Future}"
+        "[-1~min,0]{Just now}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{%H:%M}"
+        "[-2.d,0]{Yesterday}"
+        "[-3.d,0]{The day before yesterday}"
+        "[-1~w,0]{%A}"
+        "[-1.y,0]{%m-%d}"
+    );
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    for (std::time_t formatted_time = referenced_time - 400 * 86400; formatted_time < referenced_time + 100; formatted_time += 3457) {
+
+        FormatError expected_error;
+        auto expected = formatter.Format(referenced_time, formatted_time, expected_error);
+        FormatError actual_error;
+        auto actual = static_formatter.Format(referenced_time, formatted_time, actual_error);
+        ASSERT_EQ(actual, expected);
+        ASSERT_EQ(actual_error.status, expected_error.status);
+    }
+
+    ASSERT_EQ(static_formatter.Format(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0)), "50 minute(s) ago");
+
+    char buffer[8]{};
+    ASSERT_EQ(static_formatter.FormatTo(buffer, sizeof(buffer), referenced_time, MakeTime(2018, 2, 2, 0, 0, 0)), 6u);
+    ASSERT_EQ(std::string(buffer, 6), "Friday");
+
+    //Views of pure literal results refer to the expression.
+    std::string view_buffer;
+    auto view = static_formatter.FormatView(referenced_time, referenced_time - 5, view_buffer);
+    ASSERT_EQ(view, "Just now");
+    ASSERT_GE(view.data(), expression.literals.data());
+    ASSERT_LT(view.data(), expression.literals.data() + expression.literals.size());
+    ASSERT_EQ(static_formatter.FormatView(referenced_time, MakeTime(2018, 2, 6, 1, 2, 3), view_buffer), "01:02");
+}
+
+
+TEST(StaticFormatter, WideChar) {
+
+    static constexpr auto expression = TIEX_EXPR(L"[-1~h,0]{%~min minute(s) ago}");
+    static constexpr WideStaticFormatter formatter(expression);
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    ASSERT_EQ(formatter.Format(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0)), L"50 minute(s) ago");
+
+    FormatError error;
+    ASSERT_EQ(formatter.Format(referenced_time, referenced_time + 1, error), L"");
+    ASSERT_EQ(error.status, FormatError::Status::NoMatchedRule);
+}
+
+
+TEST(SpecializedFormatter, Format) {
+
+#define TEST_EXPRESSION \
+    "[0,*]{Future}" \
+    "[-30~s,0]{Just now}" \
+    "[-1~min,0]{%~s seconds ago}" \
+    "[-1~h,0]{%~min minute(s) ago}" \
+    "[-1.h,0]{%M minutes %~s}" \
+    "[-1.d,0]{%~h hour(s) ago}" \
+    "[-2.d,-1.d]{Yesterday %H:%M}" \
+    "[-1.w,0]{%A}" \
+    "[-2~w,0]{%~d days ago}" \
+    "[-1.mth,0]{%~w weeks ago}" \
+    "[-1.y,0]{%~mth month(s) ago}" \
+    "[-3~y,0]{%~y year(s) ago}"
+
+    static constexpr auto expression = TIEX_EXPR(TEST_EXPRESSION);
+    SpecializedFormatter<expression> specialized_formatter;
+    static_assert(SpecializedFormatter<expression>::GetRuleCount() == 12, "");
+
+    auto formatter = Formatter::Create(TEST_EXPRESSION);
+#undef TEST_EXPRESSION
+
+    std::time_t referenced_times[] = {
+        MakeTime(2018, 2, 6, 13, 43, 32),
+        MakeTime(2018, 1, 1, 0, 0, 0),
+        MakeTime(2020, 2, 29, 23, 59, 59),
+    };
+
+    for (auto referenced_time : referenced_times) {
+
+        for (std::time_t distance = -10; distance < 5 * 366 * 86400; distance = distance * 11 / 10 + 7) {
+
+            auto formatted_time = referenced_time - distance;
+
+            FormatError expected_error;
+            auto expected = formatter.Format(referenced_time, formatted_time, expected_error);
+            FormatError actual_error;
+            auto actual = specialized_formatter.Format(referenced_time, formatted_time, actual_error);
+            ASSERT_EQ(actual, expected) << referenced_time << ' ' << formatted_time;
+            ASSERT_EQ(actual_error.status, expected_error.status);
+        }
+    }
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    ASSERT_EQ(specialized_formatter.Format(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0)), "50 minute(s) ago");
+
+    char buffer[16]{};
+    ASSERT_EQ(specialized_formatter.FormatTo(buffer, sizeof(buffer), referenced_time, referenced_time + 1), 6u);
+    ASSERT_EQ(std::string(buffer, 6), "Future");
+
+    std::string view_buffer;
+    auto view = specialized_formatter.FormatView(referenced_time, referenced_time - 5, view_buffer);
+    ASSERT_EQ(view, "Just now");
+    ASSERT_TRUE(view_buffer.empty());
+}
+
+
+TEST(SpecializedFormatter, WideChar) {
+
+    static constexpr auto expression = TIEX_EXPR(L"[-1~h,0]{%~min minute(s) ago}");
+    SpecializedFormatter<expression> formatter;
+
+    auto referenced_time = MakeTime(2018, 2, 6, 13, 43, 32);
+    ASSERT_EQ(formatter.Format(referenced_time, MakeTime(2018, 2, 6, 12, 53, 0)), L"50 minute(s) ago");
+
+    FormatError error;
+    ASSERT_EQ(formatter.Format(referenced_time, referenced_time + 1, error), L"");
+    ASSERT_EQ(error.status, FormatError::Status::NoMatchedRule);
+}
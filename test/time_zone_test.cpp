@@ -0,0 +1,449 @@
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+#include "test_utility.h"
+#include "tiex.h"
+
+using namespace tiex;
+
+namespace {
+
+void AppendInteger(std::string& data, std::int64_t value, int size) {
+    for (int index = size - 1; index >= 0; --index) {
+        data.push_back(static_cast<char>((value >> (index * 8)) & 0xff));
+    }
+}
+
+
+class TzifType {
+public:
+    std::int32_t offset;
+    bool is_dst;
+    std::string abbreviation;
+};
+
+
+/**
+ Build TZif data of version 2, in which version 1 data is empty.
+ */
+std::string BuildTzif(
+    const std::vector<std::int64_t>& transition_times,
+    const std::vector<int>& transition_types,
+    const std::vector<TzifType>& types,
+    const std::string& footer) {
+
+    std::string chars;
+    std::vector<std::size_t> abbreviation_indexes;
+    for (const auto& each_type : types) {
+        abbreviation_indexes.push_back(chars.size());
+        chars.append(each_type.abbreviation);
+        chars.push_back('\0');
+    }
+
+    auto append_header = [&](std::string& data, bool is_empty) {
+        data.append("TZif2");
+        data.append(15, '\0');
+        AppendInteger(data, 0, 4);
+        AppendInteger(data, 0, 4);
+        AppendInteger(data, 0, 4);
+        AppendInteger(data, is_empty ? 0 : transition_times.size(), 4);
+        AppendInteger(data, is_empty ? 1 : types.size(), 4);
+        AppendInteger(data, is_empty ? 1 : chars.size(), 4);
+    };
+
+    std::string data;
+    append_header(data, true);
+    AppendInteger(data, 0, 4);
+    AppendInteger(data, 0, 1);
+    AppendInteger(data, 0, 1);
+    data.push_back('\0');
+
+    append_header(data, false);
+    for (auto each_time : transition_times) {
+        AppendInteger(data, each_time, 8);
+    }
+    for (auto each_type : transition_types) {
+        AppendInteger(data, each_type, 1);
+    }
+    for (std::size_t index = 0; index < types.size(); ++index) {
+        AppendInteger(data, types[index].offset, 4);
+        AppendInteger(data, types[index].is_dst ? 1 : 0, 1);
+        AppendInteger(data, abbreviation_indexes[index], 1);
+    }
+    data.append(chars);
+
+    data.push_back('\n');
+    data.append(footer);
+    data.push_back('\n');
+    return data;
+}
+
+
+TimeZone LoadNewYork() {
+    //Transitions of 2018 and rules of following years.
+    auto data = BuildTzif(
+        { 1520751600, 1541311200 },
+        { 1, 0 },
+        { { -18000, false, "EST" }, { -14400, true, "EDT" } },
+        "EST5EDT,M3.2.0,M11.1.0");
+    return TimeZone::LoadFromTzif(data.data(), data.size());
+}
+
+
+std::time_t MakeTime(const TimeZone& time_zone, int year, int month, int day, int hour, int minute, int second) {
+    std::tm tm = { 0 };
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    tm.tm_isdst = -1;
+    std::time_t time = 0;
+    time_zone.MakeTime(tm, time);
+    return time;
+}
+
+}
+
+
+TEST(TimeZone, Local) {
+
+    TimeZone time_zone;
+    ASSERT_TRUE(time_zone.IsValid());
+    ASSERT_TRUE(time_zone.IsLocal());
+
+    for (std::time_t time = 0; time < 2000000000; time += 86400 * 3 + 3607) {
+
+        std::tm expected = *std::localtime(&time);
+        std::tm actual = { 0 };
+        ASSERT_TRUE(time_zone.ToTm(time, actual));
+        ASSERT_EQ(actual.tm_hour, expected.tm_hour);
+        ASSERT_EQ(actual.tm_mday, expected.tm_mday);
+
+        std::time_t converted_time = 0;
+        ASSERT_TRUE(time_zone.MakeTime(actual, converted_time));
+        ASSERT_EQ(converted_time, time);
+    }
+
+    std::time_t time = 0;
+    ASSERT_TRUE(time_zone.MakeTime(MakeTm(2018, 2, 6, 13, 43, 32), time));
+    ASSERT_EQ(time, ::MakeTime(2018, 2, 6, 13, 43, 32));
+}
+
+
+TEST(TimeZone, Local_Transitions) {
+
+    auto loaded_time_zone = TimeZone::Local();
+    ASSERT_TRUE(loaded_time_zone.IsValid());
+    ASSERT_FALSE(loaded_time_zone.IsLocal());
+
+    //Days around the DST transitions of 1991 in China, where tests run.
+    for (const auto& time_zone : { TimeZone(), loaded_time_zone }) {
+        for (std::time_t begin_time : { 671241600, 684633600 }) {
+            for (std::time_t time = begin_time; time < begin_time + 8 * 86400; time += 599) {
+
+                std::tm expected = *std::localtime(&time);
+                std::tm actual = { 0 };
+                ASSERT_TRUE(time_zone.ToTm(time, actual));
+                ASSERT_EQ(actual.tm_year, expected.tm_year);
+                ASSERT_EQ(actual.tm_mon, expected.tm_mon);
+                ASSERT_EQ(actual.tm_mday, expected.tm_mday);
+                ASSERT_EQ(actual.tm_hour, expected.tm_hour);
+                ASSERT_EQ(actual.tm_min, expected.tm_min);
+                ASSERT_EQ(actual.tm_sec, expected.tm_sec);
+                ASSERT_EQ(actual.tm_wday, expected.tm_wday);
+                ASSERT_EQ(actual.tm_yday, expected.tm_yday);
+                ASSERT_EQ(actual.tm_isdst, expected.tm_isdst);
+
+                char buffer[64] = { 0 };
+                auto length = std::strftime(buffer, sizeof(buffer), "%Z", &expected);
+                std::string abbreviation;
+                ASSERT_TRUE(time_zone.GetAbbreviation(time, abbreviation));
+                ASSERT_EQ(abbreviation, std::string(buffer, length));
+
+                std::time_t converted_time = 0;
+                ASSERT_TRUE(time_zone.MakeTime(expected, converted_time));
+                ASSERT_EQ(converted_time, std::mktime(&expected));
+            }
+        }
+    }
+}
+
+
+#ifndef _WIN32
+TEST(TimeZone, Local_TzChange) {
+
+    const char* tz = std::getenv("TZ");
+    bool has_tz = (tz != nullptr);
+    std::string original_tz = has_tz ? tz : "";
+    auto loaded_time_zone = TimeZone::Local();
+
+    ::setenv("TZ", "UTC0", 1);
+    ::tzset();
+
+    //The default time zone follows the C library, while a loaded one
+    //doesn't change until it is loaded again.
+    std::int32_t offset = 0;
+    bool is_dst = false;
+    EXPECT_TRUE(TimeZone().GetOffset(1518098816, offset, is_dst));
+    EXPECT_EQ(offset, 0);
+    EXPECT_TRUE(loaded_time_zone.GetOffset(1518098816, offset, is_dst));
+    EXPECT_EQ(offset, 8 * 3600);
+    EXPECT_TRUE(TimeZone::Local().GetOffset(1518098816, offset, is_dst));
+    EXPECT_EQ(offset, 0);
+
+    if (has_tz) {
+        ::setenv("TZ", original_tz.c_str(), 1);
+    }
+    else {
+        ::unsetenv("TZ");
+    }
+    ::tzset();
+}
+#endif
+
+
+TEST(TimeZone, UTC) {
+
+    auto time_zone = TimeZone::UTC();
+    ASSERT_TRUE(time_zone.IsValid());
+    ASSERT_FALSE(time_zone.IsLocal());
+
+    std::tm tm = { 0 };
+    ASSERT_TRUE(time_zone.ToTm(1518070016, tm));
+    ASSERT_EQ(tm.tm_year, 118);
+    ASSERT_EQ(tm.tm_mon, 1);
+    ASSERT_EQ(tm.tm_mday, 8);
+    ASSERT_EQ(tm.tm_hour, 6);
+    ASSERT_EQ(tm.tm_min, 6);
+    ASSERT_EQ(tm.tm_sec, 56);
+    ASSERT_EQ(tm.tm_wday, 4);
+
+    ASSERT_EQ(MakeTime(time_zone, 2018, 2, 8, 6, 6, 56), 1518070016);
+}
+
+
+TEST(TimeZone, Invalid) {
+
+    auto time_zone = TimeZone::LoadFromTzif("TZif", 4);
+    ASSERT_FALSE(time_zone.IsValid());
+
+    std::tm tm = { 0 };
+    ASSERT_FALSE(time_zone.ToTm(0, tm));
+
+    std::time_t time = 0;
+    ASSERT_FALSE(time_zone.MakeTime(tm, time));
+
+    ASSERT_FALSE(TimeZone::Load("").IsValid());
+    ASSERT_FALSE(TimeZone::Load("../etc/passwd").IsValid());
+    ASSERT_FALSE(TimeZone::Load("No/Such_Zone").IsValid());
+
+    auto formatter = Formatter::Create("[*,*]{%Y}");
+    FormatError error;
+    formatter.Format(0, 0, time_zone, Locale(), error);
+    ASSERT_EQ(error.status, FormatError::Status::TimeError);
+}
+
+
+TEST(TimeZone, Transitions) {
+
+    auto time_zone = LoadNewYork();
+    ASSERT_TRUE(time_zone.IsValid());
+
+    auto test = [&](std::time_t time, std::int32_t expected_offset, bool expected_is_dst) {
+        std::int32_t offset = 0;
+        bool is_dst = false;
+        if (! time_zone.GetOffset(time, offset, is_dst)) {
+            return false;
+        }
+        return (offset == expected_offset) && (is_dst == expected_is_dst);
+    };
+
+    //Before the first transition.
+    ASSERT_TRUE(test(0, -18000, false));
+    ASSERT_TRUE(test(1520751599, -18000, false));
+    ASSERT_TRUE(test(1520751600, -14400, true));
+    ASSERT_TRUE(test(1541311199, -14400, true));
+    ASSERT_TRUE(test(1541311200, -18000, false));
+
+    //After the last transition, by the footer rule.
+    //2019-03-10 07:00:00 UTC and 2019-11-03 06:00:00 UTC.
+    ASSERT_TRUE(test(1552201199, -18000, false));
+    ASSERT_TRUE(test(1552201200, -14400, true));
+    ASSERT_TRUE(test(1572760799, -14400, true));
+    ASSERT_TRUE(test(1572760800, -18000, false));
+
+    //2100-07-01 00:00:00 UTC
+    ASSERT_TRUE(test(4118083200, -14400, true));
+}
+
+
+TEST(TimeZone, MakeTime) {
+
+    auto time_zone = LoadNewYork();
+
+    ASSERT_EQ(MakeTime(time_zone, 2018, 2, 6, 13, 43, 32), 1517942612);
+    ASSERT_EQ(MakeTime(time_zone, 2018, 7, 1, 0, 0, 0), 1530417600);
+
+    //Skipped local time is shifted forward.
+    ASSERT_EQ(MakeTime(time_zone, 2018, 3, 11, 2, 30, 0), MakeTime(time_zone, 2018, 3, 11, 3, 30, 0));
+
+    //Repeated local time respects the DST flag.
+    std::tm tm = { 0 };
+    tm.tm_year = 118;
+    tm.tm_mon = 10;
+    tm.tm_mday = 4;
+    tm.tm_hour = 1;
+    tm.tm_min = 30;
+
+    std::time_t time = 0;
+    tm.tm_isdst = 1;
+    ASSERT_TRUE(time_zone.MakeTime(tm, time));
+    ASSERT_EQ(time, 1541309400);
+
+    tm.tm_isdst = 0;
+    ASSERT_TRUE(time_zone.MakeTime(tm, time));
+    ASSERT_EQ(time, 1541313000);
+}
+
+
+TEST(TimeZone, MakeTime_DstFlag) {
+
+    auto time_zone = LoadNewYork();
+
+    //The DST flag only picks one of repeated local times, unlike
+    //std::mktime, it never shifts a local time that is unambiguous.
+    for (int is_dst : { -1, 0, 1 }) {
+
+        std::tm tm = { 0 };
+        tm.tm_year = 118;
+        tm.tm_mon = 0;
+        tm.tm_mday = 15;
+        tm.tm_hour = 12;
+        tm.tm_isdst = is_dst;
+
+        std::time_t time = 0;
+        ASSERT_TRUE(time_zone.MakeTime(tm, time));
+        ASSERT_EQ(time, 1516035600);
+
+        tm.tm_mon = 6;
+        ASSERT_TRUE(time_zone.MakeTime(tm, time));
+        ASSERT_EQ(time, 1531670400);
+    }
+
+    //Boundaries are made from the referenced tm, whose DST flag is kept,
+    //so a boundary in the other season of the year is exact.
+    auto formatter = Formatter::Create("[-6.mth,*]{In}[*,*]{Out}");
+    //2018-07-15 12:00:00 EDT
+    std::time_t referenced_time = 1531670400;
+    //2018-02-01 00:00:00 EST
+    std::time_t boundary_time = 1517461200;
+    ASSERT_EQ(formatter.Format(referenced_time, boundary_time, time_zone), "In");
+    ASSERT_EQ(formatter.Format(referenced_time, boundary_time - 1, time_zone), "Out");
+    ASSERT_EQ(formatter.Bind(referenced_time, time_zone).Format(boundary_time - 1), "Out");
+}
+
+
+TEST(TimeZone, SouthernHemisphere) {
+
+    auto data = BuildTzif({}, {}, { { 36000, false, "AEST" } }, "AEST-10AEDT,M10.1.0,M4.1.0/3");
+    auto time_zone = TimeZone::LoadFromTzif(data.data(), data.size());
+    ASSERT_TRUE(time_zone.IsValid());
+
+    std::tm tm = { 0 };
+    //2018-01-15 00:00:00 UTC
+    ASSERT_TRUE(time_zone.ToTm(1515974400, tm));
+    ASSERT_EQ(tm.tm_hour, 11);
+    ASSERT_EQ(tm.tm_isdst, 1);
+
+    //2018-07-15 00:00:00 UTC
+    ASSERT_TRUE(time_zone.ToTm(1531612800, tm));
+    ASSERT_EQ(tm.tm_hour, 10);
+    ASSERT_EQ(tm.tm_isdst, 0);
+}
+
+
+TEST(TimeZone, Format) {
+
+    auto time_zone = LoadNewYork();
+    auto formatter = Formatter::Create(
+        "[-1.d,0]{%H:%M}"
+        "[-2.d,0]{Yesterday}"
+        "[*,0]{%Y-%m-%d}"
+    );
+
+    auto referenced_time = MakeTime(time_zone, 2018, 3, 12, 1, 30, 0);
+    ASSERT_EQ(formatter.Format(referenced_time, MakeTime(time_zone, 2018, 3, 12, 0, 10, 0), time_zone), "00:10");
+    ASSERT_EQ(formatter.Format(referenced_time, MakeTime(time_zone, 2018, 3, 11, 23, 59, 59), time_zone), "Yesterday");
+    ASSERT_EQ(formatter.Format(referenced_time, MakeTime(time_zone, 2018, 3, 11, 0, 0, 0), time_zone), "Yesterday");
+    ASSERT_EQ(formatter.Format(referenced_time, MakeTime(time_zone, 2018, 3, 10, 23, 59, 59), time_zone), "2018-03-10");
+
+    auto bound_formatter = formatter.Bind(referenced_time, time_zone);
+    ASSERT_EQ(bound_formatter.Format(MakeTime(time_zone, 2018, 3, 12, 0, 10, 0)), "00:10");
+    ASSERT_EQ(bound_formatter.Format(MakeTime(time_zone, 2018, 3, 11, 0, 0, 0)), "Yesterday");
+    ASSERT_EQ(bound_formatter.Format(MakeTime(time_zone, 2018, 3, 10, 23, 59, 59)), "2018-03-10");
+
+    ASSERT_EQ(Difference(MakeTime(time_zone, 2018, 4, 1, 0, 0, 0), MakeTime(time_zone, 2018, 3, 1, 0, 0, 0), Unit::Month, time_zone), 1);
+}
+
+
+TEST(TimeZone, NextChangeTime) {
+
+    auto time_zone = LoadNewYork();
+    auto formatter = Formatter::Create(
+        "[0,*]{Future}"
+        "[-1~h,0]{%~min minute(s) ago}"
+        "[-1.d,0]{Today}"
+        "[-2.d,0]{Yesterday}"
+        "[-1~w,0]{%~h hour(s) ago}"
+        "[-1.y,0]{%~mth month(s) ago}"
+        "[*,0]{Long ago}"
+    );
+
+    //Transitions of 2018 are crossed by referenced times.
+    for (auto formatted_time : { MakeTime(time_zone, 2018, 3, 10, 2, 30, 0), MakeTime(time_zone, 2018, 11, 3, 1, 30, 0) }) {
+
+        auto referenced_time = formatted_time - 3600;
+        auto end_time = formatted_time + 60 * 86400;
+        while (referenced_time < end_time) {
+
+            auto result = formatter.Format(referenced_time, formatted_time, time_zone);
+            auto next_change_time = formatter.NextChangeTime(referenced_time, formatted_time, time_zone);
+            ASSERT_GT(next_change_time, referenced_time);
+            if (next_change_time == std::numeric_limits<std::time_t>::max()) {
+                break;
+            }
+
+            ASSERT_EQ(formatter.Format(next_change_time - 1, formatted_time, time_zone), result) << referenced_time;
+            ASSERT_NE(formatter.Format(next_change_time, formatted_time, time_zone), result) << referenced_time;
+            referenced_time = next_change_time;
+        }
+    }
+}
+
+
+TEST(TimeZone, Load) {
+
+    auto time_zone = TimeZone::Load("America/New_York");
+    if (! time_zone.IsValid()) {
+        //The time zone database is not available.
+        return;
+    }
+
+    auto expected_time_zone = LoadNewYork();
+    for (std::time_t time = 1514764800; time < 4102444800; time += 86400 * 3 + 3607) {
+
+        std::int32_t offset = 0;
+        bool is_dst = false;
+        ASSERT_TRUE(time_zone.GetOffset(time, offset, is_dst));
+
+        std::int32_t expected_offset = 0;
+        bool expected_is_dst = false;
+        ASSERT_TRUE(expected_time_zone.GetOffset(time, expected_offset, expected_is_dst));
+
+        ASSERT_EQ(offset, expected_offset);
+        ASSERT_EQ(is_dst, expected_is_dst);
+    }
+}
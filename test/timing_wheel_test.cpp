@@ -0,0 +1,113 @@
+#include <map>
+#include <random>
+#include <gtest/gtest.h>
+#include "tiex_timing_wheel.h"
+
+using namespace tiex::internal;
+
+
+TEST(TimingWheel, Advance) {
+
+    TimingWheel timing_wheel(100);
+    timing_wheel.Schedule(1, 105);
+    timing_wheel.Schedule(2, 101);
+    timing_wheel.Schedule(3, 100);
+    timing_wheel.Schedule(4, 100 + 3600);
+
+    std::vector<TimingWheel::Id> expired_ids;
+    timing_wheel.Advance(104, expired_ids);
+    ASSERT_EQ(expired_ids, std::vector<TimingWheel::Id>({ 2, 3 }));
+    ASSERT_EQ(timing_wheel.GetCurrentTime(), 104);
+
+    expired_ids.clear();
+    timing_wheel.Advance(105, expired_ids);
+    ASSERT_EQ(expired_ids, std::vector<TimingWheel::Id>({ 1 }));
+
+    expired_ids.clear();
+    timing_wheel.Advance(100 + 3599, expired_ids);
+    ASSERT_TRUE(expired_ids.empty());
+
+    timing_wheel.Advance(100 + 3600, expired_ids);
+    ASSERT_EQ(expired_ids, std::vector<TimingWheel::Id>({ 4 }));
+
+    //Time doesn't go back.
+    timing_wheel.Advance(0, expired_ids);
+    ASSERT_EQ(timing_wheel.GetCurrentTime(), 100 + 3600);
+}
+
+
+TEST(TimingWheel, RescheduleAndCancel) {
+
+    TimingWheel timing_wheel(0);
+    timing_wheel.Schedule(1, 10);
+    timing_wheel.Schedule(2, 10);
+    timing_wheel.Schedule(1, 5000);
+    timing_wheel.Cancel(2);
+    timing_wheel.Cancel(3);
+
+    std::vector<TimingWheel::Id> expired_ids;
+    timing_wheel.Advance(4999, expired_ids);
+    ASSERT_TRUE(expired_ids.empty());
+
+    timing_wheel.Advance(5000, expired_ids);
+    ASSERT_EQ(expired_ids, std::vector<TimingWheel::Id>({ 1 }));
+}
+
+
+TEST(TimingWheel, Random) {
+
+    std::mt19937_64 random(7);
+    std::int64_t distances[] = { 10, 1000, 100000, 10000000, 1000000000, std::int64_t(1) << 40 };
+
+    std::time_t current_time = 1518098816;
+    TimingWheel timing_wheel(current_time);
+    std::map<TimingWheel::Id, std::time_t> expected_timers;
+
+    for (int round = 0; round < 2000; ++round) {
+
+        for (int index = 0; index < 5; ++index) {
+            TimingWheel::Id id = random() % 500;
+            auto distance = distances[random() % 6];
+            auto expire_time = current_time + 1 + static_cast<std::time_t>(random() % distance);
+            timing_wheel.Schedule(id, expire_time);
+            expected_timers[id] = expire_time;
+        }
+
+        if (random() % 4 == 0) {
+            TimingWheel::Id id = random() % 500;
+            timing_wheel.Cancel(id);
+            expected_timers.erase(id);
+        }
+
+        auto distance = distances[random() % 6];
+        current_time += static_cast<std::time_t>(random() % distance);
+
+        std::vector<TimingWheel::Id> expired_ids;
+        timing_wheel.Advance(current_time, expired_ids);
+
+        std::multimap<std::time_t, TimingWheel::Id> expected_expired;
+        for (auto iterator = expected_timers.begin(); iterator != expected_timers.end(); ) {
+            if (iterator->second <= current_time) {
+                expected_expired.emplace(iterator->second, iterator->first);
+                iterator = expected_timers.erase(iterator);
+            }
+            else {
+                ++iterator;
+            }
+        }
+
+        ASSERT_EQ(expired_ids.size(), expected_expired.size()) << round;
+
+        //Ids are expired in the order of expire times.
+        std::time_t previous_expire_time = 0;
+        std::map<TimingWheel::Id, std::time_t> expired_times;
+        for (const auto& each_expired : expected_expired) {
+            expired_times[each_expired.second] = each_expired.first;
+        }
+        for (auto each_id : expired_ids) {
+            ASSERT_EQ(expired_times.count(each_id), 1u) << round;
+            ASSERT_GE(expired_times[each_id], previous_expire_time) << round;
+            previous_expire_time = expired_times[each_id];
+        }
+    }
+}